@@ -15,11 +15,13 @@ class Simulator(object):
         self.eventDone = threading.Event()
         self.doxy = None
 
-    def connect(self):
+    def connect(self, binary=True):
         self.eventDone.clear()
         self.client = client.TcpClient("rpcclient", self.eventDone)
         self.client.start()
         self.eventDone.wait()
+        if binary:
+            self.client.selectBinary()
         PlatformConfig(self.client).instantiate(self)
 
     def setDoxyTracer(self, doxy):
@@ -6,15 +6,107 @@
 
 import threading
 import socket
+import struct
 import time
 from safe import safe_print
 
 TCP_IP = '127.0.0.1'
 TCP_PORT = 8687
-BUFFER_SIZE = 1024
+BUFFER_SIZE = 1 << 16
 
 TCP_DEBUG = 0
 
+# Binary frame: marker, uint32 payload length, typed payload (see
+# AttributeType::to_binary()). Text messages are zero-terminated strings.
+BIN_FRAME_MARKER = 0xB1
+BIN_HEADER_SIZE = 5
+
+try:
+    INTEGER_TYPES = (int, long)
+except NameError:
+    INTEGER_TYPES = (int,)
+
+
+def _to_str(b):
+    s = bytes(b)
+    if str is bytes:
+        return s
+    return s.decode('utf-8', 'replace')
+
+
+def _write_bytes(out, tag, b):
+    out += tag
+    out += struct.pack('<I', len(b))
+    out += b
+
+
+def encode_binary(v, out):
+    if v is None:
+        out += b'N'
+    elif isinstance(v, bool):
+        out += b'T' if v else b'F'
+    elif isinstance(v, INTEGER_TYPES):
+        if v < (1 << 63):
+            out += b'I' + struct.pack('<q', v)
+        else:
+            out += b'U' + struct.pack('<Q', v)
+    elif isinstance(v, float):
+        out += b'D' + struct.pack('<d', v)
+    elif isinstance(v, bytearray) or (str is not bytes and isinstance(v, bytes)):
+        _write_bytes(out, b'B', bytes(v))
+    elif isinstance(v, (list, tuple)):
+        out += b'L' + struct.pack('<I', len(v))
+        for item in v:
+            encode_binary(item, out)
+    elif isinstance(v, dict):
+        out += b'M' + struct.pack('<I', len(v))
+        for key in v:
+            k = key if isinstance(key, bytes) else key.encode('utf-8')
+            out += struct.pack('<I', len(k)) + k
+            encode_binary(v[key], out)
+    else:
+        s = v if isinstance(v, bytes) else str(v).encode('utf-8')
+        _write_bytes(out, b'S', s)
+    return out
+
+
+def decode_binary(buf, off):
+    """Returns decoded value and offset of the next item. Data blobs are
+    returned as bytearray."""
+    tag = chr(buf[off])
+    off += 1
+    if tag == 'N':
+        return None, off
+    if tag == 'T' or tag == 'F':
+        return tag == 'T', off
+    if tag == 'I':
+        return struct.unpack_from('<q', buf, off)[0], off + 8
+    if tag == 'U':
+        return struct.unpack_from('<Q', buf, off)[0], off + 8
+    if tag == 'D':
+        return struct.unpack_from('<d', buf, off)[0], off + 8
+    cnt = struct.unpack_from('<I', buf, off)[0]
+    off += 4
+    if tag == 'S':
+        return _to_str(buf[off:off + cnt]), off + cnt
+    if tag == 'B':
+        return bytearray(buf[off:off + cnt]), off + cnt
+    if tag == 'L':
+        ret = []
+        for i in range(cnt):
+            item, off = decode_binary(buf, off)
+            ret.append(item)
+        return ret, off
+    if tag == 'M':
+        ret = {}
+        for i in range(cnt):
+            klen = struct.unpack_from('<I', buf, off)[0]
+            key = _to_str(buf[off + 4:off + 4 + klen])
+            ret[key], off = decode_binary(buf, off + 4 + klen)
+        return ret, off
+    raise ValueError('Unexpected binary tag {0}'.format(tag))
+
+
 class TcpClient(threading.Thread):
     def __init__(self, name, eventDone):
         threading.Thread.__init__(self)
@@ -23,6 +115,7 @@ class TcpClient(threading.Thread):
         self.eventDone = eventDone
         self.messageid = 0
         self.enabled = True
+        self.binary = False
         self.eventTx = threading.Event()
         self.response = ""
         self.console_listeners = []
@@ -33,68 +126,86 @@ class TcpClient(threading.Thread):
         self.skt.connect((TCP_IP, TCP_PORT))
         self.eventDone.set()
 
-        buffer = ""
+        buffer = bytearray()
         while self.enabled:
-             rxstr = self.skt.recv(BUFFER_SIZE)
-             if rxstr == '':
-                 self.enabled = False
-                 continue
-
-             buffer += rxstr
-             if '\0' in buffer:
-                 strlist = buffer.split('\0')
-                 if buffer.endswith('\0'):
-                     buffer = ""
-                 else:
-                     buffer = strlist[len(strlist) - 1]
-                     strlist = strlist[:-1]
-
-                 for s in strlist:
-                     if len(s) == 0:
-                         continue
-                     json = s.translate(None,'\n\r\0')
-                     json = eval(json)
-                     if TCP_DEBUG == 1:
-                         safe_print("i<= {0}".format(json))
-                     if json[0] == self.messageid:
-                          self.messageid += 1
-                          self.response = None
-                          if len(json) > 1:
-                              self.response = json[1]
-                          self.eventTx.set()
-                     elif json[0] == "Console":
-                          for l in self.console_listeners:
-                              l.callback(json[1])
-                     else:
-                          raise ValueError(
-                            'Unexpected simulation response: {0}'.format(json))
-             else:
-                 pass
+            rxstr = self.skt.recv(BUFFER_SIZE)
+            if len(rxstr) == 0:
+                self.enabled = False
+                continue
+
+            buffer += rxstr
+            while len(buffer):
+                if buffer[0] == BIN_FRAME_MARKER:
+                    if len(buffer) < BIN_HEADER_SIZE:
+                        break
+                    sz = struct.unpack_from('<I', buffer, 1)[0]
+                    if len(buffer) < BIN_HEADER_SIZE + sz:
+                        break
+                    json = decode_binary(buffer, BIN_HEADER_SIZE)[0]
+                    del buffer[:BIN_HEADER_SIZE + sz]
+                else:
+                    end = buffer.find(b'\0')
+                    if end < 0:
+                        break
+                    s = bytes(buffer[:end]).translate(None, b'\n\r')
+                    del buffer[:end + 1]
+                    if len(s) == 0:
+                        continue
+                    json = eval(_to_str(s))
+                self.handleMessage(json)
 
         # Ending of the thread:
         safe_print("Thread {0} stopped".format(self.name))
 
+    def handleMessage(self, json):
+        if TCP_DEBUG == 1:
+            safe_print("i<= {0}".format(json))
+        if json[0] == self.messageid:
+            self.messageid += 1
+            self.response = None
+            if len(json) > 1:
+                self.response = json[1]
+            self.eventTx.set()
+        elif json[0] == "Console":
+            for l in self.console_listeners:
+                l.callback(json[1])
+        else:
+            raise ValueError(
+              'Unexpected simulation response: {0}'.format(json))
+
     def stop(self):
         self.enabled = False
         self.skt.shutdown(socket.SHUT_WR)
 
     def send(self, data):
         data.insert(0, self.messageid)
-        tx = bytearray(str(data))
-        tx.append(0)
+        if self.binary:
+            payload = encode_binary(data, bytearray())
+            tx = bytearray([BIN_FRAME_MARKER])
+            tx += struct.pack('<I', len(payload))
+            tx += payload
+        else:
+            tx = bytearray(str(data).encode('utf-8'))
+            tx.append(0)
         if TCP_DEBUG == 1:
-            safe_print("o=> {0}".format(tx))
+            safe_print("o=> {0}".format(data))
 
         self.eventTx.clear()
         self.response = ""
-        self.skt.send(tx)
+        self.skt.sendall(tx)
         self.eventTx.wait()
         return self.response
 
+    def selectBinary(self):
+        """Switch to binary frames if simulator supports them. Memory
+        read responses are returned as bytearray instead of tuple."""
+        if self.send(["Protocol", "Binary"]) == "OK":
+            self.binary = True
+        return self.binary
+
     def registerConsoleListener(self, listener):
         self.console_listeners.append(listener)
 
     def unregisterConsoleListener(self, listener):
         if listener in self.console_listeners:
             self.console_listeners.remove(listener)
-        
\ No newline at end of file
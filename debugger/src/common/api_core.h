@@ -29,6 +29,21 @@ namespace debugger {
 #define LOG_INFO      3
 #define LOG_DEBUG     4
 
+/**
+ * Messages above this level are removed at compile time. Release builds
+ * may override it with -DLOG_LEVEL_MAX=LOG_INFO (or lower).
+ */
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX LOG_DEBUG
+#endif
+
+/**
+ * Fallback used by the logging macros outside of IService based classes.
+ * Services hide it with IService::getLogLevel() so the level check is
+ * done inline before any argument is evaluated.
+ */
+static inline int getLogLevel() { return LOG_DEBUG; }
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -251,17 +266,22 @@ int RISCV_sscanf(const char *s, const char *fmt, ...);
     RISCV_printf(getInterface(IFACE_SERVICE), LOG_ERROR, "%s:%d " fmt, \
                  __FILE__, __LINE__, __VA_ARGS__)
 
+/** Skip the output call when the level is disabled */
+#define RISCV_printf_level(level, fmt, ...) \
+    ((level) <= LOG_LEVEL_MAX && (level) <= getLogLevel() ? \
+    RISCV_printf(getInterface(IFACE_SERVICE), level, fmt, __VA_ARGS__) : 0)
+
 /** Output with the information logging level */
 #define RISCV_important(fmt, ...) \
-    RISCV_printf(getInterface(IFACE_SERVICE), LOG_IMPORTANT, fmt, __VA_ARGS__)
+    RISCV_printf_level(LOG_IMPORTANT, fmt, __VA_ARGS__)
 
 /** Output with the information logging level */
 #define RISCV_info(fmt, ...) \
-    RISCV_printf(getInterface(IFACE_SERVICE), LOG_INFO, fmt, __VA_ARGS__)
+    RISCV_printf_level(LOG_INFO, fmt, __VA_ARGS__)
 
 /** Output with the lower logging level */
 #define RISCV_debug(fmt, ...) \
-    RISCV_printf(getInterface(IFACE_SERVICE), LOG_DEBUG, fmt, __VA_ARGS__)
+    RISCV_printf_level(LOG_DEBUG, fmt, __VA_ARGS__)
 
 /** Suspend thread on certain number of milliseconds */
 void RISCV_sleep_ms(int ms);
@@ -275,6 +295,18 @@ int RISCV_get_pid();
 /** Memory barrier */
 void RISCV_memory_barrier();
 
+/** Lock-free increment of the shared counter */
+void RISCV_atomic_inc64(volatile uint64_t *val);
+
+/** Lock-free compare and swap, returns the previous value of *dst */
+void *RISCV_atomic_cas_ptr(void * volatile *dst, void *oldval, void *newval);
+
+/** Lock-free bitwise OR, returns the previous value of *dst */
+uint32_t RISCV_atomic_or32(volatile uint32_t *dst, uint32_t val);
+
+/** Lock-free addition to the shared counter */
+void RISCV_atomic_add64(volatile uint64_t *dst, uint64_t val);
+
 void RISCV_thread_create(void *data);
 uint64_t RISCV_thread_id();
 
@@ -296,6 +328,15 @@ sharemem_def RISCV_memshare_create(const char *name, int sz);
 void* RISCV_memshare_map(sharemem_def h, int sz);
 void RISCV_memshare_unmap(void *buf, int sz);
 void RISCV_memshare_delete(sharemem_def h);
+/** Remove the name, mapped views stay valid until unmapped */
+void RISCV_memshare_remove(const char *name);
+
+/** Guest memory: address space reserved at once, host pages are committed
+    zero-filled on the first touch. File image is mapped as copy-on-write
+    pages at the beginning of the region. Returns number of mapped bytes. */
+void *RISCV_memory_reserve(uint64_t sz);
+uint64_t RISCV_memory_map_file(void *addr, uint64_t sz, const char *filename);
+void RISCV_memory_release(void *addr, uint64_t sz);
 
 /** Memory allocator/de-allocator */
 void *RISCV_malloc(uint64_t sz);
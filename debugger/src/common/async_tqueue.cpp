@@ -73,98 +73,235 @@ void AsyncTQueueType::initProc() {
 
 /** Clock queue */
 ClockAsyncTQueueType::ClockAsyncTQueueType() {
-    size_ = 1;
-    queue_ = new StepQueueItemType[size_];
-
-    RISCV_mutex_init(&mutex_);
+    size_ = 16;
+    heap_ = new HeapItemType[size_];
+    prequeue_ = 0;
+    pool_ = new StepQueueItemType[POOL_SIZE];
+    for (int i = 0; i < POOL_SIZE; i++) {
+        pool_[i].busy = 0;
+        pool_[i].pooled = true;
+    }
+    poolHint_ = 0;
+    listeners_ = new ListenerType[LISTENERS_MAX];
+    for (int i = 0; i < LISTENERS_MAX; i++) {
+        listeners_[i].iface = 0;
+        listeners_[i].queued = 0;
+    }
     hardReset();
 }
 
 ClockAsyncTQueueType::~ClockAsyncTQueueType() {
-    RISCV_mutex_destroy(&mutex_);
-    delete [] queue_;
+    hardReset();
+    delete [] heap_;
+    delete [] pool_;
+    delete [] listeners_;
 }
 
 void ClockAsyncTQueueType::hardReset() {
+    StepQueueItemType *p = prequeue_;
+    while (p && RISCV_atomic_cas_ptr(reinterpret_cast<void * volatile *>(
+                    &prequeue_), p, 0) != p) {
+        p = prequeue_;
+    }
+    while (p) {
+        StepQueueItemType *t = p->next;
+        freeItem(p);
+        p = t;
+    }
+    for (int i = 0; i < LISTENERS_MAX; i++) {
+        listeners_[i].queued = 0;
+    }
     item_total_ = 0;
-    precnt_ = 0;
-    item_cnt_ = 0;
+    seq_ = 0;
+    next_time_ = ~0ull;
 }
 
+/** Node of the pool is claimed by CAS, heap is used when pool is empty */
+ClockAsyncTQueueType::StepQueueItemType *ClockAsyncTQueueType::allocItem() {
+    unsigned hint = poolHint_;
+    for (int i = 0; i < POOL_SIZE; i++) {
+        StepQueueItemType *p = &pool_[(hint + i) % POOL_SIZE];
+        if (p->busy == 0
+            && RISCV_atomic_cas_ptr(&p->busy, 0, p) == 0) {
+            poolHint_ = hint + i + 1;
+            return p;
+        }
+    }
+    StepQueueItemType *p = new StepQueueItemType;
+    p->pooled = false;
+    return p;
+}
 
-void ClockAsyncTQueueType::put(uint64_t time, IFace *cb) {
-    RISCV_mutex_lock(&mutex_);
-    if (precnt_ >= 1024) {
-        RISCV_mutex_unlock(&mutex_);
-        RISCV_printf(0, 0, "clock pre-queue overflow: %d", precnt_);
+void ClockAsyncTQueueType::freeItem(StepQueueItemType *item) {
+    if (!item->pooled) {
+        delete item;
         return;
     }
-    prequeue_[precnt_].left = 0;
-    prequeue_[precnt_].right = 0;
-    prequeue_[precnt_].time = time;
-    prequeue_[precnt_++].iface = cb;
-    RISCV_mutex_unlock(&mutex_);
+    RISCV_memory_barrier();
+    item->busy = 0;
 }
 
-bool ClockAsyncTQueueType::move(IFace *cb, uint64_t time) {
-    RISCV_mutex_lock(&mutex_);
-    for (int i = 0; i < precnt_; i++) {
-        if (prequeue_[i].iface == cb) {
-            prequeue_[i].time = time;
-            RISCV_mutex_unlock(&mutex_);
-            return true;
+/** Returns 0 when the table is full, such listener isn't counted */
+ClockAsyncTQueueType::ListenerType *
+ClockAsyncTQueueType::getListener(IFace *cb) {
+    for (int i = 0; i < LISTENERS_MAX; i++) {
+        ListenerType *p = &listeners_[i];
+        if (p->iface == cb) {
+            return p;
         }
-    }
-    for (int i = 0; i < item_total_; i++) {
-        if (queue_[i].iface == cb) {
-            queue_[i].time = time;
-            RISCV_mutex_unlock(&mutex_);
-            return true;
+        if (p->iface == 0
+            && (RISCV_atomic_cas_ptr(reinterpret_cast<void * volatile *>(
+                    &p->iface), 0, cb) == 0 || p->iface == cb)) {
+            return p;
         }
     }
-    RISCV_mutex_unlock(&mutex_);
-    return false;
+    return 0;
+}
+
+void ClockAsyncTQueueType::pushItem(StepQueueItemType *item) {
+    StepQueueItemType *head;
+    do {
+        head = prequeue_;
+        item->next = head;
+    } while (RISCV_atomic_cas_ptr(reinterpret_cast<void * volatile *>(
+                    &prequeue_), head, item) != head);
+}
+
+void ClockAsyncTQueueType::put(uint64_t time, IFace *cb) {
+    StepQueueItemType *item = allocItem();
+    item->time = time;
+    item->iface = cb;
+    item->listener = getListener(cb);
+    item->move = false;
+    if (item->listener) {
+        RISCV_atomic_add64(&item->listener->queued, 1);
+    }
+    pushItem(item);
+}
+
+/**
+ * Queued counter includes not processed registrations, the callback that
+ * is being executed right now is already removed from it.
+ */
+bool ClockAsyncTQueueType::move(IFace *cb, uint64_t time) {
+    StepQueueItemType *item = allocItem();
+    item->time = time;
+    item->iface = cb;
+    item->listener = getListener(cb);
+    item->move = true;
+    bool ret = item->listener == 0 || item->listener->queued != 0;
+    pushItem(item);
+    return ret;
 }
 
 void ClockAsyncTQueueType::pushPreQueued() {
-    if (precnt_ == 0) {
+    StepQueueItemType *p = prequeue_;
+    if (p == 0) {
         return;
     }
-    RISCV_mutex_lock(&mutex_);
-    while ((precnt_ + item_total_) > size_) {
-        int t1 = 2*size_;
-        StepQueueItemType *p1 = new StepQueueItemType[t1];
-        memcpy(p1, queue_, item_total_*sizeof(StepQueueItemType));
-        delete [] queue_;
-        queue_ = p1;
-        size_ = t1;
-    }
-    memcpy(&queue_[item_total_], prequeue_, precnt_*sizeof(StepQueueItemType));
-    item_total_ += precnt_;
-    precnt_ = 0;
-    RISCV_mutex_unlock(&mutex_);
+    while (RISCV_atomic_cas_ptr(reinterpret_cast<void * volatile *>(
+                    &prequeue_), p, 0) != p) {
+        p = prequeue_;
+    }
+
+    // Restore registration order
+    StepQueueItemType *fifo = 0;
+    while (p) {
+        StepQueueItemType *t = p->next;
+        p->next = fifo;
+        fifo = p;
+        p = t;
+    }
+
+    while (fifo) {
+        StepQueueItemType *t = fifo->next;
+        bool moved = false;
+        if (fifo->move) {
+            for (int i = 0; i < item_total_; i++) {
+                if (heap_[i].iface != fifo->iface) {
+                    continue;
+                }
+                heap_[i].time = fifo->time;
+                heap_[i].seq = seq_++;
+                siftUp(i);
+                siftDown(i);
+                moved = true;
+                break;
+            }
+            if (!moved && fifo->listener) {
+                RISCV_atomic_add64(&fifo->listener->queued, 1);
+            }
+        }
+        if (!moved) {
+            insert(fifo->time, fifo->iface, fifo->listener);
+        }
+        freeItem(fifo);
+        fifo = t;
+    }
+    next_time_ = item_total_ ? heap_[0].time : ~0ull;
 }
 
+void ClockAsyncTQueueType::insert(uint64_t time, IFace *cb,
+                                  ListenerType *listener) {
+    if (item_total_ == size_) {
+        HeapItemType *p1 = new HeapItemType[2*size_];
+        memcpy(p1, heap_, item_total_*sizeof(HeapItemType));
+        delete [] heap_;
+        heap_ = p1;
+        size_ *= 2;
+    }
+    heap_[item_total_].time = time;
+    heap_[item_total_].seq = seq_++;
+    heap_[item_total_].iface = cb;
+    heap_[item_total_].listener = listener;
+    siftUp(item_total_++);
+}
+
+void ClockAsyncTQueueType::siftUp(int idx) {
+    while (idx > 0) {
+        int parent = (idx - 1) / 2;
+        if (!less(idx, parent)) {
+            break;
+        }
+        HeapItemType t = heap_[idx];
+        heap_[idx] = heap_[parent];
+        heap_[parent] = t;
+        idx = parent;
+    }
+}
+
+void ClockAsyncTQueueType::siftDown(int idx) {
+    while (true) {
+        int sel = idx;
+        int l = 2*idx + 1;
+        if (l < item_total_ && less(l, sel)) {
+            sel = l;
+        }
+        if (l + 1 < item_total_ && less(l + 1, sel)) {
+            sel = l + 1;
+        }
+        if (sel == idx) {
+            break;
+        }
+        HeapItemType t = heap_[idx];
+        heap_[idx] = heap_[sel];
+        heap_[sel] = t;
+        idx = sel;
+    }
+}
 
 IFace *ClockAsyncTQueueType::getNext(uint64_t step_cnt) {
     IFace *ret = 0;
-    if (item_cnt_ >= item_total_) {
+    if (item_total_ == 0 || step_cnt < heap_[0].time) {
         return ret;
     }
-    for (; item_cnt_ < item_total_; item_cnt_++) {
-        if (step_cnt < queue_[item_cnt_].time) {
-            continue;
-        }
-        ret = queue_[item_cnt_].iface;
-
-        // remove item from list using swap function to avoid usage
-        // of allocation/deallocation calls.
-        if (item_cnt_ < (item_total_ - 1)) {
-            queue_[item_cnt_] = queue_[item_total_ - 1];
-        }
-        item_total_--;
-        break;
+    ret = heap_[0].iface;
+    if (heap_[0].listener) {
+        RISCV_atomic_add64(&heap_[0].listener->queued, ~0ull);
     }
+    heap_[0] = heap_[--item_total_];
+    siftDown(0);
+    next_time_ = item_total_ ? heap_[0].time : ~0ull;
     return ret;
 }
 
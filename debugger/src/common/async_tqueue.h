@@ -51,6 +51,12 @@ class AsyncTQueueType {
 };
 
 
+/**
+ * Step callbacks ordered in a binary min-heap by time. Registrations from
+ * any thread are pushed into the lock-free pre-queue and moved into the
+ * heap by the clock owner thread, so no lock is taken on the stepping path.
+ * Pre-queue nodes are taken from the preallocated pool.
+ */
 class ClockAsyncTQueueType {
  public:
     ClockAsyncTQueueType();
@@ -66,9 +72,12 @@ class ClockAsyncTQueueType {
     void pushPreQueued();
 
     /** Reset proccessed counter at the begining of each iteration */
-    void initProc() { item_cnt_ = 0; }
+    void initProc() {}
 
-    /** move previously regsiterd callbacks: true: moved; false: not found */
+    /**
+     * Thread safe re-scheduling of the registered callback. Callback is
+     * registered if it isn't in the queue and false is returned.
+     */
     bool move(IFace *cb, uint64_t time);
 
     /**
@@ -76,22 +85,58 @@ class ClockAsyncTQueueType {
      */
     IFace *getNext(uint64_t step_cnt);
 
+    /** Nothing to do on this step: skip pushPreQueued()/getNext() */
+    bool isPending(uint64_t step_cnt) {
+        return step_cnt >= next_time_ || prequeue_ != 0;
+    }
+
  private:
+    static const int POOL_SIZE = 256;
+    static const int LISTENERS_MAX = 256;
+
+    /** Number of queued callbacks of the listener, entries aren't removed */
+    struct ListenerType {
+        IFace * volatile iface;
+        volatile uint64_t queued;
+    };
     struct StepQueueItemType {
-        StepQueueItemType *left;
-        StepQueueItemType *right;
+        StepQueueItemType *next;
+        void * volatile busy;       // pool node is owned when non-zero
+        bool pooled;
         uint64_t time;
         IFace *iface;
+        ListenerType *listener;
+        bool move;
     };
-    StepQueueItemType *queue_;
+    struct HeapItemType {
+        uint64_t time;
+        uint64_t seq;       // keeps registration order on equal time
+        IFace *iface;
+        ListenerType *listener;
+    };
+
+    StepQueueItemType *allocItem();
+    void freeItem(StepQueueItemType *item);
+    ListenerType *getListener(IFace *cb);
+    void pushItem(StepQueueItemType *item);
+    void insert(uint64_t time, IFace *cb, ListenerType *listener);
+    void siftUp(int idx);
+    void siftDown(int idx);
+    bool less(int a, int b) {
+        return heap_[a].time < heap_[b].time
+            || (heap_[a].time == heap_[b].time && heap_[a].seq < heap_[b].seq);
+    }
+
+    HeapItemType *heap_;
     int size_;
     int item_total_;
-    int item_cnt_;
-
-    int precnt_;
-    StepQueueItemType prequeue_[1024];
+    uint64_t seq_;
+    uint64_t next_time_;    // time of the heap top or ~0 if empty
 
-    mutex_def mutex_;
+    StepQueueItemType * volatile prequeue_;     // LIFO list
+    StepQueueItemType *pool_;
+    unsigned poolHint_;                         // approximate, no lock
+    ListenerType *listeners_;
 };
 
 
@@ -28,6 +28,9 @@ static AttributeType NilAttribute;
 
 void attribute_to_string(const AttributeType *attr, AutoBuffer *buf);
 int string_to_attribute(const char *cfg, int &off, AttributeType *out);
+void attribute_to_binary(const AttributeType *attr, AutoBuffer *buf);
+int binary_to_attribute(const uint8_t *buf, int sz, int &off,
+                        AttributeType *out);
 
 void AttributeType::allocAttrName(const char *name) {
     size_t len = strlen(name) + 1;
@@ -504,11 +507,10 @@ void attribute_to_string(const AttributeType *attr, AutoBuffer *buf) {
             buf->write_string("False");
         }
     } else if (attr->is_list()) {
-        AttributeType list_item;
         unsigned list_sz = attr->size();
         buf->write_string('[');
         for (unsigned i = 0; i < list_sz; i++) {
-            list_item = (*attr)[i];
+            const AttributeType &list_item = (*attr)[i];
             attribute_to_string(&list_item, buf);
             if (i < (list_sz - 1)) {
                 buf->write_string(',');
@@ -563,6 +565,219 @@ void attribute_to_string(const AttributeType *attr, AutoBuffer *buf) {
     }
 }
 
+void AttributeType::to_binary(AutoBuffer *buf) const {
+    attribute_to_binary(this, buf);
+}
+
+int AttributeType::from_binary(const uint8_t *buf, int sz) {
+    int off = 0;
+    if (binary_to_attribute(buf, sz, off, this)) {
+        return -1;
+    }
+    return off;
+}
+
+/**
+ * Binary format: tag symbol followed by the little-endian value
+ *      'N' None, 'T' True, 'F' False,
+ *      'I' int64, 'U' uint64, 'D' double,
+ *      'S' string, 'B' data: uint32 length and raw bytes,
+ *      'L' list: uint32 items number and items,
+ *      'M' dict: uint32 pairs number and pairs of string key without tag
+ *          and value.
+ * Interfaces are encoded as dictionary the same way as in text format.
+ */
+static void write_binary_uint(AutoBuffer *buf, uint64_t v, int bytes) {
+    char tmp[8];
+    for (int i = 0; i < bytes; i++) {
+        tmp[i] = static_cast<char>(v >> (8*i));
+    }
+    buf->write_bin(tmp, bytes);
+}
+
+static void write_binary_bytes(AutoBuffer *buf, const void *p, unsigned sz) {
+    write_binary_uint(buf, sz, 4);
+    buf->write_bin(static_cast<const char *>(p), static_cast<int>(sz));
+}
+
+void attribute_to_binary(const AttributeType *attr, AutoBuffer *buf) {
+    if (attr->is_nil()) {
+        buf->write_string('N');
+    } else if (attr->is_int64()) {
+        buf->write_string('I');
+        write_binary_uint(buf, attr->to_uint64(), 8);
+    } else if (attr->is_uint64()) {
+        buf->write_string('U');
+        write_binary_uint(buf, attr->to_uint64(), 8);
+    } else if (attr->is_string()) {
+        buf->write_string('S');
+        write_binary_bytes(buf, attr->to_string(), attr->size());
+    } else if (attr->is_bool()) {
+        buf->write_string(attr->to_bool() ? 'T' : 'F');
+    } else if (attr->is_list()) {
+        buf->write_string('L');
+        write_binary_uint(buf, attr->size(), 4);
+        for (unsigned i = 0; i < attr->size(); i++) {
+            attribute_to_binary(&(*attr)[i], buf);
+        }
+    } else if (attr->is_dict()) {
+        buf->write_string('M');
+        write_binary_uint(buf, attr->size(), 4);
+        for (unsigned i = 0; i < attr->size(); i++) {
+            const AttributeType *key = attr->dict_key(i);
+            write_binary_bytes(buf, key->to_string(), key->size());
+            attribute_to_binary(attr->dict_value(i), buf);
+        }
+    } else if (attr->is_data()) {
+        buf->write_string('B');
+        write_binary_bytes(buf, attr->data(), attr->size());
+    } else if (attr->is_iface()) {
+        IFace *iface = attr->to_iface();
+        if (strcmp(iface->getFaceName(), IFACE_SERVICE) == 0) {
+            AttributeType t1;
+            t1.make_dict();
+            t1["Type"].make_string(iface->getFaceName());
+            t1["ModuleName"].make_string(
+                static_cast<IService *>(iface)->getObjName());
+            attribute_to_binary(&t1, buf);
+        } else {
+            RISCV_printf(NULL, LOG_ERROR,
+                        "Not implemented interface to dict. method");
+            buf->write_string('N');
+        }
+    } else if (attr->is_floating()) {
+        union {
+            double d;
+            uint64_t u;
+        } t1;
+        t1.d = attr->to_float();
+        buf->write_string('D');
+        write_binary_uint(buf, t1.u, 8);
+    } else {
+        buf->write_string('N');
+    }
+}
+
+static uint64_t read_binary_uint(const uint8_t *buf, int bytes) {
+    uint64_t ret = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        ret = (ret << 8) | buf[i];
+    }
+    return ret;
+}
+
+/** String isn't zero-terminated in binary format */
+static void make_binary_string(AttributeType *out, const uint8_t *p,
+                               unsigned len) {
+    out->attr_free();
+    out->kind_ = Attr_String;
+    out->size_ = len;
+    out->u_.string = static_cast<char *>(RISCV_malloc(len + 1));
+    memcpy(out->u_.string, p, len);
+    out->u_.string[len] = '\0';
+}
+
+int binary_to_attribute(const uint8_t *buf, int sz, int &off,
+                        AttributeType *out) {
+    uint64_t len;
+    if (off >= sz) {
+        RISCV_printf(NULL, LOG_ERROR, "Binary parser error: Unexpected end");
+        return -1;
+    }
+    uint8_t tag = buf[off++];
+    switch (tag) {
+    case 'N':
+        out->make_nil();
+        return 0;
+    case 'T':
+    case 'F':
+        out->make_boolean(tag == 'T');
+        return 0;
+    default:;
+    }
+
+    len = (tag == 'I' || tag == 'U' || tag == 'D') ? 8 : 4;
+    if (off + static_cast<int>(len) > sz) {
+        RISCV_printf(NULL, LOG_ERROR, "Binary parser error: Unexpected end");
+        return -1;
+    }
+    uint64_t val = read_binary_uint(&buf[off], static_cast<int>(len));
+    off += static_cast<int>(len);
+
+    switch (tag) {
+    case 'I':
+        out->make_int64(static_cast<int64_t>(val));
+        return 0;
+    case 'U':
+        out->make_uint64(val);
+        return 0;
+    case 'D': {
+        union {
+            double d;
+            uint64_t u;
+        } t1;
+        t1.u = val;
+        out->make_floating(t1.d);
+        return 0;
+    }
+    case 'S':
+    case 'B':
+        if (val > static_cast<uint64_t>(sz - off)) {
+            break;
+        }
+        if (tag == 'B') {
+            out->make_data(static_cast<unsigned>(val), &buf[off]);
+        } else {
+            make_binary_string(out, &buf[off], static_cast<unsigned>(val));
+        }
+        off += static_cast<int>(val);
+        return 0;
+    case 'L':
+        if (val > static_cast<uint64_t>(sz - off)) {
+            break;
+        }
+        out->make_list(static_cast<unsigned>(val));
+        for (unsigned i = 0; i < out->size(); i++) {
+            if (binary_to_attribute(buf, sz, off, &(*out)[i])) {
+                out->attr_free();
+                return -1;
+            }
+        }
+        return 0;
+    case 'M': {
+        AttributeType key;
+        out->make_dict();
+        for (uint64_t i = 0; i < val; i++) {
+            if (off + 4 > sz) {
+                out->attr_free();
+                return -1;
+            }
+            len = read_binary_uint(&buf[off], 4);
+            off += 4;
+            if (len > static_cast<uint64_t>(sz - off)) {
+                out->attr_free();
+                return -1;
+            }
+            make_binary_string(&key, &buf[off], static_cast<unsigned>(len));
+            off += static_cast<int>(len);
+            if (binary_to_attribute(buf, sz, off,
+                                    &(*out)[key.to_string()])) {
+                out->attr_free();
+                return -1;
+            }
+        }
+        return 0;
+    }
+    default:
+        RISCV_printf(NULL, LOG_ERROR,
+                    "Binary parser error: Unknown tag %02x", tag);
+        return -1;
+    }
+    RISCV_printf(NULL, LOG_ERROR, "Binary parser error: Wrong length");
+    out->attr_free();
+    return -1;
+}
+
 int skip_special_symbols(const char *cfg, int off) {
     const char *pcur = &cfg[off];
     while (*pcur == ' ' || *pcur == '\r' || *pcur == '\n' || *pcur == '\t') {
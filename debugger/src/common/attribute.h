@@ -39,6 +39,7 @@ enum KindType {
 };
 
 class AttributePairType;
+class AutoBuffer;
 
 class AttributeType : public IAttribute {
  public:
@@ -346,6 +347,13 @@ class AttributeType : public IAttribute {
 
     const AttributeType& to_config();
     void from_config(const char *str);
+
+    /**
+     * @brief Typed binary encoding with raw data blobs.
+     * @return from_binary() returns number of parsed bytes or -1.
+     */
+    void to_binary(AutoBuffer *buf) const;
+    int from_binary(const uint8_t *buf, int sz);
 };
 
 class AttributePairType {
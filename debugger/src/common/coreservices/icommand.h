@@ -56,67 +56,59 @@ class ICommand : public IFace {
     }
 
  protected:
-    // Non-blocking access to the selected bus from the command execution thread
+    // Non-blocking access to the selected bus from the command execution
+    // thread. Block longer than one beat is sent as a single burst.
     virtual ETransStatus dma_read(uint64_t addr, uint32_t sz, uint8_t *payload) {
         ETransStatus ret = TRANS_ERROR;
-        if (!ibus_) {
+        if (!ibus_ || sz == 0) {
             return ret;
         }
         Axi4TransactionType tr;
         tr.action = MemAction_Read;
         tr.addr = addr;
-        uint32_t bytecnt = 0;
-        while (bytecnt < sz) {
-            if ((sz - bytecnt) > 8) {
-                tr.xsize = 8;
-            } else {
-                tr.xsize = sz - bytecnt;
-            }
-            nbobj_.clear();
-            ret = ibus_->nb_transport(&tr,
-                                      static_cast<IAxi4NbResponse *>(&nbobj_));
-            nbobj_.wait();
+        tr.xsize = sz;
+        tr.wstrb = 0;
+        setBurst(&tr, payload);
+        nbobj_.clear();
+        ret = ibus_->nb_transport(&tr,
+                                  static_cast<IAxi4NbResponse *>(&nbobj_));
+        nbobj_.wait();
+        if (!tr.is_burst()) {
             memcpy(payload, nbobj_.rpayload(), tr.xsize);
-            if (ret != TRANS_OK) {
-                break;
-            }
-            bytecnt += tr.xsize;
-            payload += tr.xsize;
-            tr.addr += tr.xsize;
         }
         return ret;
     }
     virtual ETransStatus dma_write(uint64_t addr, uint32_t sz, uint8_t *payload) {
         ETransStatus ret = TRANS_ERROR;
-        if (!ibus_) {
+        if (!ibus_ || sz == 0) {
             return ret;
         }
         Axi4TransactionType tr;
         tr.action = MemAction_Write;
         tr.addr = addr;
-        uint32_t bytecnt = 0;
-        while (bytecnt < sz) {
-            if ((sz - bytecnt) > 8) {
-                tr.xsize = 8;
-            } else {
-                tr.xsize = sz - bytecnt;
-            }
+        tr.xsize = sz;
+        if (!setBurst(&tr, payload)) {
             tr.wstrb = (1u << tr.xsize) - 1;
             memcpy(tr.wpayload.b8, payload, tr.xsize);
-            nbobj_.clear();
-            ret = ibus_->nb_transport(&tr,
-                                      static_cast<IAxi4NbResponse *>(&nbobj_));
-            nbobj_.wait();
-            if (ret != TRANS_OK) {
-                break;
-            }
-            bytecnt += tr.xsize;
-            payload += tr.xsize;
-            tr.addr += tr.xsize;
         }
+        nbobj_.clear();
+        ret = ibus_->nb_transport(&tr,
+                                  static_cast<IAxi4NbResponse *>(&nbobj_));
+        nbobj_.wait();
         return ret;
     }
 
+ private:
+    bool setBurst(Axi4TransactionType *tr, uint8_t *payload) {
+        if (!tr->is_burst()) {
+            return false;
+        }
+        tr->burst = Burst_Incr;
+        tr->bsize = PAYLOAD_MAX_BYTES;
+        tr->bpayload = payload;
+        return true;
+    }
+
  protected:
     AttributeType cmdName_;
     AttributeType briefDescr_;
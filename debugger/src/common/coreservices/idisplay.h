@@ -24,6 +24,31 @@
 
 namespace debugger {
 
+/** Modified regions are tracked by square tiles numbered by columns */
+static const int DISPLAY_TILE_SIZE = 16;
+
+/**
+ * Frame surface shared between display model and GUI. Model copies
+ * modified tiles into the back buffer and swaps it with the front buffer
+ * on each 'frame surface' request. Pixels are stored by columns the same
+ * way as in 'frame' response.
+ */
+struct DisplaySurfaceType {
+    uint32_t width;
+    uint32_t height;
+    volatile uint32_t front;    // buffer index available for reading
+    uint32_t reserved;
+    uint32_t pixels[1];         // 2 buffers of width * height words
+
+    static int getSize(int w, int h) {
+        return static_cast<int>(sizeof(DisplaySurfaceType))
+             + (2 * w * h - 1) * static_cast<int>(sizeof(uint32_t));
+    }
+    uint32_t *buffer(uint32_t idx) {
+        return &pixels[idx * width * height];
+    }
+};
+
 class GenericDisplayCmdType : public ICommand {
  public:
     GenericDisplayCmdType(IService *parent, uint64_t dmibar, const char *name)
@@ -35,16 +60,20 @@ class GenericDisplayCmdType : public ICommand {
             "    Read display resolution using config command\n"
             "    or frame using 'frame' subcommand.\n"
             "    Additional option 'encoded' allows reduce frame buffer\n"
-            "    size.\n"
+            "    size. Option 'surface' publishes frame into the shared\n"
+            "    memory surface if the display supports it.\n"
             "Response config:\n"
-            "    List {Width:w,Height:h,BkgColor:0x00ff00}\n"
+            "    List {Width:w,Height:h,BkgColor:0x00ff00,Surface:name}\n"
             "Response 'frame':\n"
             "    List [b0,b1,b1,...],\n"
             "          Bytes of column0,column1,etcn"
+            "Response 'frame surface':\n"
+            "    List of modified tiles indexes [t0,t1,...]\n"
             "Usage:\n"
             "    display0 config\n"
             "    display0 frame\n"
-            "    display0 frame encoded");
+            "    display0 frame encoded\n"
+            "    display0 frame surface");
     }
 
     /** ICommand */
@@ -64,7 +93,12 @@ class GenericDisplayCmdType : public ICommand {
             (*res)["Width"].make_int64(getWidth());
             (*res)["Height"].make_int64(getHeight());
             (*res)["BkgColor"].make_uint64(getBkgColor());
+            (*res)["Surface"].make_string(getSurfaceName());
         } else if (type.is_equal("frame")) {
+            if (args->size() > 2 && (*args)[2].is_equal("surface")) {
+                publishFrame(res);
+                return;
+            }
             bool diff = false;
             if (args->size() > 2 && (*args)[2].is_equal("diff")) {
                 diff = true;
@@ -81,6 +115,8 @@ class GenericDisplayCmdType : public ICommand {
     virtual int getHeight() = 0;
     virtual uint32_t getBkgColor() = 0;     // distance between pixels
     virtual void getFrame(AttributeType *res, bool diff) = 0;
+    virtual const char *getSurfaceName() { return ""; }
+    virtual void publishFrame(AttributeType *res) { res->make_list(0); }
     virtual void encode(AttributeType *frame) {
         if (!frame->is_data()) {
             return;
@@ -68,6 +68,8 @@ class IDmi : public IFace {
     virtual bool isAutoexecProgbuf(int idx) = 0;
     virtual void executeProgbuf() = 0;
     virtual bool isCommandBusy() = 0;
+    // Index 0 is the total number of registers in snapshot
+    virtual uint64_t readRegSnapshot(int idx) = 0;
 
     virtual bool isSbaBusy() = 0;
 };
@@ -46,6 +46,8 @@ class IDPort : public IFace {
 #endif
     virtual bool executeProgbuf(uint32_t *progbuf) = 0;
     virtual bool isExecutingProgbuf() = 0;
+    // Changed on each halt and on each register write from debugger side
+    virtual uint64_t getDebugEpoch() = 0;
     virtual void setResetPin(bool val) = 0;
 };
 
@@ -0,0 +1,75 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef __DEBUGGER_COMMON_CORESERVICES_IHARTSCHED_H__
+#define __DEBUGGER_COMMON_CORESERVICES_IHARTSCHED_H__
+
+#include <inttypes.h>
+#include <iface.h>
+
+namespace debugger {
+
+static const char *const IFACE_SCHEDULED_HART = "IScheduledHart";
+
+class IScheduledHart : public IFace {
+ public:
+    IScheduledHart() : IFace(IFACE_SCHEDULED_HART) {}
+
+    /**
+     * Execute 'steps' instructions (or idle iterations if the hart doesn't
+     * run) in the caller thread.
+     */
+    virtual void runQuantum(uint64_t steps) = 0;
+};
+
+
+static const char *const IFACE_HART_SCHEDULER = "IHartScheduler";
+
+/**
+ * Harts are executed in time quanta with synchronization on quantum
+ * boundaries: each hart in its own thread (parallel mode) or all harts in
+ * the single scheduler thread one after another (round-robin mode).
+ */
+class IHartScheduler : public IFace {
+ public:
+    IHartScheduler() : IFace(IFACE_HART_SCHEDULER) {}
+
+    /** Returns slot index used in other methods */
+    virtual int registerHart(IScheduledHart *ihart) = 0;
+    virtual void unregisterHart(int slot) = 0;
+
+    /** Hart shouldn't create own thread in round-robin mode */
+    virtual bool isRoundRobin() = 0;
+    virtual uint64_t getQuantum() = 0;
+    /** Global simulated time: number of steps in completed quanta */
+    virtual uint64_t getGlobalStep() = 0;
+    /** Parallel mode: block until all harts finished current quantum */
+    virtual void quantumBarrier(int slot) = 0;
+
+    /** LR/SC and AMO instructions of all harts are serialized */
+    virtual void lockAtomic() = 0;
+    virtual void unlockAtomic() = 0;
+    virtual void reserveAddr(int slot, uint64_t addr) = 0;
+    /** Check reservation of SC instruction. Success cancels reservations of
+        other harts on the same address */
+    virtual bool releaseAddr(int slot, uint64_t addr) = 0;
+    /** AMO write cancels reservations of other harts */
+    virtual void storeAddr(int slot, uint64_t addr) = 0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_COMMON_CORESERVICES_IHARTSCHED_H__
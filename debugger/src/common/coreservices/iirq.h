@@ -22,6 +22,7 @@
 namespace debugger {
 
 static const char *const IFACE_IRQ_CONTROLLER = "IIrqController";
+static const char *const IFACE_IRQ_LISTENER = "IIrqListener";
 
 static const int IRQ_REQUEST_NONE = 0;
 
@@ -38,6 +39,17 @@ static const int IRQ_REQUEST_NONE = 0;
 //   HART1_TIMER_IRQ = 3
 //   etc
 
+/**
+ * Receiver of the interrupt request levels (CPU side). Controller calls it
+ * each time when the request level of the subscribed context may change.
+ */
+class IIrqListener : public IFace {
+ public:
+    IIrqListener() : IFace(IFACE_IRQ_LISTENER) {}
+
+    virtual void setIrqLine(int line, bool level) = 0;
+};
+
 class IIrqController : public IFace {
  public:
     IIrqController() : IFace(IFACE_IRQ_CONTROLLER) {}
@@ -49,6 +61,14 @@ class IIrqController : public IFace {
     // prioiry and enabled for context. Called by CPU.
     // @ret IRQ_REQUEST_NONE if no requests
     virtual int getPendingRequest(int ctxid) = 0;
+
+    // Subscribe on the context request level instead of polling
+    // getPendingRequest() on each step. Listener receives 'line' index.
+    // @ret false if controller doesn't support notifications
+    virtual bool registerIrqListener(int ctxid, IIrqListener *ilstn,
+                                     int line) {
+        return false;
+    }
 };
 
 }  // namespace debugger
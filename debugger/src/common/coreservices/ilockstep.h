@@ -0,0 +1,80 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef __DEBUGGER_COMMON_CORESERVICES_ILOCKSTEP_H__
+#define __DEBUGGER_COMMON_CORESERVICES_ILOCKSTEP_H__
+
+#include <inttypes.h>
+#include <iface.h>
+
+namespace debugger {
+
+static const int LOCKSTEP_ACTIONS_MAX = 8;
+
+enum ELockstepActionType {
+    LockstepAction_Reg,
+    LockstepAction_Load,
+    LockstepAction_Store
+};
+
+/** Architectural side effect of the retired instruction */
+struct LockstepActionType {
+    uint8_t type;           // ELockstepActionType
+    uint8_t size;           // memory access size in bytes
+    uint16_t regidx;        // integer registers then FPU registers
+    uint64_t addr;
+    uint64_t data;          // memory data are masked by size
+};
+
+struct LockstepCommitType {
+    uint64_t cnt;           // model's own counter, used in the report only
+    uint64_t pc;
+    uint32_t instr;
+    int actioncnt;
+    LockstepActionType action[LOCKSTEP_ACTIONS_MAX];
+};
+
+
+static const char *const IFACE_LOCKSTEP_CHECKER = "ILockstepChecker";
+
+class ILockstepChecker : public IFace {
+ public:
+    ILockstepChecker() : IFace(IFACE_LOCKSTEP_CHECKER) {}
+
+    /**
+     * Called by the checked model in its own thread for each retired
+     * instruction in program order. Blocks while the checker is behind.
+     */
+    virtual void commitInstruction(const LockstepCommitType *c) = 0;
+};
+
+
+static const char *const IFACE_LOCKSTEP_HART = "ILockstepHart";
+
+class ILockstepHart : public IFace {
+ public:
+    ILockstepHart() : IFace(IFACE_LOCKSTEP_HART) {}
+
+    /**
+     * Execute one instruction in the caller thread and report its side
+     * effects. Returns false if no instruction was retired (halted hart).
+     */
+    virtual bool stepCommit(LockstepCommitType *c) = 0;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_COMMON_CORESERVICES_ILOCKSTEP_H__
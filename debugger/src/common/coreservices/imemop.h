@@ -18,6 +18,8 @@
 #define __DEBUGGER_IMEMOP_PLUGIN_H__
 
 #include <inttypes.h>
+#include <string.h>
+#include <api_core.h>
 #include <iface.h>
 #include <attribute.h>
 
@@ -47,6 +49,12 @@ enum ETransStatus {
     TRANS_ERROR
 };
 
+enum EAxi4Burst {
+    Burst_Fixed,
+    Burst_Incr,
+    Burst_Wrap      // xsize must be power of 2
+};
+
 typedef struct Axi4TransactionType {
     EAxi4Action action;
     EAxi4Response response;
@@ -60,6 +68,17 @@ typedef struct Axi4TransactionType {
         uint64_t b64[PAYLOAD_MAX_BYTES/sizeof(uint64_t)];
     } rpayload, wpayload;
     int source_idx;             // Need for bus utilization statistic
+    /**
+     * Burst transaction is used when xsize > PAYLOAD_MAX_BYTES. In this case
+     * xsize is the total length, data are read into/written from the
+     * external buffer bpayload and wstrb isn't used. Fields aren't
+     * initialized by single-beat masters so check is_burst() first.
+     */
+    EAxi4Burst burst;
+    uint32_t bsize;             // [Bytes] beat size <= PAYLOAD_MAX_BYTES
+    uint8_t *bpayload;
+
+    bool is_burst() const { return xsize > PAYLOAD_MAX_BYTES; }
 } Axi4TransactionType;
 
 /**
@@ -125,6 +144,123 @@ class IMemoryOperation : public IFace {
     virtual int getPriority() { return priority_.to_int(); }
     virtual void setPriority(int v) { priority_.make_int64(v); }
 
+    /**
+     * Device accessed concurrently by several masters without the bus lock
+     * has to return false. Such device must protect its own state.
+     */
+    virtual bool isSerialized() { return true; }
+
+    /**
+     * Device that accepts burst transactions (see Axi4TransactionType) in
+     * b_transport/nb_transport. Other devices receive bursts split into
+     * single beats by splitBurst().
+     */
+    virtual bool isBurstSupported() { return false; }
+
+    /** Convert burst transaction into the sequence of single beats */
+    ETransStatus splitBurst(Axi4TransactionType *trans) {
+        ETransStatus ret = TRANS_OK;
+        Axi4TransactionType tr = *trans;
+        trans->response = MemResp_Valid;
+        for (uint32_t off = 0; off < trans->xsize; off += tr.xsize) {
+            burstBeat(trans, off, &tr);
+            if (b_transport(&tr) != TRANS_OK) {
+                ret = TRANS_ERROR;
+            }
+            if (tr.response == MemResp_Error) {
+                trans->response = MemResp_Error;
+            }
+            if (trans->action == MemAction_Read) {
+                memcpy(&trans->bpayload[off], tr.rpayload.b8, tr.xsize);
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * Non-blocking variant of splitBurst() for devices without blocking
+     * access (SystemC models, debug port). Each beat waits its response
+     * before the next one, master is notified after the last beat.
+     */
+    ETransStatus splitBurstNb(Axi4TransactionType *trans,
+                              IAxi4NbResponse *cb) {
+        ETransStatus ret = TRANS_OK;
+        BeatResponseType beatcb;
+        Axi4TransactionType tr = *trans;
+        trans->response = MemResp_Valid;
+        for (uint32_t off = 0; off < trans->xsize; off += tr.xsize) {
+            burstBeat(trans, off, &tr);
+            RISCV_event_clear(&beatcb.event);
+            if (nb_transport(&tr, &beatcb) != TRANS_OK) {
+                ret = TRANS_ERROR;
+            }
+            RISCV_event_wait(&beatcb.event);
+            if (beatcb.resp.response == MemResp_Error) {
+                trans->response = MemResp_Error;
+            }
+            if (trans->action == MemAction_Read) {
+                memcpy(&trans->bpayload[off], beatcb.resp.rpayload.b8,
+                       tr.xsize);
+            }
+        }
+        cb->nb_response(trans);
+        return ret;
+    }
+
+    /**
+     * Direct memory interface: host pointer on the range [addr, addr + sz)
+     * that can be accessed bypassing b_transport, or 0 if the range has
+     * to be accessed with transactions (MMIO, read-only, DPI routed etc).
+     */
+    virtual uint8_t *getDirectPointer(uint64_t addr, uint64_t sz,
+                                      EAxi4Action action) {
+        return 0;
+    }
+
+ private:
+    /** Single beat at the offset 'off' of the burst */
+    void burstBeat(const Axi4TransactionType *trans, uint32_t off,
+                   Axi4TransactionType *tr) {
+        uint32_t bsize = trans->bsize;
+        uint64_t wrapmask = static_cast<uint64_t>(trans->xsize) - 1;
+        if (bsize == 0 || bsize > PAYLOAD_MAX_BYTES) {
+            bsize = PAYLOAD_MAX_BYTES;
+        }
+        tr->xsize = trans->xsize - off;
+        if (tr->xsize > bsize) {
+            tr->xsize = bsize;
+        }
+        if (trans->burst == Burst_Fixed) {
+            tr->addr = trans->addr;
+        } else if (trans->burst == Burst_Wrap) {
+            tr->addr = (trans->addr & ~wrapmask)
+                     | ((trans->addr + off) & wrapmask);
+        } else {
+            tr->addr = trans->addr + off;
+        }
+        tr->wstrb = (1u << tr->xsize) - 1;
+        tr->response = MemResp_Valid;
+        if (trans->action == MemAction_Write) {
+            memcpy(tr->wpayload.b8, &trans->bpayload[off], tr->xsize);
+        }
+    }
+
+    class BeatResponseType : public IAxi4NbResponse {
+     public:
+        BeatResponseType() : IAxi4NbResponse() {
+            RISCV_event_create(&event, "burst_beat");
+        }
+        virtual ~BeatResponseType() {
+            RISCV_event_close(&event);
+        }
+        virtual void nb_response(Axi4TransactionType *trans) {
+            resp = *trans;
+            RISCV_event_set(&event);
+        }
+        event_def event;
+        Axi4TransactionType resp;
+    };
+
  protected:
     friend class IService;
     AttributeType listMap_;
@@ -37,10 +37,12 @@ class IThread : public IFace {
     virtual bool run() {
         threadInit_.func = reinterpret_cast<lib_thread_func>(runThread);
         threadInit_.args = this;
+        // Enable loop before the thread starts to check it
+        RISCV_event_set(&loopEnable_);
         RISCV_thread_create(&threadInit_);
 
-        if (threadInit_.Handle) {
-            RISCV_event_set(&loopEnable_);
+        if (!threadInit_.Handle) {
+            RISCV_event_clear(&loopEnable_);
         }
         return loopEnable_.state;
     }
@@ -57,6 +57,23 @@ void DATABUF_TYPE::write(int idx, uint32_t val) {
     return;
 }
 
+IDmi *REGSNAPSHOT_TYPE::getpIDmi() {
+    if (!idmi_) {
+        idmi_ = static_cast<IDmi *>(parent_->getInterface(IFACE_DMI));
+    }
+    return idmi_;
+}
+
+Reg64Type REGSNAPSHOT_TYPE::read(int idx) {
+    IDmi *p = getpIDmi();
+    if (!p) {
+        return GenericReg64Bank::read(idx);
+    }
+    Reg64Type ret;
+    ret.val = p->readRegSnapshot(idx);
+    return ret;
+}
+
 uint32_t PROGBUF_TYPE::read(int idx) {
     uint32_t ret = GenericReg32Bank::read(idx);
     IDmi *p = getpIDmi();
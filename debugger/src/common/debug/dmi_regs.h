@@ -65,6 +65,26 @@ class PROGBUF_TYPE : public DmiRegisterBankType {
     virtual void write(int idx, uint32_t val) override;
 };
 
+/**
+ * Non-standard read-only bank: all debug registers of the selected hart
+ * in one contiguous block to read them with a single burst.
+ */
+class REGSNAPSHOT_TYPE : public GenericReg64Bank {
+ public:
+    REGSNAPSHOT_TYPE(IService *parent, const char *name, uint64_t addr) :
+        GenericReg64Bank(parent, name, addr, 1), idmi_(0) {}
+
+    virtual Reg64Type read(int idx) override;
+    virtual void write(int idx, Reg64Type val) override {}
+    virtual void write(int idx, uint64_t val) override {}
+
+ protected:
+    IDmi* getpIDmi();
+
+ protected:
+    IDmi* idmi_;
+};
+
 class DMCONTROL_TYPE : public DebugRegisterType {
  public:
     DMCONTROL_TYPE(IService *parent, const char *name, uint64_t addr) :
@@ -32,21 +32,14 @@ BusGeneric::BusGeneric(const char *name) : IService(name),
     RISCV_mutex_init(&mutexNBAccess_);
     RISCV_register_hap(static_cast<IHap *>(this));
     busUtil_.setPriority(10);     // Overmap DSU registers
-    imaphash_ = 0;
-
-    memset(imemtbl_, 0, sizeof(imemtbl_));
-    for (int i = 0; i < HASH_TBL_SIZE; i++) {
-        imemtbl_[i].devlist.make_list(0);
-    }
+    route_ = 0;
     addrWidth_.make_int64(39);      // 39-bits address width for FU740
 }
 
 BusGeneric::~BusGeneric() {
     RISCV_mutex_destroy(&mutexBAccess_);
     RISCV_mutex_destroy(&mutexNBAccess_);
-    if (imaphash_) {
-        delete [] imaphash_;
-    }
+    deleteRouteTable(route_);
 }
 
 void BusGeneric::postinitService() {
@@ -54,7 +47,11 @@ void BusGeneric::postinitService() {
     HASH_MASK_ = (1ull << HASH_ADDR_WIDTH) - 1;
 
     HASH_LVL1_OFFSET_ = addrWidth_.to_int() - HASH_ADDR_WIDTH;
-    HASH_LVL2_OFFSET_ = addrWidth_.to_int() - 2*HASH_ADDR_WIDTH;
+    PAGE_OFFSET_ = PAGE_ADDR_WIDTH;
+    if (HASH_LVL1_OFFSET_ < static_cast<uint64_t>(PAGE_OFFSET_)) {
+        PAGE_OFFSET_ = static_cast<int>(HASH_LVL1_OFFSET_);
+    }
+    PAGE_MASK_ = (1ull << (HASH_LVL1_OFFSET_ - PAGE_OFFSET_)) - 1;
 
     IMemoryOperation *imem;
     for (unsigned i = 0; i < listMap_.size(); i++) {
@@ -90,20 +87,24 @@ void BusGeneric::hapTriggered(EHapType type,
                               uint64_t param,
                               const char *descr) {
     RISCV_mutex_lock(&mutexNBAccess_);
-    RISCV_mutex_lock(&mutexBAccess_);
     maphash();
-    RISCV_mutex_unlock(&mutexBAccess_);
     RISCV_mutex_unlock(&mutexNBAccess_);
 }
 
 ETransStatus BusGeneric::b_transport(Axi4TransactionType *trans) {
     ETransStatus ret = TRANS_OK;
-    uint32_t sz;
+    bool serialized;
     IMemoryOperation *memdev = 0;
 
-    RISCV_mutex_lock(&mutexBAccess_);
-
-    getMapedDevice(trans, &memdev, &sz);
+    if (trans->is_burst()) {
+        memdev = getBurstDevice(trans, &serialized);
+        if (memdev == 0) {
+            // Each beat is routed and accounted separately
+            return splitBurst(trans);
+        }
+    } else {
+        getMapedDevice(trans, &memdev, &serialized);
+    }
 
     if (memdev == 0) {
         RISCV_error("Blocking request to unmapped address "
@@ -111,21 +112,19 @@ ETransStatus BusGeneric::b_transport(Axi4TransactionType *trans) {
         memset(trans->rpayload.b8, 0xFF, trans->xsize);
         ret = TRANS_ERROR;
     } else {
-        memdev->b_transport(trans);
+        if (serialized) {
+            RISCV_mutex_lock(&mutexBAccess_);
+            memdev->b_transport(trans);
+            RISCV_mutex_unlock(&mutexBAccess_);
+        } else {
+            memdev->b_transport(trans);
+        }
         RISCV_debug("[%08" RV_PRI64 "x] => [%08x %08x]",
             trans->addr,
             trans->rpayload.b32[1], trans->rpayload.b32[0]);
     }
 
-    // Update Bus utilization counters:
-    if (trans->source_idx >= 0 && trans->source_idx < 8) {
-        if (trans->action == MemAction_Read) {
-            busUtil_.getpR64()[2*trans->source_idx + 1]++;
-        } else if (trans->action == MemAction_Write) {
-            busUtil_.getpR64()[2*trans->source_idx]++;
-        }
-    }
-    RISCV_mutex_unlock(&mutexBAccess_);
+    updateUtilization(trans);
     return ret;
 }
 
@@ -133,11 +132,15 @@ ETransStatus BusGeneric::nb_transport(Axi4TransactionType *trans,
                                IAxi4NbResponse *cb) {
     ETransStatus ret = TRANS_OK;
     IMemoryOperation *memdev = 0;
-    uint32_t sz;
+    bool serialized;
+
+    if (trans->is_burst() && getBurstDevice(trans, &serialized) == 0) {
+        return splitBurstNb(trans, cb);
+    }
 
     RISCV_mutex_lock(&mutexNBAccess_);
 
-    getMapedDevice(trans, &memdev, &sz);
+    getMapedDevice(trans, &memdev, &serialized);
 
     if (memdev == 0) {
         RISCV_error("Non-blocking request from %d to unmapped address "
@@ -152,66 +155,237 @@ ETransStatus BusGeneric::nb_transport(Axi4TransactionType *trans,
                     trans->addr);
     }
 
-    // Update Bus utilization counters:
-    if (trans->source_idx >= 0 && trans->source_idx < 8) {
-        if (trans->action == MemAction_Read) {
-            busUtil_.getpR64()[2*trans->source_idx + 1]++;
-        } else if (trans->action == MemAction_Write) {
-            busUtil_.getpR64()[2*trans->source_idx]++;
+    updateUtilization(trans);
+    RISCV_mutex_unlock(&mutexNBAccess_);
+    return ret;
+}
+
+/** Forward request to the device if the whole range is routed to it */
+uint8_t *BusGeneric::getDirectPointer(uint64_t addr, uint64_t sz,
+                                      EAxi4Action action) {
+    RouteTableType *route = route_;
+    uint8_t *ret;
+    if (route == 0 || sz == 0) {
+        return 0;
+    }
+    uint64_t hashidx = (addr & ADDR_MASK_) >> HASH_LVL1_OFFSET_;
+    if (hashidx != (((addr + sz - 1) & ADDR_MASK_) >> HASH_LVL1_OFFSET_)) {
+        return 0;
+    }
+    RouteItemType *item = &route->tbl[hashidx];
+    if (item->pages) {
+        if ((addr >> PAGE_OFFSET_) != ((addr + sz - 1) >> PAGE_OFFSET_)) {
+            return 0;
         }
+        item = &item->pages[(addr >> PAGE_OFFSET_) & PAGE_MASK_];
+    }
+    if (item->idev == 0) {
+        return 0;
+    }
+    if (item->serialized) {
+        RISCV_mutex_lock(&mutexBAccess_);
+        ret = item->idev->getDirectPointer(addr, sz, action);
+        RISCV_mutex_unlock(&mutexBAccess_);
+    } else {
+        ret = item->idev->getDirectPointer(addr, sz, action);
     }
-    RISCV_mutex_unlock(&mutexNBAccess_);
     return ret;
 }
 
+void BusGeneric::updateUtilization(Axi4TransactionType *trans) {
+    if (trans->source_idx < 0 || trans->source_idx >= 8) {
+        return;
+    }
+    if (trans->action == MemAction_Read) {
+        RISCV_atomic_inc64(&busUtil_.getpR64()[2*trans->source_idx + 1]);
+    } else if (trans->action == MemAction_Write) {
+        RISCV_atomic_inc64(&busUtil_.getpR64()[2*trans->source_idx]);
+    }
+}
+
 void BusGeneric::getMapedDevice(Axi4TransactionType *trans,
-                         IMemoryOperation **pdev, uint32_t *sz) {
+                         IMemoryOperation **pdev, bool *serialized) {
     IMemoryOperation *imem;
-    uint64_t bar, barsz;
+    uint64_t bar;
+    RouteTableType *route = route_;
     *pdev = 0;
-    *sz = 0;
+    *serialized = true;
+    if (route == 0) {
+        return;
+    }
 
     uint64_t hashidx = (trans->addr & ADDR_MASK_) >> HASH_LVL1_OFFSET_;
-    HashTableItemType &item = imemtbl_[hashidx];
-    if (item.idev) {
-        *pdev = item.idev;
-    } else if (item.nxtlvlena) {
-        for (unsigned i = 0; i < item.devlist.size(); i++) {
-            imem = static_cast<IMemoryOperation *>(item.devlist[i].to_iface());
-            bar = imem->getBaseAddress();
-            barsz = imem->getLength();
-            if (bar <= trans->addr && trans->addr < (bar + barsz)) {
-                if (!(*pdev) || imem->getPriority() > (*pdev)->getPriority()) {
-                    *pdev = imem;
-                }
+    RouteItemType *item = &route->tbl[hashidx];
+    if (item->pages) {
+        item = &item->pages[(trans->addr >> PAGE_OFFSET_) & PAGE_MASK_];
+    }
+    if (item->idev) {
+        *pdev = item->idev;
+        *serialized = item->serialized;
+        return;
+    }
+    if (item->devlist == 0) {
+        return;
+    }
+    for (IMemoryOperation **p = item->devlist; *p; p++) {
+        imem = *p;
+        bar = imem->getBaseAddress();
+        if (bar <= trans->addr && trans->addr < (bar + imem->getLength())) {
+            if (!(*pdev) || imem->getPriority() > (*pdev)->getPriority()) {
+                *pdev = imem;
             }
         }
     }
+    if (*pdev) {
+        *serialized = (*pdev)->isSerialized();
+    }
+}
+
+/**
+ * Device that accepts the whole burst without splitting: incrementing burst
+ * routed to the single device along the full range, or 0.
+ */
+IMemoryOperation *BusGeneric::getBurstDevice(Axi4TransactionType *trans,
+                                             bool *serialized) {
+    RouteTableType *route = route_;
+    IMemoryOperation *ret = 0;
+    uint64_t addr = trans->addr & ADDR_MASK_;
+    uint64_t last = addr + trans->xsize - 1;
+    uint64_t next;
+    if (route == 0 || trans->burst != Burst_Incr || last > ADDR_MASK_) {
+        return 0;
+    }
+    while (addr <= last) {
+        RouteItemType *item = &route->tbl[addr >> HASH_LVL1_OFFSET_];
+        next = ((addr >> HASH_LVL1_OFFSET_) + 1) << HASH_LVL1_OFFSET_;
+        if (item->pages) {
+            item = &item->pages[(addr >> PAGE_OFFSET_) & PAGE_MASK_];
+            next = ((addr >> PAGE_OFFSET_) + 1) << PAGE_OFFSET_;
+        }
+        if (item->idev == 0 || (ret && item->idev != ret)) {
+            return 0;
+        }
+        ret = item->idev;
+        *serialized = item->serialized;
+        addr = next;
+    }
+    // Region without neighbours is routed to device beyond its length
+    uint64_t bar = ret->getBaseAddress() & ADDR_MASK_;
+    if (!ret->isBurstSupported() || (trans->addr & ADDR_MASK_) < bar
+        || last >= bar + ret->getLength()) {
+        return 0;
+    }
+    return ret;
 }
 
 void BusGeneric::maphash() {
     IMemoryOperation *imem;
     uint64_t first, last;
-    uint64_t bar;
+    uint64_t bar, len;
+    AttributeType *regions = new AttributeType[HASH_TBL_SIZE];
     for (unsigned i = 0; i < imap_.size(); i++) {
         imem = static_cast<IMemoryOperation *>(imap_[i].to_iface());
-        bar = imem->getBaseAddress();
+        bar = imem->getBaseAddress() & ADDR_MASK_;
+        len = imem->getLength();
+        if (len == 0) {
+            continue;
+        }
         first = (bar >> HASH_LVL1_OFFSET_) & HASH_MASK_;
-        last = ((bar + imem->getLength()) >> HASH_LVL1_OFFSET_) & HASH_MASK_;
-
+        last = ((bar + len - 1) >> HASH_LVL1_OFFSET_) & HASH_MASK_;
         for (uint64_t n = first; n <= last; n++) {
-            HashTableItemType &item = imemtbl_[n];
-            if (!item.nxtlvlena && !item.idev) {
-                item.idev = imem;
-            } else if (item.idev) {
-                item.nxtlvlena = true;
-                item.devlist.new_list_item().make_iface(item.idev);
-                item.devlist.new_list_item().make_iface(imem);
-                item.idev = 0;
-            } else {
-                item.devlist.new_list_item().make_iface(imem);
+            if (!regions[n].is_list()) {
+                regions[n].make_list(0);
+            }
+            regions[n].new_list_item().make_iface(imem);
+        }
+    }
+
+    RouteTableType *route = new RouteTableType;
+    memset(route->tbl, 0, sizeof(route->tbl));
+    for (uint64_t n = 0; n < static_cast<uint64_t>(HASH_TBL_SIZE); n++) {
+        RouteItemType &item = route->tbl[n];
+        if (!regions[n].is_list()) {
+            continue;
+        }
+        if (regions[n].size() == 1) {
+            item.idev = static_cast<IMemoryOperation *>(
+                            regions[n][0u].to_iface());
+            item.serialized = item.idev->isSerialized();
+            continue;
+        }
+        item.pages = new RouteItemType[PAGE_MASK_ + 1];
+        memset(item.pages, 0, (PAGE_MASK_ + 1) * sizeof(RouteItemType));
+        for (uint64_t pg = 0; pg <= PAGE_MASK_; pg++) {
+            first = (n << HASH_LVL1_OFFSET_) | (pg << PAGE_OFFSET_);
+            last = first + (1ull << PAGE_OFFSET_) - 1;
+            routePage(&item.pages[pg], first, last, regions[n]);
+        }
+    }
+    delete [] regions;
+
+    route->prev = route_;
+    RISCV_memory_barrier();
+    route_ = route;
+}
+
+/** Resolve page [first, last] with the same priority rules as access does */
+void BusGeneric::routePage(RouteItemType *item, uint64_t first, uint64_t last,
+                           AttributeType &devlist) {
+    IMemoryOperation *imem;
+    IMemoryOperation *sel = 0;
+    uint64_t bar;
+    unsigned cnt = 0;
+    for (unsigned i = 0; i < devlist.size(); i++) {
+        imem = static_cast<IMemoryOperation *>(devlist[i].to_iface());
+        bar = imem->getBaseAddress() & ADDR_MASK_;
+        if (bar > last || (bar + imem->getLength() - 1) < first) {
+            continue;
+        }
+        cnt++;
+        if (!sel || imem->getPriority() > sel->getPriority()) {
+            sel = imem;
+        }
+    }
+    if (sel == 0) {
+        return;
+    }
+    bar = sel->getBaseAddress() & ADDR_MASK_;
+    if (bar <= first && last <= (bar + sel->getLength() - 1)) {
+        item->idev = sel;
+        item->serialized = sel->isSerialized();
+        return;
+    }
+
+    // Device boundaries inside of the page: check them on access
+    item->devlist = new IMemoryOperation *[cnt + 1];
+    cnt = 0;
+    for (unsigned i = 0; i < devlist.size(); i++) {
+        imem = static_cast<IMemoryOperation *>(devlist[i].to_iface());
+        bar = imem->getBaseAddress() & ADDR_MASK_;
+        if (bar > last || (bar + imem->getLength() - 1) < first) {
+            continue;
+        }
+        item->devlist[cnt++] = imem;
+    }
+    item->devlist[cnt] = 0;
+}
+
+void BusGeneric::deleteRouteTable(RouteTableType *p) {
+    while (p) {
+        RouteTableType *prev = p->prev;
+        for (int n = 0; n < HASH_TBL_SIZE; n++) {
+            RouteItemType &item = p->tbl[n];
+            if (item.pages) {
+                for (uint64_t pg = 0; pg <= PAGE_MASK_; pg++) {
+                    if (item.pages[pg].devlist) {
+                        delete [] item.pages[pg].devlist;
+                    }
+                }
+                delete [] item.pages;
             }
         }
+        delete p;
+        p = prev;
     }
 }
 
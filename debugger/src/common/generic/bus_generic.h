@@ -39,6 +39,8 @@ class BusGeneric : public IService,
     virtual ETransStatus b_transport(Axi4TransactionType *trans);
     virtual ETransStatus nb_transport(Axi4TransactionType *trans,
                                       IAxi4NbResponse *cb);
+    virtual uint8_t *getDirectPointer(uint64_t addr, uint64_t sz,
+                                      EAxi4Action action);
 
     /** IHap */
     virtual void hapTriggered(EHapType type, uint64_t param,
@@ -48,11 +50,43 @@ class BusGeneric : public IService,
     /** Speed-optimized mapping */
     virtual void maphash();
     void getMapedDevice(Axi4TransactionType *trans,
-                        IMemoryOperation **pdev, uint32_t *sz);
+                        IMemoryOperation **pdev, bool *serialized);
+    IMemoryOperation *getBurstDevice(Axi4TransactionType *trans,
+                                     bool *serialized);
+    void updateUtilization(Axi4TransactionType *trans);
 
  protected:
     static const int HASH_ADDR_WIDTH = 14;
     static const int HASH_TBL_SIZE = 1 << HASH_ADDR_WIDTH;
+    static const int PAGE_ADDR_WIDTH = 12;
+
+    /**
+     * Routing entry. When a region is shared by several devices it is
+     * split on pages, and only pages shared below page granularity keep
+     * the list of devices to check on every access.
+     */
+    struct RouteItemType {
+        IMemoryOperation *idev;
+        bool serialized;            // idev requires mutexBAccess_
+        RouteItemType *pages;
+        IMemoryOperation **devlist; // zero-terminated, ordered as mapped
+    };
+
+    /**
+     * Immutable routing table. It is rebuilt on remap and published with
+     * a single pointer write so that b_transport needs no lock. Replaced
+     * tables are kept until destruction because readers may still use them.
+     */
+    struct RouteTableType {
+        RouteItemType tbl[HASH_TBL_SIZE];
+        RouteTableType *prev;
+    };
+
+    void deleteRouteTable(RouteTableType *p);
+    void routePage(RouteItemType *item, uint64_t first, uint64_t last,
+                   AttributeType &devlist);
+
+ protected:
     AttributeType addrWidth_;       // address bits (39 bits for FU740). [63:39] must be equal to [38]
     mutex_def mutexBAccess_;
     mutex_def mutexNBAccess_;
@@ -60,19 +94,13 @@ class BusGeneric : public IService,
     Axi4TransactionType nb_tr_;
 
     GenericReg64Bank busUtil_;    // per master read/write access statistic
-    IMemoryOperation **imaphash_;
-
-    struct HashTableItemType {
-        bool nxtlvlena;
-        IMemoryOperation *idev;
-        HashTableItemType *tbl;
-        AttributeType devlist;
-    } imemtbl_[HASH_TBL_SIZE];
+    RouteTableType * volatile route_;
 
     uint64_t ADDR_MASK_;
     uint64_t HASH_MASK_;
     uint64_t HASH_LVL1_OFFSET_;
-    uint64_t HASH_LVL2_OFFSET_;
+    int PAGE_OFFSET_;
+    uint64_t PAGE_MASK_;
 };
 
 DECLARE_CLASS(BusGeneric)
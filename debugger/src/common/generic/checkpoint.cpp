@@ -0,0 +1,180 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "checkpoint.h"
+#include <string.h>
+
+namespace debugger {
+
+static const uint8_t CHECKPOINT_MAGIC[4] = {'R', 'V', 'C', 'P'};
+static const int CHECKPOINT_HEADER_SIZE = 16;
+
+static void putLE(uint8_t *p, uint64_t v, int sz) {
+    for (int i = 0; i < sz; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static uint64_t getLE(const uint8_t *p, int sz) {
+    uint64_t v = 0;
+    for (int i = 0; i < sz; i++) {
+        v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    }
+    return v;
+}
+
+CheckpointWriter::CheckpointWriter() {
+    fl_ = 0;
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    close();
+}
+
+bool CheckpointWriter::open(const char *filename) {
+    uint8_t hdr[CHECKPOINT_HEADER_SIZE];
+    close();
+    fl_ = fopen(filename, "wb");
+    if (!fl_) {
+        return false;
+    }
+    memset(hdr, 0, sizeof(hdr));
+    memcpy(hdr, CHECKPOINT_MAGIC, 4);
+    putLE(&hdr[4], CHECKPOINT_VERSION, 4);
+    fwrite(hdr, 1, sizeof(hdr), fl_);
+    return true;
+}
+
+void CheckpointWriter::close() {
+    if (fl_) {
+        fclose(fl_);
+        fl_ = 0;
+    }
+}
+
+void CheckpointWriter::writeReg(uint32_t regno, uint64_t val) {
+    uint8_t rec[13];
+    if (!fl_) {
+        return;
+    }
+    rec[0] = CheckpointRec_Reg;
+    putLE(&rec[1], regno, 4);
+    putLE(&rec[5], val, 8);
+    fwrite(rec, 1, sizeof(rec), fl_);
+}
+
+void CheckpointWriter::writeMem(uint64_t addr, const uint8_t *buf,
+                                uint32_t sz) {
+    uint8_t rec[13];
+    if (!fl_) {
+        return;
+    }
+    while (sz) {
+        uint32_t chunk = sz < CHECKPOINT_CHUNK_MAX ? sz : CHECKPOINT_CHUNK_MAX;
+        bool zero = true;
+        for (uint32_t i = 0; i < chunk && zero; i++) {
+            zero = buf[i] == 0;
+        }
+        rec[0] = zero ? CheckpointRec_Zero : CheckpointRec_Mem;
+        putLE(&rec[1], addr, 8);
+        putLE(&rec[9], chunk, 4);
+        fwrite(rec, 1, sizeof(rec), fl_);
+        if (!zero) {
+            fwrite(buf, 1, chunk, fl_);
+        }
+        addr += chunk;
+        buf += chunk;
+        sz -= chunk;
+    }
+}
+
+
+CheckpointReader::CheckpointReader() {
+    fl_ = 0;
+    buf_ = new uint8_t[CHECKPOINT_CHUNK_MAX];
+    truncated_ = false;
+}
+
+CheckpointReader::~CheckpointReader() {
+    close();
+    delete [] buf_;
+}
+
+bool CheckpointReader::open(const char *filename) {
+    uint8_t hdr[CHECKPOINT_HEADER_SIZE];
+    close();
+    fl_ = fopen(filename, "rb");
+    if (!fl_) {
+        return false;
+    }
+    if (fread(hdr, 1, sizeof(hdr), fl_) != sizeof(hdr)
+        || memcmp(hdr, CHECKPOINT_MAGIC, 4) != 0
+        || getLE(&hdr[4], 4) != CHECKPOINT_VERSION) {
+        close();
+        return false;
+    }
+    truncated_ = false;
+    return true;
+}
+
+void CheckpointReader::close() {
+    if (fl_) {
+        fclose(fl_);
+        fl_ = 0;
+    }
+}
+
+bool CheckpointReader::read(CheckpointRecordType *r) {
+    uint8_t rec[13];
+    if (!fl_ || truncated_) {
+        return false;
+    }
+    if (fread(rec, 1, 1, fl_) != 1) {
+        return false;
+    }
+    if (fread(&rec[1], 1, 12, fl_) != 12) {
+        truncated_ = true;
+        return false;
+    }
+    r->type = rec[0];
+    r->data = 0;
+    switch (r->type) {
+    case CheckpointRec_Reg:
+        r->regno = static_cast<uint32_t>(getLE(&rec[1], 4));
+        r->val = getLE(&rec[5], 8);
+        return true;
+    case CheckpointRec_Zero:
+    case CheckpointRec_Mem:
+        r->addr = getLE(&rec[1], 8);
+        r->size = static_cast<uint32_t>(getLE(&rec[9], 4));
+        if (r->size > CHECKPOINT_CHUNK_MAX) {
+            break;
+        }
+        if (r->type == CheckpointRec_Zero) {
+            return true;
+        }
+        if (fread(buf_, 1, r->size, fl_) != r->size) {
+            break;
+        }
+        r->data = buf_;
+        return true;
+    default:;
+    }
+    truncated_ = true;
+    return false;
+}
+
+}  // namespace debugger
@@ -0,0 +1,88 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Architectural state checkpoint. File starts with 16-bytes
+ *             header:
+ *               'RVCP', version, reserved, reserved (32-bits little endian)
+ *             followed by records, all values are little endian:
+ *               type     8-bits ECheckpointRecord
+ *               register regno (32 bits), value (64 bits)
+ *               memory   addr (64 bits), size (32 bits), data
+ *               zero     addr (64 bits), size (32 bits)
+ *             Register number is the address of the debug abstract command,
+ *             so the same file is restored into any core with Debug Module.
+ */
+
+#ifndef __DEBUGGER_COMMON_GENERIC_CHECKPOINT_H__
+#define __DEBUGGER_COMMON_GENERIC_CHECKPOINT_H__
+
+#include <inttypes.h>
+#include <stdio.h>
+
+namespace debugger {
+
+static const uint32_t CHECKPOINT_VERSION = 1;
+static const uint32_t CHECKPOINT_CHUNK_MAX = 4096;
+
+enum ECheckpointRecord {
+    CheckpointRec_Reg = 1,
+    CheckpointRec_Mem = 2,
+    CheckpointRec_Zero = 3
+};
+
+struct CheckpointRecordType {
+    uint8_t type;               // ECheckpointRecord
+    uint32_t regno;
+    uint64_t val;
+    uint64_t addr;
+    uint32_t size;
+    uint8_t *data;              // valid until the next read()
+};
+
+class CheckpointWriter {
+ public:
+    CheckpointWriter();
+    ~CheckpointWriter();
+
+    bool open(const char *filename);
+    void close();
+    void writeReg(uint32_t regno, uint64_t val);
+    /** Chunks filled with zeros are stored without data */
+    void writeMem(uint64_t addr, const uint8_t *buf, uint32_t sz);
+
+ private:
+    FILE *fl_;
+};
+
+class CheckpointReader {
+ public:
+    CheckpointReader();
+    ~CheckpointReader();
+
+    bool open(const char *filename);
+    void close();
+    /** Returns false on the end of file or on the truncated record */
+    bool read(CheckpointRecordType *r);
+    bool isTruncated() { return truncated_; }
+
+ private:
+    FILE *fl_;
+    uint8_t *buf_;
+    bool truncated_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_COMMON_GENERIC_CHECKPOINT_H__
@@ -33,6 +33,8 @@ CpuGeneric::CpuGeneric(const char *name)
     registerInterface(static_cast<IDPort *>(this));
     registerInterface(static_cast<IPower *>(this));
     registerInterface(static_cast<IResetListener *>(this));
+    registerInterface(static_cast<IScheduledHart *>(this));
+    registerInterface(static_cast<ILockstepHart *>(this));
     registerInterface(static_cast<IHap *>(this));
     registerAttribute("Enable", &isEnable_);
     registerAttribute("SysBus", &sysBus_);
@@ -43,6 +45,7 @@ CpuGeneric::CpuGeneric(const char *name)
     registerAttribute("StackTraceSize", &stackTraceSize_);
     registerAttribute("FreqHz", &freqHz_);
     registerAttribute("GenerateTraceFile", &generateTraceFile_);
+    registerAttribute("TraceFormat", &traceFormat_);
     registerAttribute("ResetVector", &resetVector_);
     registerAttribute("SysBusMasterID", &sysBusMasterID_);
     registerAttribute("CacheBaseAddress", &cacheBaseAddr_);
@@ -51,6 +54,9 @@ CpuGeneric::CpuGeneric(const char *name)
     registerAttribute("TriggersTotal", &triggersTotal_);
     registerAttribute("McontrolMaskmax", &mcontrolMaskmax_);
     registerAttribute("ResetState", &resetState_);
+    registerAttribute("Scheduler", &scheduler_);
+
+    traceFormat_.make_string("Text");
 
     char tstr[256];
     RISCV_sprintf(tstr, sizeof(tstr), "eventConfigDone_%s", name);
@@ -59,7 +65,11 @@ CpuGeneric::CpuGeneric(const char *name)
     RISCV_register_hap(static_cast<IHap *>(this));
 
     isysbus_ = 0;
+    isched_ = 0;
+    schedSlot_ = 0;
+    resetDirectMemory();
     estate_ = CORE_OFF;
+    dbgEpoch_ = 0;
     step_cnt_ = 0;
     pc_z_ = 0;
     exceptions_ = 0;
@@ -72,9 +82,12 @@ CpuGeneric::CpuGeneric(const char *name)
 
     ptriggers_ = 0;
     trace_file_ = 0;
+    trace_bin_ = 0;
+    trace_ena_ = false;
     memset(&trace_data_, 0, sizeof(trace_data_));
     icache_ = 0;
     memcache_sz_ = 0;
+    icache_epoch_ = 1;
     fetch_addr_ = 0;
     cache_offset_ = 0;
     cachable_pc_ = false;
@@ -104,6 +117,9 @@ CpuGeneric::~CpuGeneric() {
         trace_file_->close();
         delete trace_file_;
     }
+    if (trace_bin_) {
+        delete trace_bin_;
+    }
 }
 
 void CpuGeneric::postinitService() {
@@ -161,15 +177,43 @@ void CpuGeneric::postinitService() {
         memset(icache_, 0, memcache_sz_*sizeof(ICacheType));
     }
 
+    if (scheduler_.size()) {
+        isched_ = static_cast<IHartScheduler *>(
+            RISCV_get_service_iface(scheduler_.to_string(),
+                                    IFACE_HART_SCHEDULER));
+        if (!isched_) {
+            RISCV_error("IHartScheduler interface '%s' not found",
+                        scheduler_.to_string());
+        }
+    }
+
     // Get global settings:
     const AttributeType *glb = RISCV_get_global_settings();
     if ((*glb)["SimEnable"].to_bool() && isEnable_.to_bool()) {
-        if (!run()) {
+        if (isched_) {
+            schedSlot_ = isched_->registerHart(
+                            static_cast<IScheduledHart *>(this));
+            if (schedSlot_ < 0) {
+                isched_ = 0;
+            }
+        }
+        // Round-robin scheduler executes harts in its own thread
+        if ((!isched_ || !isched_->isRoundRobin()) && !run()) {
             RISCV_error("Can't create thread.", NULL);
             return;
         }
         if (generateTraceFile_.is_string() && generateTraceFile_.size()) {
-            trace_file_ = new std::ofstream(generateTraceFile_.to_string());
+            if (traceFormat_.is_equal("Binary")) {
+                trace_bin_ = new BinTraceWriter();
+                if (!trace_bin_->open(generateTraceFile_.to_string(),
+                                      traceIsa())) {
+                    RISCV_error("Can't create trace file %s",
+                                generateTraceFile_.to_string());
+                }
+            } else {
+                trace_file_ = new std::ofstream(generateTraceFile_.to_string());
+            }
+            trace_ena_ = true;
         }
     }
 
@@ -187,11 +231,73 @@ void CpuGeneric::hapTriggered(EHapType type,
 void CpuGeneric::busyLoop() {
     RISCV_event_wait(&eventConfigDone_);
 
+    if (isched_) {
+        uint64_t quantum = isched_->getQuantum();
+        while (isEnabled()) {
+            runQuantum(quantum);
+            isched_->quantumBarrier(schedSlot_);
+        }
+        isched_->unregisterHart(schedSlot_);
+        return;
+    }
+
     while (isEnabled()) {
         updatePipeline();
     }
 }
 
+/** Halted hart doesn't step, so its idle iterations are counted instead */
+void CpuGeneric::runQuantum(uint64_t steps) {
+    uint64_t end = step_cnt_ + steps;
+    for (uint64_t i = 0; i < steps && step_cnt_ < end; i++) {
+        updatePipeline();
+    }
+}
+
+/**
+ * Lockstep reference: the generic pipeline is called directly to bypass
+ * translated blocks so that exactly one instruction is executed.
+ */
+bool CpuGeneric::stepCommit(LockstepCommitType *c) {
+    uint64_t msk[9] = {0, 0xFFull, 0xFFFFull, 0, 0xFFFFFFFFull,
+                       0, 0, 0, ~0ull};
+    uint64_t cnt = step_cnt_;
+    trace_ena_ = true;
+    trace_data_.action_cnt = 0;
+    CpuGeneric::updatePipeline();
+    if (step_cnt_ == cnt) {
+        return false;
+    }
+
+    c->cnt = trace_data_.step_cnt;
+    c->pc = trace_data_.pc;
+    c->instr = trace_data_.instr;
+    c->actioncnt = 0;
+    for (int i = 0; i < trace_data_.action_cnt
+                    && c->actioncnt < LOCKSTEP_ACTIONS_MAX; i++) {
+        trace_action_type *pa = &trace_data_.action[i];
+        LockstepActionType *p = &c->action[c->actioncnt++];
+        if (!pa->memop) {
+            p->type = LockstepAction_Reg;
+            p->size = 8;
+            p->regidx = static_cast<uint16_t>(pa->waddr);
+            p->addr = 0;
+            p->data = pa->wdata;
+        } else {
+            p->type = pa->memop_write ? LockstepAction_Store
+                                      : LockstepAction_Load;
+            p->size = static_cast<uint8_t>(pa->memop_size);
+            p->regidx = 0;
+            p->addr = pa->memop_addr;
+            p->data = pa->memop_data.val;
+            if (pa->memop_size <= 8) {
+                p->data &= msk[pa->memop_size];
+            }
+        }
+    }
+    return true;
+}
+
 void CpuGeneric::updatePipeline() {
     if (!updateState()) {
         return;
@@ -224,8 +330,8 @@ void CpuGeneric::updatePipeline() {
 
     handleTrap();
 
-    if (trace_file_) {
-        traceOutput();
+    if (trace_ena_) {
+        traceStep();
     }
 }
 
@@ -271,6 +377,9 @@ bool CpuGeneric::updateState() {
 
 void CpuGeneric::updateQueue() {
     IFace *cb;
+    if (!queue_.isPending(step_cnt_)) {
+        return;
+    }
     queue_.initProc();
     queue_.pushPreQueued();
 
@@ -294,10 +403,12 @@ void CpuGeneric::fetchILine() {
     if ((fetch_addr_ & CACHE_MASK_) == CACHE_BASE_ADDR_) {
         cachable_pc_ = true;
         cache_offset_ = fetch_addr_ - CACHE_BASE_ADDR_;
-        instr_ = icache_[cache_offset_].instr;
-        cacheline_[0].buf32[0] = icache_[cache_offset_].buf;  // for tracer
+        if (icache_[cache_offset_].epoch == icache_epoch_) {
+            instr_ = icache_[cache_offset_].instr;
+            cacheline_[0].buf32[0] = icache_[cache_offset_].buf;  // for tracer
+        }
     }
-    
+
 
     if (!instr_) {
         trans_.action = MemAction_Read;
@@ -336,7 +447,11 @@ void CpuGeneric::flush(uint64_t addr) {
         return;
     }
     if (addr == ~0ull) {
-        memset(icache_, 0, memcache_sz_*sizeof(ICacheType));
+        // Invalidate all entries at once without touching the whole array
+        if (++icache_epoch_ == 0) {
+            memset(icache_, 0, memcache_sz_*sizeof(ICacheType));
+            icache_epoch_ = 1;
+        }
     } else if ((addr & CACHE_MASK_) == CACHE_BASE_ADDR_) {
         /** SW breakpoint manager must call this flush operation */
         if ((addr & CACHE_MASK_) == CACHE_BASE_ADDR_) {
@@ -346,7 +461,7 @@ void CpuGeneric::flush(uint64_t addr) {
 }
 
 void CpuGeneric::trackContextStart() {
-    if (!trace_file_) {
+    if (!trace_ena_) {
         return;
     }
     trace_data_.action_cnt = 0;
@@ -368,11 +483,45 @@ void CpuGeneric::trackContextEnd() {
         if (cachable_pc_) {
             icache_[cache_offset_].instr = instr_;
             icache_[cache_offset_].buf = cacheline_[0].buf32[0];
+            icache_[cache_offset_].epoch = icache_epoch_;
         }
     }
     do_not_cache_ = false;
 }
 
+/** Binary records are buffered and flushed by chunks or on halt */
+void CpuGeneric::traceStep() {
+    if (trace_file_) {
+        traceOutput();
+        return;
+    }
+    if (!trace_bin_) {
+        return;
+    }
+    trace_rec_.step = trace_data_.step_cnt;
+    trace_rec_.pc = trace_data_.pc;
+    trace_rec_.instr = trace_data_.instr;
+    trace_rec_.oplen = oplen_;
+    trace_rec_.actioncnt = trace_data_.action_cnt;
+    for (int i = 0; i < trace_data_.action_cnt; i++) {
+        trace_action_type *pa = &trace_data_.action[i];
+        BinTraceActionType *p = &trace_rec_.action[i];
+        if (!pa->memop) {
+            p->type = BinTraceAction_Reg;
+            p->size = 8;
+            p->regidx = static_cast<uint8_t>(pa->waddr);
+            p->data = pa->wdata;
+        } else {
+            p->type = pa->memop_write ? BinTraceAction_MemWrite
+                                      : BinTraceAction_MemRead;
+            p->size = static_cast<uint8_t>(pa->memop_size);
+            p->addr = pa->memop_addr;
+            p->data = pa->memop_data.val;
+        }
+    }
+    trace_bin_->write(&trace_rec_);
+}
+
 void CpuGeneric::traceRegister(int idx, uint64_t v) {
     if (trace_data_.action_cnt >= 64) {
         return;
@@ -405,16 +554,12 @@ void CpuGeneric::registerStepCallback(IClockListener *cb,
 }
 
 bool CpuGeneric::moveStepCallback(IClockListener *cb, uint64_t t) {
-    if (queue_.move(cb, t)) {
-        return true;
-    }
-    registerStepCallback(cb, t);
-    return false;
+    return queue_.move(cb, t);
 }
 
 void CpuGeneric::setReg(int idx, uint64_t val) {
     R[idx] = val;
-    if (trace_file_) {
+    if (trace_ena_) {
         traceRegister(idx, val);
     }
 }
@@ -444,7 +589,25 @@ void CpuGeneric::popStackTrace() {
 ETransStatus CpuGeneric::dma_memop(Axi4TransactionType *tr) {
     ETransStatus ret = TRANS_OK;
     tr->source_idx = sysBusMasterID_.to_int();
-    if (tr->xsize <= sysBusWidthBytes_.to_uint32()) {
+    if (tr->is_burst()) {
+        return isysbus_->b_transport(tr);
+    }
+    uint8_t *pmem = directMemory(tr);
+    if (pmem) {
+        tr->response = MemResp_Valid;
+        if (tr->action == MemAction_Read) {
+            tr->rpayload.b64[0] = 0;
+            memcpy(tr->rpayload.b8, pmem, tr->xsize);
+        } else if (((1ul << tr->xsize) - 1) == tr->wstrb) {
+            memcpy(pmem, tr->wpayload.b8, tr->xsize);
+        } else {
+            for (uint32_t i = 0; i < tr->xsize; i++) {
+                if ((tr->wstrb >> i) & 0x1) {
+                    pmem[i] = tr->wpayload.b8[i];
+                }
+            }
+        }
+    } else if (tr->xsize <= sysBusWidthBytes_.to_uint32()) {
         ret = isysbus_->b_transport(tr);
     } else {
         // 1-byte access for HC08
@@ -464,7 +627,7 @@ ETransStatus CpuGeneric::dma_memop(Axi4TransactionType *tr) {
         }
     }
 
-    if (trace_file_) {
+    if (trace_ena_) {
         int we = tr->action == MemAction_Write ? 1 : 0;
         Reg64Type memop_data;
         memop_data.val = 0;
@@ -478,6 +641,44 @@ ETransStatus CpuGeneric::dma_memop(Axi4TransactionType *tr) {
     return ret;
 }
 
+/**
+ * Pages are requested from the system bus once and cached. Pages without
+ * host pointer (MMIO, read-only etc) are cached as well so that the
+ * transaction path is taken without asking the bus again.
+ */
+uint8_t *CpuGeneric::directMemory(Axi4TransactionType *tr) {
+    uint64_t off = tr->addr & ((1ull << DIRECT_PAGE_WIDTH) - 1);
+    if (tr->xsize > sysBusWidthBytes_.to_uint32()
+        || off + tr->xsize > (1ull << DIRECT_PAGE_WIDTH)) {
+        return 0;
+    }
+    uint64_t page = tr->addr >> DIRECT_PAGE_WIDTH;
+    DirectPageType &e = directpage_[page & (DIRECT_PAGE_TOTAL - 1)];
+    if (e.page != page) {
+        uint64_t pageaddr = page << DIRECT_PAGE_WIDTH;
+        e.page = page;
+        e.rd = isysbus_->getDirectPointer(pageaddr,
+                                          1ull << DIRECT_PAGE_WIDTH,
+                                          MemAction_Read);
+        e.wr = isysbus_->getDirectPointer(pageaddr,
+                                          1ull << DIRECT_PAGE_WIDTH,
+                                          MemAction_Write);
+    }
+    uint8_t *p = tr->action == MemAction_Read ? e.rd : e.wr;
+    if (p == 0) {
+        return 0;
+    }
+    return p + off;
+}
+
+void CpuGeneric::resetDirectMemory() {
+    for (int i = 0; i < DIRECT_PAGE_TOTAL; i++) {
+        directpage_[i].page = ~0ull;
+        directpage_[i].rd = 0;
+        directpage_[i].wr = 0;
+    }
+}
+
 void CpuGeneric::resume() {
     if (estate_ == CORE_OFF) {
         RISCV_error("CPU is turned-off", 0);
@@ -519,6 +720,10 @@ void CpuGeneric::halt(uint32_t cause, const char *descr) {
                        getPC(), strop, descr);
     }
     estate_ = CORE_Halted;
+    dbgEpoch_++;
+    if (trace_bin_) {
+        trace_bin_->flush();
+    }
 }
 
 bool CpuGeneric::isTriggerICount() {
@@ -559,6 +764,8 @@ void CpuGeneric::power(EPowerAction onoff) {
 
 void CpuGeneric::reset(IFace *isource) {
     flush(~0ull);
+    dbgEpoch_++;
+    resetDirectMemory();
     /** Reset address can be changed in runtime */
     portRegs_.reset();
     setPC(getResetAddress());
@@ -680,6 +887,7 @@ void CpuGeneric::enterProgbufExec() {
 
 void CpuGeneric::exitProgbufExec() {
     estate_ = CORE_Halted;
+    dbgEpoch_++;
     PC_ = &ctxregs_[Ctx_Normal].pc.val;
     NPC_ = &ctxregs_[Ctx_Normal].npc.val;
     RISCV_info("%s", "Ending executing progbuf");
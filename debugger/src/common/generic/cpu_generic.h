@@ -31,7 +31,10 @@
 #include "coreservices/icmdexec.h"
 #include "coreservices/itap.h"
 #include "coreservices/icoveragetracker.h"
+#include "coreservices/ihartsched.h"
+#include "coreservices/ilockstep.h"
 #include "generic/mapreg.h"
+#include "generic/trace_bin.h"
 #include <generic-isa.h>
 #include <fstream>
 
@@ -44,6 +47,8 @@ class CpuGeneric : public IService,
                    public IClock,
                    public IPower,
                    public IResetListener,
+                   public IScheduledHart,
+                   public ILockstepHart,
                    public IHap {
  public:
     explicit CpuGeneric(const char *name);
@@ -82,8 +87,26 @@ class CpuGeneric : public IService,
     virtual void writeRegDbg(uint32_t regno, uint64_t val) {}
     virtual bool executeProgbuf(uint32_t *progbuf);
     virtual bool isExecutingProgbuf() { return estate_ == CORE_ProgbufExec; }
+    virtual uint64_t getDebugEpoch() { return dbgEpoch_; }
     virtual void setResetPin(bool val) {}
 
+    /** IScheduledHart */
+    virtual void runQuantum(uint64_t steps);
+
+    /** ILockstepHart */
+    virtual bool stepCommit(LockstepCommitType *c);
+
+    /** Read-modify-write sequences of several harts are serialized */
+    void lockAtomic() {
+        if (isched_) {
+            isched_->lockAtomic();
+        }
+    }
+    void unlockAtomic() {
+        if (isched_) {
+            isched_->unlockAtomic();
+        }
+    }
 
  protected:
     virtual uint64_t getResetAddress() { return resetVector_.to_uint64(); }
@@ -99,6 +122,8 @@ class CpuGeneric : public IService,
     virtual void traceRegister(int idx, uint64_t v);
     virtual void traceMemop(uint64_t addr, int we, uint64_t v, uint32_t sz);
     virtual void traceOutput() {}
+    virtual uint32_t traceIsa() { return BinTraceIsa_Generic; }
+    void traceStep();
     virtual bool isStepEnabled() { return false; }
     virtual bool isTriggerICount();
     virtual bool isTriggerInstruction();
@@ -148,6 +173,7 @@ class CpuGeneric : public IService,
     AttributeType sourceCode_;
     AttributeType stackTraceSize_;
     AttributeType generateTraceFile_;
+    AttributeType traceFormat_;
     AttributeType resetVector_;
     AttributeType sysBusMasterID_;
     AttributeType cacheBaseAddr_;
@@ -156,11 +182,14 @@ class CpuGeneric : public IService,
     AttributeType resetState_;
     AttributeType triggersTotal_;
     AttributeType mcontrolMaskmax_;
+    AttributeType scheduler_;
 
     ISourceCode *isrc_;
     ICoverageTracker *icovtracker_;
     ICmdExecutor *icmdexec_;
     IMemoryOperation *isysbus_;
+    IHartScheduler *isched_;
+    int schedSlot_;
     GenericInstruction *instr_;
 
     enum EContextTypes {
@@ -221,16 +250,30 @@ class CpuGeneric : public IService,
         CORE_Normal,
         CORE_ProgbufExec
     } estate_;
+    uint64_t dbgEpoch_;         // Invalidates debugger register snapshots
 
     Axi4TransactionType trans_;
     Reg64Type cacheline_[512/4];
+
+    // Host pointers on RAM pages to bypass sysbus on load/store
+    static const int DIRECT_PAGE_WIDTH = 12;
+    static const int DIRECT_PAGE_TOTAL = 64;
+    struct DirectPageType {
+        uint64_t page;
+        uint8_t *rd;            // 0 if read via transaction
+        uint8_t *wr;            // 0 if write via transaction
+    } directpage_[DIRECT_PAGE_TOTAL];
+    uint8_t *directMemory(Axi4TransactionType *tr);
+    void resetDirectMemory();
     
     // Simple memory cache to avoid access to sysbus and speed-up simulation
     struct ICacheType {
         GenericInstruction *instr;
         uint32_t buf;
+        uint32_t epoch;             // entry is valid if equal icache_epoch_
     } *icache_;            // parsed instructions storage
     int memcache_sz_;               // allocated size
+    uint32_t icache_epoch_;         // incremented on each full flush
     uint64_t CACHE_BASE_ADDR_;
     uint64_t CACHE_MASK_;
     uint64_t fetch_addr_;
@@ -259,6 +302,9 @@ class CpuGeneric : public IService,
         int action_cnt;
     } trace_data_;
     std::ofstream *trace_file_;
+    BinTraceWriter *trace_bin_;
+    BinTraceRecordType trace_rec_;
+    bool trace_ena_;            // collect trace_data_ for file or lockstep
 };
 
 }  // namespace debugger
@@ -16,12 +16,14 @@
 
 #include "debug/dmi_regs.h"
 #include "cmd_dmi_cpu.h"
+#include "generic/checkpoint.h"
 #include <riscv-isa.h>
 
 namespace debugger {
 
 CmdDmiCpuGneric::CmdDmiCpuGneric(IFace *parent, uint64_t dmibar, ITap *tap)
     : ICommand(static_cast<IService *>(parent)->getObjName(), dmibar, tap) {
+    iparent_ = static_cast<IService *>(parent);
 
     briefDescr_.make_string("Core run control command");
     detailedDescr_.make_string(
@@ -32,12 +34,21 @@ CmdDmiCpuGneric::CmdDmiCpuGneric(IFace *parent, uint64_t dmibar, ITap *tap)
         "    Commands:\n"
         "       halt, stop, break - are the commands to stop the CPU\n"
         "       go, run, c - are the command to start the CPU\n"
+        "       go <steps> - run the selected number of steps and halt\n"
         "       step - execute one instruction and return into Debug Mode\n"
+        "       save <file> [<addr> <bytes>]... - halt and store registers\n"
+        "           and memory regions into the checkpoint file\n"
+        "       restore <file> - reset the hart, write the checkpoint and\n"
+        "           keep the hart halted. Returns registers not accepted by\n"
+        "           the core.\n"
         "Example:\n"
         "    core0 halt\n"
         "    core0 stop\n"
         "    core0 go\n"
-        "    core0 step\n");
+        "    core0 go 1000000\n"
+        "    core0 step\n"
+        "    core0 save cp.bin 0x80000000 0x80000\n"
+        "    core0 restore cp.bin\n");
 }
 
 
@@ -56,12 +67,15 @@ int CmdDmiCpuGneric::isValid(AttributeType *args) {
     if (!par1.is_equal("halt")
         && !par1.is_equal("stop")
         && !par1.is_equal("break")
-        && !par1.is_equal("go")
+        && !(par1.is_equal("go") && args->size() <= 3)
         && !par1.is_equal("run")
         && !par1.is_equal("c")
         && !par1.is_equal("step")
         && !(par1.is_equal("reg") && (args->size() == 3 || args->size() == 4))
-        && !(par1.is_equal("regs") && args->size() >= 3)) {
+        && !(par1.is_equal("regs") && args->size() >= 3)
+        && !(par1.is_equal("save") && args->size() >= 3
+            && (args->size() & 1))
+        && !(par1.is_equal("restore") && args->size() == 3)) {
         return CMD_WRONG_ARGS;
     }
     return CMD_VALID;
@@ -85,6 +99,8 @@ void CmdDmiCpuGneric::exec(AttributeType *args, AttributeType *res) {
     if (par1.is_equal("halt") || par1.is_equal("stop") || par1.is_equal("break")) {
         halt();
         waithalted();
+    } else if (par1.is_equal("go") && args->size() == 3) {
+        runsteps((*args)[2].to_uint64(), res);
     } else if (par1.is_equal("go") || par1.is_equal("run") || par1.is_equal("c")) {
         resume();
     } else if (par1.is_equal("step")) {
@@ -93,17 +109,30 @@ void CmdDmiCpuGneric::exec(AttributeType *args, AttributeType *res) {
         waithalted();
         setStep(0);
     } else if (par1.is_equal("regs")) {
-        uint32_t addr;
+        const ECpuRegMapping *preg = getpMappedReg();
+        int total = 0;
+        int idx;
+        while (preg[total].name[0]) {
+            total++;
+        }
+        // All registers with one burst, abstract commands as fallback
+        Reg64Type *snapshot = new Reg64Type[total + 1];
+        bool issnapshot = readsnapshot(snapshot, total);
         res->make_list(args->size() - 2);
         for (unsigned i = 2; i < args->size(); i++) {
             AttributeType &regname = (*args)[i];
-            addr = reg2addr(regname.to_string());
-            if (addr == REG_ADDR_ERROR) {
+            idx = reg2idx(regname.to_string());
+            if (idx < 0) {
                 continue;
             }
-            readreg(addr, reg.buf);
+            if (issnapshot) {
+                reg = snapshot[idx + 1];
+            } else {
+                readreg(preg[idx].offset, reg.buf);
+            }
             (*res)[i-2].make_uint64(reg.val);
         }
+        delete [] snapshot;
     } else if (par1.is_equal("reg")) {
         AttributeType &regname = (*args)[2];
         uint32_t addr = reg2addr(regname.to_string());
@@ -116,6 +145,10 @@ void CmdDmiCpuGneric::exec(AttributeType *args, AttributeType *res) {
             }
         }
         res->make_uint64(reg.val);
+    } else if (par1.is_equal("save")) {
+        savecheckpoint(args, res);
+    } else if (par1.is_equal("restore")) {
+        restorecheckpoint((*args)[2].to_string(), res);
     }
 }
 
@@ -130,6 +163,16 @@ const uint32_t CmdDmiCpuGneric::reg2addr(const char *name) {
     return REG_ADDR_ERROR;
 }
 
+int CmdDmiCpuGneric::reg2idx(const char *name) {
+    const ECpuRegMapping  *preg = getpMappedReg();
+    for (int i = 0; preg[i].name[0]; i++) {
+        if (strcmp(name, preg[i].name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 void CmdDmiCpuGneric::setStep(bool val) {
     // Write data0
     DCSR_TYPE::ValueType dcsr;
@@ -181,40 +224,56 @@ void CmdDmiCpuGneric::halt() {
     dma_write(dmibar_ + 4*0x10, 4, dmcontrol.u8);
 }
 
-void CmdDmiCpuGneric::waithalted() {
+bool CmdDmiCpuGneric::ishalted() {
     DMSTATUS_TYPE::ValueType dmstatus;
-    bool finish = false;
-    while (!finish) {
-        dma_read(dmibar_ + 0x11*0x4, 4, dmstatus.u8);
-        if (dmstatus.bits.allhalted) {
-            finish = true;
-        }
+    dma_read(dmibar_ + 0x11*0x4, 4, dmstatus.u8);
+    return dmstatus.bits.allhalted != 0;
+}
+
+void CmdDmiCpuGneric::waithalted() {
+    while (!ishalted()) {
     }
 }
 
-void CmdDmiCpuGneric::waitbusy() {
+/** Returns false when the abstract command was rejected */
+bool CmdDmiCpuGneric::waitbusy() {
     ABSTRACTCS_TYPE::ValueType abstractcs;
     bool busy = true;
     while (busy) {
         dma_read(dmibar_ + 0x16*0x4, 4, abstractcs.u8); //abstractcs
         busy = abstractcs.bits.busy;
     }
+    return abstractcs.bits.cmderr == 0;
 }
 
-void CmdDmiCpuGneric::readreg(uint32_t regno, uint8_t *buf8) {
+bool CmdDmiCpuGneric::readreg(uint32_t regno, uint8_t *buf8) {
     COMMAND_TYPE::ValueType command;
     command.val = 0;
     command.bits.transfer = 1;
     command.bits.aarsize = 3;
     command.bits.regno = regno;
     dma_write(dmibar_ + 4*0x17, 4, command.u8);     // arg0 = [data1,data0]
-    waitbusy();
+    bool ret = waitbusy();
     // Read arg0
     dma_read(dmibar_ + 4*0x4, 4, buf8);          // [data1,data0]
     dma_read(dmibar_ + 4*0x5, 4, &buf8[4]);
+    return ret;
+}
+
+/**
+ * Snapshot bank starts with the number of registers. Debug module without
+ * this bank returns something else and registers are read one by one.
+ */
+bool CmdDmiCpuGneric::readsnapshot(Reg64Type *buf, int total) {
+    uint32_t sz = static_cast<uint32_t>((total + 1) * sizeof(Reg64Type));
+    buf[0].val = 0;
+    if (dma_read(dmibar_ + 4*0x100, sz, buf[0].buf) != TRANS_OK) {
+        return false;
+    }
+    return buf[0].val == static_cast<uint64_t>(total);
 }
 
-void CmdDmiCpuGneric::writereg(uint32_t regno, uint8_t *buf8) {
+bool CmdDmiCpuGneric::writereg(uint32_t regno, uint8_t *buf8) {
     COMMAND_TYPE::ValueType command;
     // Read arg0
     dma_write(dmibar_ + 4*0x4, 4, buf8);          // [data1,data0]
@@ -225,11 +284,161 @@ void CmdDmiCpuGneric::writereg(uint32_t regno, uint8_t *buf8) {
     command.bits.aarsize = 3;
     command.bits.regno = regno;
     dma_write(dmibar_ + 4*0x17, 4, command.u8);     // arg0 = [data1,data0]
-    waitbusy();
+    return waitbusy();
+}
+
+/**
+ * Halt is requested through IDPort from the step callback: icount trigger
+ * counter is too narrow to skip billions of instructions.
+ */
+void CmdDmiCpuGneric::runsteps(uint64_t steps, AttributeType *res) {
+    IClock *iclk = static_cast<IClock *>(iparent_->getInterface(IFACE_CLOCK));
+    IDPort *idport = static_cast<IDPort *>(iparent_->getInterface(IFACE_DPORT));
+    if (!iclk || !idport) {
+        generateError(res, "Run for steps isn't supported");
+        return;
+    }
+    uint64_t t0 = iclk->getStepCounter();
+    uint64_t t = t0 + steps;
+    stepHalt_.arm(idport, t);
+    iclk->registerStepCallback(&stepHalt_, t);
+    resume();
+    // Resume acknowledge can be set before the hart leaves Debug Mode
+    while (ishalted() && iclk->getStepCounter() == t0) {
+        RISCV_sleep_ms(1);
+    }
+    // Breakpoint before the selected step also stops the run
+    while (!ishalted()) {
+        RISCV_sleep_ms(10);
+    }
+    stepHalt_.disarm();
+    res->make_uint64(iclk->getStepCounter());
+}
+
+/**
+ * Memory is stored first so that restored registers cannot be changed by
+ * the memory writes. Registers rejected by the core aren't stored.
+ */
+void CmdDmiCpuGneric::savecheckpoint(AttributeType *args,
+                                     AttributeType *res) {
+    const ECpuRegMapping *maps[2] = {getpCheckpointReg(), getpMappedReg()};
+    CheckpointWriter wr;
+    Reg64Type reg;
+    if (!wr.open((*args)[2].to_string())) {
+        generateError(res, "Can't open file");
+        return;
+    }
+    if (!ishalted()) {
+        halt();
+        waithalted();
+    }
+
+    uint8_t *buf = new uint8_t[CHECKPOINT_CHUNK_MAX];
+    for (unsigned i = 3; i + 1 < args->size(); i += 2) {
+        uint64_t addr = (*args)[i].to_uint64();
+        uint64_t total = (*args)[i + 1].to_uint64();
+        while (total) {
+            uint32_t sz = CHECKPOINT_CHUNK_MAX;
+            if (total < sz) {
+                sz = static_cast<uint32_t>(total);
+            }
+            if (dma_read(addr, sz, buf) != TRANS_OK) {
+                generateError(res, "Memory region isn't accessible");
+                delete [] buf;
+                return;
+            }
+            wr.writeMem(addr, buf, sz);
+            addr += sz;
+            total -= sz;
+        }
+    }
+    delete [] buf;
+
+    for (int n = 0; n < 2; n++) {
+        for (const ECpuRegMapping *preg = maps[n];
+            preg && preg->name[0]; preg++) {
+            reg.val = 0;
+            if (readreg(preg->offset, reg.buf)) {
+                wr.writeReg(preg->offset, reg.val);
+            } else {
+                clearcmderr();
+            }
+        }
+    }
+}
+
+/**
+ * Hart reset cleans caches and pipeline of the RTL core before memory is
+ * written through the system bus. Program counter is restored the last via
+ * dpc and instruction cache is flushed, the hart stays in Debug Mode.
+ */
+void CmdDmiCpuGneric::restorecheckpoint(const char *filename,
+                                        AttributeType *res) {
+    CheckpointReader rd;
+    CheckpointRecordType r;
+    Reg64Type reg;
+    DMCONTROL_TYPE::ValueType dmcontrol;
+    if (!rd.open(filename)) {
+        generateError(res, "Can't open checkpoint file");
+        return;
+    }
+    if (!ishalted()) {
+        halt();
+        waithalted();
+    }
+    dmcontrol.val = 0;
+    dmcontrol.bits.haltreq = 1;
+    dmcontrol.bits.hartreset = 1;
+    dma_write(dmibar_ + 4*0x10, 4, dmcontrol.u8);
+    dmcontrol.bits.hartreset = 0;
+    dma_write(dmibar_ + 4*0x10, 4, dmcontrol.u8);
+    waithalted();
+    clearcmderr();
+
+    uint8_t *zero = new uint8_t[CHECKPOINT_CHUNK_MAX];
+    memset(zero, 0, CHECKPOINT_CHUNK_MAX);
+    res->make_list(0);
+    uint64_t dpc = 0;
+    bool isdpc = false;
+    while (rd.read(&r)) {
+        if (r.type == CheckpointRec_Mem) {
+            dma_write(r.addr, r.size, r.data);
+        } else if (r.type == CheckpointRec_Zero) {
+            dma_write(r.addr, r.size, zero);
+        } else if (r.regno == CSR_dpc) {
+            dpc = r.val;
+            isdpc = true;
+        } else {
+            reg.val = r.val;
+            if (!writereg(r.regno, reg.buf)) {
+                clearcmderr();
+                AttributeType item;
+                item.make_uint64(r.regno);
+                res->add_to_list(&item);
+            }
+        }
+    }
+    delete [] zero;
+    if (rd.isTruncated()) {
+        generateError(res, "Checkpoint file is truncated");
+        return;
+    }
+
+    reg.val = ~0ull;
+    writereg(CSR_flushi, reg.buf);
+    clearcmderr();
+    if (isdpc) {
+        reg.val = dpc;
+        writereg(CSR_dpc, reg.buf);
+    }
 }
 
 const ECpuRegMapping *CmdDmiCpuRiscV::getpMappedReg() {
     return RISCV_DEBUG_REG_MAP;
 }
 
+const ECpuRegMapping *CmdDmiCpuRiscV::getpCheckpointReg() {
+    return RISCV_CHECKPOINT_CSR_MAP;
+}
+
 }  // namespace debugger
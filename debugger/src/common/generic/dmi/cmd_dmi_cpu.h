@@ -18,6 +18,8 @@
 
 #include "api_core.h"
 #include "coreservices/icommand.h"
+#include "coreservices/iclock.h"
+#include "coreservices/idport.h"
 #include <generic-isa.h>
 
 namespace debugger {
@@ -32,17 +34,52 @@ class CmdDmiCpuGneric : public ICommand  {
 
  protected:
     virtual const ECpuRegMapping *getpMappedReg() = 0;
+    /** Registers saved into checkpoint besides of the mapped registers */
+    virtual const ECpuRegMapping *getpCheckpointReg() { return 0; }
     virtual const uint32_t reg2addr(const char *name);
+    virtual int reg2idx(const char *name);
 
  private:
     void clearcmderr();
     void resume();
     void halt();
+    bool ishalted();
     void waithalted();
-    void waitbusy();
+    bool waitbusy();
     void setStep(bool val);
-    void readreg(uint32_t regno, uint8_t *buf8);
-    void writereg(uint32_t regno, uint8_t *buf8);
+    bool readreg(uint32_t regno, uint8_t *buf8);
+    bool writereg(uint32_t regno, uint8_t *buf8);
+    bool readsnapshot(Reg64Type *buf, int total);
+    void runsteps(uint64_t steps, AttributeType *res);
+    void savecheckpoint(AttributeType *args, AttributeType *res);
+    void restorecheckpoint(const char *filename, AttributeType *res);
+
+    /** Halt request from the simulation thread on the selected step */
+    class StepHaltListener : public IClockListener {
+     public:
+        StepHaltListener() : IClockListener(), idport_(0), target_(0),
+            armed_(false) {}
+        void arm(IDPort *idport, uint64_t t) {
+            idport_ = idport;
+            target_ = t;
+            armed_ = true;
+        }
+        void disarm() { armed_ = false; }
+        /** IClockListener */
+        virtual void stepCallback(uint64_t t) {
+            // Callback of the previous run could be still in the queue
+            if (armed_ && t >= target_) {
+                armed_ = false;
+                idport_->haltreq();
+            }
+        }
+     private:
+        IDPort *idport_;
+        uint64_t target_;
+        volatile bool armed_;
+    } stepHalt_;
+
+    IService *iparent_;
 };
 
 class CmdDmiCpuRiscV : public CmdDmiCpuGneric {
@@ -51,6 +88,7 @@ class CmdDmiCpuRiscV : public CmdDmiCpuGneric {
 
  protected:
     virtual const ECpuRegMapping *getpMappedReg();
+    virtual const ECpuRegMapping *getpCheckpointReg();
 };
 
 }  // namespace debugger
@@ -24,20 +24,32 @@ MemoryGeneric::MemoryGeneric(const char *name)  : IService(name) {
     registerAttribute("ReadOnly", &readOnly_);
     registerAttribute("DpiClient", &dpiClient_);
     registerAttribute("DpiRoutes", &dpiRoutes_);
+    registerAttribute("FillPattern", &fillPattern_);
 
     readOnly_.make_boolean(false);
+    fillPattern_.make_nil();
     mem_ = NULL;
     idpi_ = 0;
+    pattern_ = 0;
+    touched_ = 0;
 }
 
 MemoryGeneric::~MemoryGeneric() {
-    if (mem_) {
-        delete mem_;
+    RISCV_memory_release(mem_, length_.to_uint64());
+    if (touched_) {
+        delete [] touched_;
     }
 }
 
 void MemoryGeneric::postinitService() {
-    mem_ = new uint8_t[static_cast<unsigned>(length_.to_uint64())];
+    // Host memory is committed page by page when guest touches it
+    mem_ = static_cast<uint8_t *>(RISCV_memory_reserve(length_.to_uint64()));
+    if (!mem_) {
+        return;
+    }
+    if (fillPattern_.is_integer()) {
+        setFillPattern(fillPattern_.to_uint32());
+    }
 
     if (dpiClient_.is_string() && dpiClient_.size()) {
         idpi_ = static_cast<IDpi *>(
@@ -48,8 +60,85 @@ void MemoryGeneric::postinitService() {
     }
 }
 
+uint8_t *MemoryGeneric::getDirectPointer(uint64_t addr, uint64_t sz,
+                                         EAxi4Action action) {
+    if (!mem_ || idpi_
+        || (action == MemAction_Write && readOnly_.to_bool())) {
+        return 0;
+    }
+    uint64_t off = (addr - getBaseAddress()) % length_.to_uint64();
+    if (off + sz > length_.to_uint64()) {
+        return 0;
+    }
+    touchPages(off, sz);
+    return &mem_[off];
+}
+
+void MemoryGeneric::setFillPattern(uint32_t pattern) {
+    uint64_t pages = (length_.to_uint64() + (1ull << PAGE_WIDTH) - 1)
+                    >> PAGE_WIDTH;
+    pattern_ = pattern;
+    if (!touched_) {
+        uint32_t *t = new uint32_t[static_cast<size_t>(pages)];
+        memset(t, 0, static_cast<size_t>(pages) * sizeof(uint32_t));
+        touched_ = t;
+    }
+}
+
+void MemoryGeneric::setPagesLoaded(uint64_t off, uint64_t sz) {
+    if (!touched_ || sz == 0) {
+        return;
+    }
+    if (off + sz > length_.to_uint64()) {
+        sz = length_.to_uint64() - off;
+    }
+    for (uint64_t i = off >> PAGE_WIDTH;
+         i <= ((off + sz - 1) >> PAGE_WIDTH); i++) {
+        touched_[i] = PAGE_CLAIMED | PAGE_READY;
+    }
+}
+
+/**
+ * The first accessor claims the page and fills it, others wait until the
+ * page is published so that their data isn't overwritten by the pattern.
+ */
+void MemoryGeneric::fillPages(uint64_t off, uint64_t sz) {
+    uint32_t *page;
+    for (uint64_t i = off >> PAGE_WIDTH;
+         i <= ((off + sz - 1) >> PAGE_WIDTH); i++) {
+        if (touched_[i] & PAGE_READY) {
+            continue;
+        }
+        if (RISCV_atomic_or32(&touched_[i], PAGE_CLAIMED) & PAGE_CLAIMED) {
+            while ((touched_[i] & PAGE_READY) == 0) {
+                RISCV_memory_barrier();
+            }
+            continue;
+        }
+        page = reinterpret_cast<uint32_t *>(&mem_[i << PAGE_WIDTH]);
+        for (int n = 0; n < (1 << PAGE_WIDTH) / 4; n++) {
+            page[n] = pattern_;
+        }
+        RISCV_memory_barrier();
+        RISCV_atomic_or32(&touched_[i], PAGE_READY);
+    }
+}
+
 ETransStatus MemoryGeneric::b_transport(Axi4TransactionType *trans) {
-    uint64_t off = (trans->addr - getBaseAddress()) % length_.to_int();
+    uint64_t off = (trans->addr - getBaseAddress()) % length_.to_uint64();
+    if (!mem_) {
+        // Host memory wasn't reserved
+        trans->response = MemResp_Error;
+        return TRANS_ERROR;
+    }
+    if (trans->is_burst()) {
+        if (idpi_ || trans->burst != Burst_Incr
+            || off + trans->xsize > length_.to_uint64()) {
+            return splitBurst(trans);
+        }
+        return burstTransport(trans, off);
+    }
+    touchPages(off, trans->xsize);
     trans->response = MemResp_Valid;
     if (trans->action == MemAction_Write) {
         if (readOnly_.to_bool()) {
@@ -99,4 +188,24 @@ ETransStatus MemoryGeneric::b_transport(Axi4TransactionType *trans) {
     return TRANS_OK;
 }
 
+ETransStatus MemoryGeneric::burstTransport(Axi4TransactionType *trans,
+                                           uint64_t off) {
+    touchPages(off, trans->xsize);
+    trans->response = MemResp_Valid;
+    if (trans->action == MemAction_Read) {
+        memcpy(trans->bpayload, &mem_[off], trans->xsize);
+    } else if (readOnly_.to_bool()) {
+        RISCV_error("Write to READ ONLY memory", NULL);
+        trans->response = MemResp_Error;
+        return TRANS_ERROR;
+    } else {
+        memcpy(&mem_[off], trans->bpayload, trans->xsize);
+    }
+    RISCV_debug("[%08" RV_PRI64 "x] %s burst %d bytes",
+        trans->addr,
+        trans->action == MemAction_Read ? "=>" : "<=",
+        trans->xsize);
+    return TRANS_OK;
+}
+
 }  // namespace debugger
@@ -35,15 +35,42 @@ class MemoryGeneric : public IService,
 
     /** IMemoryOperation */
     virtual ETransStatus b_transport(Axi4TransactionType *trans);
+    virtual bool isSerialized() { return idpi_ != 0; }
+    virtual bool isBurstSupported() { return idpi_ == 0; }
+    virtual uint8_t *getDirectPointer(uint64_t addr, uint64_t sz,
+                                      EAxi4Action action);
+
+    /** Untouched pages are filled by pattern on the first access */
+    void setFillPattern(uint32_t pattern);
+    /** Pages already contain data and must not be filled */
+    void setPagesLoaded(uint64_t off, uint64_t sz);
+
+ protected:
+    ETransStatus burstTransport(Axi4TransactionType *trans, uint64_t off);
+    void touchPages(uint64_t off, uint64_t sz) {
+        if (touched_) {
+            fillPages(off, sz);
+        }
+    }
+    void fillPages(uint64_t off, uint64_t sz);
 
  protected:
+    static const int PAGE_WIDTH = 12;
+
     AttributeType readOnly_;
     AttributeType dpiClient_;
     AttributeType dpiRoutes_;
+    AttributeType fillPattern_;
 
     IDpi *idpi_;
 
     uint8_t *mem_;
+    uint32_t pattern_;
+    // Page state in the fill mode: PAGE_CLAIMED is set by the accessor that
+    // fills page, PAGE_READY is published after the fill is finished
+    static const uint32_t PAGE_CLAIMED = 0x1;
+    static const uint32_t PAGE_READY = 0x2;
+    volatile uint32_t *touched_;
 };
 
 }  // namespace debugger
@@ -89,6 +89,10 @@ ETransStatus RegMemBankGeneric::b_transport(Axi4TransactionType *trans) {
     uint64_t t_addr = trans->addr;      // orignal address
     Axi4TransactionType tr;
 
+    if (trans->is_burst()) {
+        return burstTransport(trans);
+    }
+
     uint64_t off = trans->addr - getBaseAddress();    // offset relative registers bank
     uint64_t off0 = off;
     uint32_t tsz = trans->xsize;
@@ -135,6 +139,11 @@ ETransStatus RegMemBankGeneric::nb_transport(Axi4TransactionType *trans,
                                              IAxi4NbResponse *cb) {
     IMemoryOperation *imem;
     uint64_t t_addr = trans->addr;      // orignal address
+
+    if (trans->is_burst()) {
+        // Registers may support only non-blocking access
+        return splitBurstNb(trans, cb);
+    }
     
     trans->addr -= getBaseAddress();    // offset relative registers bank
     imem = imaphash_[trans->addr];
@@ -150,6 +159,61 @@ ETransStatus RegMemBankGeneric::nb_transport(Axi4TransactionType *trans,
     return ret;
 }
 
+/**
+ * Beats are sent directly to the mapped registers without bus routing.
+ * Beat never crosses register boundary.
+ */
+ETransStatus RegMemBankGeneric::burstTransport(Axi4TransactionType *trans) {
+    IMemoryOperation *imem;
+    Axi4TransactionType tr = *trans;
+    uint64_t off = trans->addr - getBaseAddress();
+    uint32_t bsize = trans->bsize;
+    uint32_t pos = 0;
+    uint64_t regend;
+    if (trans->burst != Burst_Incr
+        || off + trans->xsize > length_.to_uint64()) {
+        return splitBurst(trans);
+    }
+    if (bsize == 0 || bsize > PAYLOAD_MAX_BYTES) {
+        bsize = PAYLOAD_MAX_BYTES;
+    }
+
+    trans->response = MemResp_Valid;
+    while (pos < trans->xsize) {
+        imem = imaphash_[off];
+        if (imem == 0) {
+            if (trans->action == MemAction_Read) {
+                trans->bpayload[pos] = stubmem[off];
+            } else {
+                stubmem[off] = trans->bpayload[pos];
+            }
+            pos++;
+            off++;
+            continue;
+        }
+        tr.addr = off;
+        tr.xsize = bsize - static_cast<uint32_t>(off % bsize);
+        if (tr.xsize > trans->xsize - pos) {
+            tr.xsize = trans->xsize - pos;
+        }
+        regend = imem->getBaseAddress() + imem->getLength();
+        if (off + tr.xsize > regend) {
+            tr.xsize = static_cast<uint32_t>(regend - off);
+        }
+        tr.wstrb = (1u << tr.xsize) - 1;
+        if (trans->action == MemAction_Read) {
+            tr.rpayload.b64[0] = 0;
+            imem->b_transport(&tr);
+            memcpy(&trans->bpayload[pos], tr.rpayload.b8, tr.xsize);
+        } else {
+            memcpy(tr.wpayload.b8, &trans->bpayload[pos], tr.xsize);
+            imem->b_transport(&tr);
+        }
+        pos += tr.xsize;
+        off += tr.xsize;
+    }
+    return TRANS_OK;
+}
 
 void RegMemBankGeneric::maphash(IMemoryOperation *imemop) {
     // All Registers inside bank mapped relative register bank baseAddress
@@ -37,7 +37,7 @@ class RegMemBankGeneric : public IService,
     virtual ETransStatus b_transport(Axi4TransactionType *trans);
     virtual ETransStatus nb_transport(Axi4TransactionType *trans,
                               IAxi4NbResponse *cb);
-
+    virtual bool isBurstSupported() { return true; }
 
     /** IHap */
     virtual void hapTriggered(EHapType type, uint64_t param,
@@ -47,6 +47,7 @@ class RegMemBankGeneric : public IService,
     /** Speed-optimized mapping */
     void maphash(IMemoryOperation *imemop);
     IMemoryOperation *getRegFace(uint64_t addr);
+    ETransStatus burstTransport(Axi4TransactionType *trans);
     
  protected:
     IMemoryOperation **imaphash_;
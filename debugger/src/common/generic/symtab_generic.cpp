@@ -0,0 +1,273 @@
+/*
+ *  Copyright 2021 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <api_core.h>
+#include <coreservices/isrccode.h>
+#include "symtab_generic.h"
+#include <algorithm>
+
+namespace debugger {
+
+struct SymbolTableGeneric::CompareAddr {
+    const SymbolType *symb;
+    bool operator()(uint32_t a, uint32_t b) const {
+        if (symb[a].addr != symb[b].addr) {
+            return symb[a].addr < symb[b].addr;
+        }
+        return a < b;
+    }
+};
+
+struct SymbolTableGeneric::CompareName {
+    const SymbolType *symb;
+    const char *names;
+    bool operator()(uint32_t a, uint32_t b) const {
+        int t = strcmp(&names[symb[a].name], &names[symb[b].name]);
+        if (t != 0) {
+            return t < 0;
+        }
+        return a < b;
+    }
+};
+
+SymbolTableGeneric::SymbolTableGeneric() {
+    size_ = 0;
+    symb_ = 0;
+    namesSize_ = 0;
+    names_ = 0;
+    byAddr_ = 0;
+    byName_ = 0;
+    hashTbl_ = 0;
+    RISCV_mutex_init(&mutex_);
+    clear();
+}
+
+SymbolTableGeneric::~SymbolTableGeneric() {
+    clear();
+    if (symb_) {
+        delete [] symb_;
+    }
+    if (names_) {
+        delete [] names_;
+    }
+    RISCV_mutex_destroy(&mutex_);
+}
+
+void SymbolTableGeneric::clear() {
+    RISCV_mutex_lock(&mutex_);
+    total_ = 0;
+    namesCnt_ = 0;
+    if (byAddr_) {
+        delete [] byAddr_;
+        delete [] byName_;
+        delete [] hashTbl_;
+    }
+    byAddr_ = 0;
+    byName_ = 0;
+    hashTbl_ = 0;
+    hashMask_ = 0;
+    dirty_ = false;
+    RISCV_mutex_unlock(&mutex_);
+}
+
+void SymbolTableGeneric::add(const char *name, uint64_t addr, uint64_t sz,
+                             uint32_t type) {
+    RISCV_mutex_lock(&mutex_);
+    addItem(name, addr, sz, type);
+    RISCV_mutex_unlock(&mutex_);
+}
+
+void SymbolTableGeneric::addItem(const char *name, uint64_t addr,
+                                 uint64_t sz, uint32_t type) {
+    unsigned len = static_cast<unsigned>(strlen(name)) + 1;
+    if (total_ == size_) {
+        unsigned t1 = size_ ? 2*size_ : 1024;
+        SymbolType *p1 = new SymbolType[t1];
+        if (symb_) {
+            memcpy(p1, symb_, total_*sizeof(SymbolType));
+            delete [] symb_;
+        }
+        symb_ = p1;
+        size_ = t1;
+    }
+    if (namesCnt_ + len > namesSize_) {
+        unsigned t1 = namesSize_ ? 2*namesSize_ : 64*1024;
+        while (t1 < namesCnt_ + len) {
+            t1 *= 2;
+        }
+        char *p1 = new char[t1];
+        if (names_) {
+            memcpy(p1, names_, namesCnt_);
+            delete [] names_;
+        }
+        names_ = p1;
+        namesSize_ = t1;
+    }
+    memcpy(&names_[namesCnt_], name, len);
+
+    SymbolType &s = symb_[total_++];
+    s.addr = addr;
+    s.size = sz;
+    s.name = namesCnt_;
+    s.type = type;
+    namesCnt_ += len;
+    dirty_ = true;
+}
+
+void SymbolTableGeneric::add(AttributeType *list) {
+    RISCV_mutex_lock(&mutex_);
+    for (unsigned i = 0; i < list->size(); i++) {
+        AttributeType &item = (*list)[i];
+        addItem(item[Symbol_Name].to_string(),
+                item[Symbol_Addr].to_uint64(),
+                item[Symbol_Size].to_uint64(),
+                item.size() > Symbol_Type ? item[Symbol_Type].to_uint32() : 0);
+    }
+    RISCV_mutex_unlock(&mutex_);
+}
+
+uint32_t SymbolTableGeneric::hash(const char *name) {
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    while (*name) {
+        h ^= static_cast<uint8_t>(*name++);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void SymbolTableGeneric::build() {
+    if (byAddr_) {
+        delete [] byAddr_;
+        delete [] byName_;
+        delete [] hashTbl_;
+    }
+    byAddr_ = new uint32_t[total_ + 1];
+    byName_ = new uint32_t[total_ + 1];
+    for (unsigned i = 0; i < total_; i++) {
+        byAddr_[i] = i;
+        byName_[i] = i;
+    }
+
+    CompareAddr cmpaddr;
+    cmpaddr.symb = symb_;
+    std::sort(byAddr_, byAddr_ + total_, cmpaddr);
+
+    CompareName cmpname;
+    cmpname.symb = symb_;
+    cmpname.names = names_;
+    std::sort(byName_, byName_ + total_, cmpname);
+
+    // The first symbol in name order wins on duplicated names
+    uint32_t hsz = 16;
+    while (hsz < 2*total_) {
+        hsz <<= 1;
+    }
+    hashMask_ = hsz - 1;
+    hashTbl_ = new uint32_t[hsz];
+    memset(hashTbl_, 0, hsz*sizeof(uint32_t));
+    for (unsigned i = 0; i < total_; i++) {
+        uint32_t idx = byName_[i];
+        uint32_t h = hash(symbName(idx)) & hashMask_;
+        while (hashTbl_[h]) {
+            if (strcmp(symbName(hashTbl_[h] - 1), symbName(idx)) == 0) {
+                break;
+            }
+            h = (h + 1) & hashMask_;
+        }
+        if (hashTbl_[h] == 0) {
+            hashTbl_[h] = idx + 1;
+        }
+    }
+    dirty_ = false;
+}
+
+int SymbolTableGeneric::findAddress(uint64_t addr, AttributeType *name,
+                                    uint64_t *offset) {
+    int ret = -1;
+    RISCV_mutex_lock(&mutex_);
+    if (dirty_) {
+        build();
+    }
+
+    // Last symbol with address less or equal to addr
+    unsigned lo = 0;
+    unsigned hi = total_;
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (symb_[byAddr_[mid]].addr <= addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo != 0) {
+        unsigned pos = lo - 1;
+        SymbolType *s = &symb_[byAddr_[pos]];
+        if (lo != total_ || addr < s->addr + s->size) {
+            // Use the first symbol among aliases with the same address
+            while (pos > 0 && symb_[byAddr_[pos - 1]].addr == s->addr) {
+                pos--;
+            }
+            s = &symb_[byAddr_[pos]];
+            *offset = addr - s->addr;
+            name->make_string(&names_[s->name]);
+            ret = 0;
+        }
+    }
+    RISCV_mutex_unlock(&mutex_);
+    return ret;
+}
+
+int SymbolTableGeneric::findName(const char *name, uint64_t *addr) {
+    int ret = -1;
+    RISCV_mutex_lock(&mutex_);
+    if (dirty_) {
+        build();
+    }
+    uint32_t h = hash(name) & hashMask_;
+    while (total_ && hashTbl_[h]) {
+        SymbolType &s = symb_[hashTbl_[h] - 1];
+        if (strcmp(&names_[s.name], name) == 0) {
+            *addr = s.addr;
+            ret = 0;
+            break;
+        }
+        h = (h + 1) & hashMask_;
+    }
+    RISCV_mutex_unlock(&mutex_);
+    return ret;
+}
+
+void SymbolTableGeneric::getList(AttributeType *list) {
+    RISCV_mutex_lock(&mutex_);
+    if (dirty_) {
+        build();
+    }
+    list->make_list(total_);
+    for (unsigned i = 0; i < total_; i++) {
+        SymbolType &s = symb_[byName_[i]];
+        AttributeType &item = (*list)[i];
+        item.make_list(Symbol_Total);
+        item[Symbol_Name].make_string(&names_[s.name]);
+        item[Symbol_Addr].make_uint64(s.addr);
+        item[Symbol_Size].make_uint64(s.size);
+        item[Symbol_Type].make_uint64(s.type);
+    }
+    RISCV_mutex_unlock(&mutex_);
+}
+
+}  // namespace debugger
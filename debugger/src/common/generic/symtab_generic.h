@@ -0,0 +1,91 @@
+/*
+ *  Copyright 2021 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#pragma once
+
+#include <inttypes.h>
+#include <api_types.h>
+#include <attribute.h>
+
+namespace debugger {
+
+/**
+ * Debug symbols index shared by the source code services.
+ *
+ * Symbols are stored as plain records with names in a common string
+ * buffer. Inserting only appends; sorted views and the hash by name are
+ * rebuilt once on the first request after modification. All methods are
+ * serialized by the mutex: symbols are requested from the GUI, GDB and
+ * RPC threads while ELF loader adds them.
+ */
+class SymbolTableGeneric {
+ public:
+    SymbolTableGeneric();
+    ~SymbolTableGeneric();
+
+    void clear();
+    void add(const char *name, uint64_t addr, uint64_t sz, uint32_t type);
+    /** Bulk insert of items [[name, addr, size, type], *] */
+    void add(AttributeType *list);
+
+    unsigned size() { return total_; }
+
+    /**
+     * Find symbol containing address, name is copied under the lock
+     * @return 0 if symbol found
+     */
+    int findAddress(uint64_t addr, AttributeType *name, uint64_t *offset);
+
+    /** @return 0 if symbol found */
+    int findName(const char *name, uint64_t *addr);
+
+    /** Symbols sorted by name in ISourceCode format */
+    void getList(AttributeType *list);
+
+ private:
+    struct SymbolType {
+        uint64_t addr;
+        uint64_t size;
+        uint32_t name;          // offset in names_ buffer
+        uint32_t type;
+    };
+
+    struct CompareAddr;
+    struct CompareName;
+
+    void addItem(const char *name, uint64_t addr, uint64_t sz, uint32_t type);
+    void build();
+    uint32_t hash(const char *name);
+    const char *symbName(uint32_t idx) { return &names_[symb_[idx].name]; }
+
+    SymbolType *symb_;
+    unsigned total_;
+    unsigned size_;
+
+    char *names_;
+    unsigned namesCnt_;
+    unsigned namesSize_;
+
+    bool dirty_;
+    uint32_t *byAddr_;          // indexes sorted by address
+    uint32_t *byName_;          // indexes sorted by name
+    uint32_t *hashTbl_;         // open addressing, index + 1 or 0 if empty
+    uint32_t hashMask_;
+
+    mutex_def mutex_;
+};
+
+}  // namespace debugger
@@ -0,0 +1,293 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "trace_bin.h"
+#include <string.h>
+
+namespace debugger {
+
+static const uint8_t BINTRACE_MAGIC[4] = {'R', 'V', 'T', 'B'};
+static const int BINTRACE_HEADER_SIZE = 16;
+
+static uint64_t zigzag(int64_t v) {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16)
+         | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+BinTraceWriter::BinTraceWriter() {
+    fl_ = 0;
+    buf_ = new uint8_t[BUF_SIZE];
+    cnt_ = 0;
+}
+
+BinTraceWriter::~BinTraceWriter() {
+    close();
+    delete [] buf_;
+}
+
+bool BinTraceWriter::open(const char *filename, uint32_t isa) {
+    uint8_t hdr[BINTRACE_HEADER_SIZE];
+    close();
+    fl_ = fopen(filename, "wb");
+    if (!fl_) {
+        return false;
+    }
+    memcpy(hdr, BINTRACE_MAGIC, 4);
+    put32(&hdr[4], BINTRACE_VERSION);
+    put32(&hdr[8], isa);
+    put32(&hdr[12], 0);
+    fwrite(hdr, 1, sizeof(hdr), fl_);
+
+    cnt_ = 0;
+    step_ = 0;
+    npc_ = 0;
+    memaddr_ = 0;
+    memset(regs_, 0, sizeof(regs_));
+    return true;
+}
+
+void BinTraceWriter::close() {
+    if (fl_) {
+        flush();
+        fclose(fl_);
+        fl_ = 0;
+    }
+}
+
+void BinTraceWriter::flush() {
+    if (fl_ && cnt_) {
+        fwrite(buf_, 1, cnt_, fl_);
+        fflush(fl_);
+        cnt_ = 0;
+    }
+}
+
+void BinTraceWriter::putVarint(uint64_t v) {
+    while (v >= 0x80) {
+        buf_[cnt_++] = static_cast<uint8_t>(v | 0x80);
+        v >>= 7;
+    }
+    buf_[cnt_++] = static_cast<uint8_t>(v);
+}
+
+void BinTraceWriter::write(const BinTraceRecordType *r) {
+    if (!fl_) {
+        return;
+    }
+    if (cnt_ + RECORD_MAX > BUF_SIZE) {
+        fwrite(buf_, 1, cnt_, fl_);
+        cnt_ = 0;
+    }
+
+    uint8_t tag = static_cast<uint8_t>(r->actioncnt < 15 ? r->actioncnt : 15);
+    if (r->step != step_ + 1) {
+        tag |= 0x10;
+    }
+    if (r->pc != npc_) {
+        tag |= 0x20;
+    }
+    if (r->oplen == 2) {
+        tag |= 0x40;
+    }
+    buf_[cnt_++] = tag;
+    if ((tag & 0xF) == 15) {
+        putVarint(r->actioncnt);
+    }
+    if (tag & 0x10) {
+        putVarint(zigzag(static_cast<int64_t>(r->step - step_)));
+    }
+    if (tag & 0x20) {
+        putVarint(zigzag(static_cast<int64_t>(r->pc - npc_)));
+    }
+    buf_[cnt_++] = static_cast<uint8_t>(r->instr);
+    buf_[cnt_++] = static_cast<uint8_t>(r->instr >> 8);
+    if (r->oplen != 2) {
+        buf_[cnt_++] = static_cast<uint8_t>(r->instr >> 16);
+        buf_[cnt_++] = static_cast<uint8_t>(r->instr >> 24);
+    }
+    step_ = r->step;
+    npc_ = r->pc + (r->oplen == 2 ? 2 : 4);
+
+    for (int i = 0; i < r->actioncnt; i++) {
+        const BinTraceActionType *p = &r->action[i];
+        buf_[cnt_++] = static_cast<uint8_t>(p->type | (p->size << 2));
+        if (p->type == BinTraceAction_Reg) {
+            buf_[cnt_++] = p->regidx;
+            putVarint(p->data ^ regs_[p->regidx]);
+            regs_[p->regidx] = p->data;
+        } else {
+            putVarint(zigzag(static_cast<int64_t>(p->addr - memaddr_)));
+            putVarint(p->data);
+            memaddr_ = p->addr + p->size;
+        }
+    }
+}
+
+
+BinTraceReader::BinTraceReader() {
+    fl_ = 0;
+    buf_ = new uint8_t[BUF_SIZE];
+    cnt_ = 0;
+    pos_ = 0;
+    eof_ = true;
+    truncated_ = false;
+    isa_ = BinTraceIsa_Generic;
+}
+
+BinTraceReader::~BinTraceReader() {
+    close();
+    delete [] buf_;
+}
+
+bool BinTraceReader::open(const char *filename) {
+    uint8_t hdr[BINTRACE_HEADER_SIZE];
+    close();
+    fl_ = fopen(filename, "rb");
+    if (!fl_) {
+        return false;
+    }
+    if (fread(hdr, 1, sizeof(hdr), fl_) != sizeof(hdr)
+        || memcmp(hdr, BINTRACE_MAGIC, 4) != 0
+        || get32(&hdr[4]) != BINTRACE_VERSION) {
+        close();
+        return false;
+    }
+    isa_ = get32(&hdr[8]);
+    cnt_ = 0;
+    pos_ = 0;
+    eof_ = false;
+    truncated_ = false;
+    step_ = 0;
+    npc_ = 0;
+    memaddr_ = 0;
+    memset(regs_, 0, sizeof(regs_));
+    return true;
+}
+
+void BinTraceReader::close() {
+    if (fl_) {
+        fclose(fl_);
+        fl_ = 0;
+    }
+    eof_ = true;
+}
+
+/** Keeps at least one complete record in the buffer while file isn't ended */
+bool BinTraceReader::fill() {
+    if (eof_ || cnt_ - pos_ >= 2048) {
+        return pos_ < cnt_;
+    }
+    memmove(buf_, &buf_[pos_], cnt_ - pos_);
+    cnt_ -= pos_;
+    pos_ = 0;
+    size_t sz = fread(&buf_[cnt_], 1, BUF_SIZE - cnt_, fl_);
+    cnt_ += static_cast<uint32_t>(sz);
+    if (cnt_ < BUF_SIZE) {
+        eof_ = true;
+    }
+    return pos_ < cnt_;
+}
+
+uint64_t BinTraceReader::getVarint() {
+    uint64_t v = 0;
+    int shift = 0;
+    uint8_t b;
+    do {
+        if (pos_ >= cnt_) {
+            truncated_ = true;
+            return 0;
+        }
+        b = buf_[pos_++];
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && shift < 64);
+    return v;
+}
+
+bool BinTraceReader::read(BinTraceRecordType *r) {
+    if (truncated_ || !fill()) {
+        return false;
+    }
+    uint8_t tag = buf_[pos_++];
+    r->actioncnt = tag & 0xF;
+    if (r->actioncnt == 15) {
+        r->actioncnt = static_cast<int>(getVarint());
+    }
+    r->step = step_ + 1;
+    if (tag & 0x10) {
+        r->step = step_ + unzigzag(getVarint());
+    }
+    r->pc = npc_;
+    if (tag & 0x20) {
+        r->pc = npc_ + unzigzag(getVarint());
+    }
+    r->oplen = (tag & 0x40) ? 2 : 4;
+    if (pos_ + r->oplen > cnt_ || r->actioncnt > BINTRACE_ACTIONS_MAX) {
+        truncated_ = true;
+        return false;
+    }
+    r->instr = buf_[pos_] | (buf_[pos_ + 1] << 8);
+    if (r->oplen == 4) {
+        r->instr |= (buf_[pos_ + 2] << 16)
+                  | (static_cast<uint32_t>(buf_[pos_ + 3]) << 24);
+    }
+    pos_ += r->oplen;
+    step_ = r->step;
+    npc_ = r->pc + r->oplen;
+
+    for (int i = 0; i < r->actioncnt; i++) {
+        BinTraceActionType *p = &r->action[i];
+        if (pos_ >= cnt_) {
+            truncated_ = true;
+            return false;
+        }
+        uint8_t t = buf_[pos_++];
+        p->type = t & 0x3;
+        p->size = t >> 2;
+        p->regidx = 0;
+        p->addr = 0;
+        if (p->type == BinTraceAction_Reg) {
+            if (pos_ >= cnt_) {
+                truncated_ = true;
+                return false;
+            }
+            p->regidx = buf_[pos_++];
+            p->data = getVarint() ^ regs_[p->regidx];
+            regs_[p->regidx] = p->data;
+        } else {
+            p->addr = memaddr_ + unzigzag(getVarint());
+            p->data = getVarint();
+            memaddr_ = p->addr + p->size;
+        }
+    }
+    return !truncated_;
+}
+
+}  // namespace debugger
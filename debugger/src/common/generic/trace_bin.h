@@ -0,0 +1,132 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Binary instruction trace. File starts with 16-bytes header:
+ *               'RVTB', version, isa, reserved (32-bits little endian)
+ *             followed by records, all multi-byte values are LEB128:
+ *               tag      [3:0] actions (15 = count follows), [4] step delta,
+ *                        [5] pc delta, [6] 16-bits opcode
+ *               count    if tag[3:0] == 15
+ *               step     zigzag(step - previous step) if tag[4]
+ *               pc       zigzag(pc - previous pc - previous oplen) if tag[5]
+ *               opcode   2 or 4 bytes little endian
+ *               actions  type[1:0] | size[5:2], then
+ *                          register: index byte, value XOR previous value
+ *                          memory:   zigzag(addr - end of previous access),
+ *                                    data
+ */
+
+#ifndef __DEBUGGER_COMMON_GENERIC_TRACE_BIN_H__
+#define __DEBUGGER_COMMON_GENERIC_TRACE_BIN_H__
+
+#include <inttypes.h>
+#include <stdio.h>
+
+namespace debugger {
+
+static const uint32_t BINTRACE_VERSION = 1;
+static const int BINTRACE_ACTIONS_MAX = 64;
+
+enum EBinTraceIsa {
+    BinTraceIsa_Generic,        // opcodes are shown as hex values
+    BinTraceIsa_RiscV,
+    BinTraceIsa_Thumb
+};
+
+enum EBinTraceAction {
+    BinTraceAction_Reg,
+    BinTraceAction_MemRead,
+    BinTraceAction_MemWrite
+};
+
+struct BinTraceActionType {
+    uint8_t type;               // EBinTraceAction
+    uint8_t size;               // memory access size in bytes
+    uint8_t regidx;
+    uint64_t addr;
+    uint64_t data;
+};
+
+struct BinTraceRecordType {
+    uint64_t step;
+    uint64_t pc;
+    uint32_t instr;
+    int oplen;                  // 2 or 4, upper half of 16-bits opcode is lost
+    int actioncnt;
+    BinTraceActionType action[BINTRACE_ACTIONS_MAX];
+};
+
+/** Records are encoded into the large buffer that is written by chunks */
+class BinTraceWriter {
+ public:
+    BinTraceWriter();
+    ~BinTraceWriter();
+
+    bool open(const char *filename, uint32_t isa);
+    void close();
+    void flush();
+    void write(const BinTraceRecordType *r);
+
+ private:
+    void putVarint(uint64_t v);
+
+ private:
+    static const uint32_t BUF_SIZE = 1 << 20;
+    static const uint32_t RECORD_MAX = 32 + 22 * BINTRACE_ACTIONS_MAX;
+
+    FILE *fl_;
+    uint8_t *buf_;
+    uint32_t cnt_;
+    uint64_t step_;
+    uint64_t npc_;
+    uint64_t memaddr_;
+    uint64_t regs_[256];
+};
+
+class BinTraceReader {
+ public:
+    BinTraceReader();
+    ~BinTraceReader();
+
+    bool open(const char *filename);
+    void close();
+    uint32_t getIsa() { return isa_; }
+    /** Returns false on the end of file or on the truncated record */
+    bool read(BinTraceRecordType *r);
+    bool isTruncated() { return truncated_; }
+
+ private:
+    bool fill();
+    uint64_t getVarint();
+
+ private:
+    static const uint32_t BUF_SIZE = 1 << 20;
+
+    FILE *fl_;
+    uint8_t *buf_;
+    uint32_t cnt_;
+    uint32_t pos_;
+    bool eof_;
+    bool truncated_;
+    uint32_t isa_;
+    uint64_t step_;
+    uint64_t npc_;
+    uint64_t memaddr_;
+    uint64_t regs_[256];
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_COMMON_GENERIC_TRACE_BIN_H__
@@ -171,6 +171,10 @@ class IService : public IFace {
         return ret;
     }
 
+ protected:
+    /** Inline level check used by the RISCV_info/RISCV_debug macros */
+    int getLogLevel() { return logLevel_.to_int(); }
+
  protected:
     AttributeType namespaceName_;
     AttributeType listInterfaces_;
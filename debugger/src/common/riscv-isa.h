@@ -369,6 +369,29 @@ static const ECpuRegMapping RISCV_DEBUG_REG_MAP[] = {
     {"",      0, 0}
 };
 
+/**
+ * CSRs of the architectural checkpoint in addition to RISCV_DEBUG_REG_MAP.
+ * Counters, triggers and pending interrupts are owned by the platform.
+ */
+static const ECpuRegMapping RISCV_CHECKPOINT_CSR_MAP[] = {
+    {"fcsr",      8, CSR_fcsr},
+    {"mstatus",   8, CSR_mstatus},
+    {"medeleg",   8, CSR_medeleg},
+    {"mideleg",   8, CSR_mideleg},
+    {"mie",       8, CSR_mie},
+    {"mtvec",     8, CSR_mtvec},
+    {"mscratch",  8, CSR_mscratch},
+    {"mepc",      8, CSR_mepc},
+    {"mcause",    8, CSR_mcause},
+    {"mtval",     8, CSR_mtval},
+    {"uepc",      8, CSR_uepc},
+    {"sepc",      8, CSR_sepc},
+    {"satp",      8, CSR_satp},
+    {"mstackovr", 8, CSR_mstackovr},
+    {"mstackund", 8, CSR_mstackund},
+    {"",          0, 0}
+};
+
 enum ERegNames {
     Reg_Zero,
     Reg_ra,       // [1] Return address
@@ -95,6 +95,7 @@ class CpuCortex_Functional : public CpuGeneric,
     virtual void handleInterrupts() {}
     virtual void trackContextEnd() override;
     virtual void traceOutput() override;
+    virtual uint32_t traceIsa() override { return BinTraceIsa_Thumb; }
     
     void addArm7tmdiIsa();
     void addThumb2Isa();
@@ -37,8 +37,6 @@ ArmSourceService::ArmSourceService(const char *name) : IService(name) {
     registerAttribute("Endianess", &endianess_);
 
     brList_.make_list(0);
-    symbolListSortByName_.make_list(0);
-    symbolListSortByAddr_.make_list(0);
 }
 
 ArmSourceService::~ArmSourceService() {
@@ -54,117 +52,39 @@ void ArmSourceService::postinitService() {
 
 void ArmSourceService::addFileSymbol(const char *name, uint64_t addr,
                                        int sz) {
-    AttributeType symb(Attr_List);
-    symb.make_list(Symbol_Total);
-    symb[Symbol_Name].make_string(name);
-    symb[Symbol_Addr].make_uint64(addr);
-    symb[Symbol_Size].make_int64(sz);
-
-    symbolListSortByName_.add_to_list(&symb);
-    symbolListSortByName_.sort(Symbol_Name);
-
-    symbolListSortByAddr_.add_to_list(&symb);
-    symbolListSortByAddr_.sort(Symbol_Addr);
+    symbols_.add(name, addr, sz, SYMBOL_TYPE_FILE);
 }
 
 void ArmSourceService::addFunctionSymbol(const char *name,
                                       uint64_t addr, int sz) {
-    addFileSymbol(name, addr, sz);
+    symbols_.add(name, addr, sz, SYMBOL_TYPE_FUNCTION);
 }
 
 void ArmSourceService::addDataSymbol(const char *name, uint64_t addr,
                                        int sz) {
-    addFileSymbol(name, addr, sz);
+    symbols_.add(name, addr, sz, SYMBOL_TYPE_DATA);
 }
 
 void ArmSourceService::clearSymbols() {
-    symbolListSortByName_.make_list(0);
-    symbolListSortByAddr_.make_list(0);
+    symbols_.clear();
 }
 
 void ArmSourceService::addSymbols(AttributeType *list) {
-    for (unsigned i = 0; i < list->size(); i++) {
-        AttributeType &item = (*list)[i];
-        symbolListSortByName_.add_to_list(&item);
-        symbolListSortByAddr_.add_to_list(&item);
-    }
-    symbolListSortByName_.sort(Symbol_Name);
-    symbolListSortByAddr_.sort(Symbol_Addr);
+    symbols_.add(list);
 }
 
 void ArmSourceService::addressToSymbol(uint64_t addr, AttributeType *info) {
-    uint64_t sadr, send;
-    int sz = static_cast<int>(symbolListSortByAddr_.size());
+    uint64_t off = 0;
 
     info->make_list(SymbInfo_Total);
-    (*info)[SymbInfo_Name].make_string("");
-    (*info)[SymbInfo_Address].make_uint64(0);
-    if (sz == 0) {
-        return;
-    }
-    sadr = symbolListSortByAddr_[0u][Symbol_Addr].to_uint64();
-    if (addr < sadr) {
-        return;
-    }
-
-    bool search = true;
-    int dist, pos = sz / 2;
-    dist = pos;
-    while (search) {
-        AttributeType &symb = symbolListSortByAddr_[pos];
-        sadr = symb[Symbol_Addr].to_uint64();
-        if (pos < static_cast<int>(symbolListSortByAddr_.size()) - 1) {
-            send = symbolListSortByAddr_[pos + 1][Symbol_Addr].to_uint64();
-        } else {
-            send = sadr + symb[Symbol_Size].to_uint64();
-        }
-        if (sadr <= addr && addr < send) {
-            (*info)[SymbInfo_Name] = symb[Symbol_Name];
-            (*info)[SymbInfo_Address].make_uint64(addr - sadr);
-            return;
-        }
-        
-        if (addr < sadr) {
-            if (dist == 0 || pos == 0) {
-                search = false;
-            } else if (dist == 1) {
-                dist = 0;
-                pos--;
-            } else {
-                int incr = dist / 2;
-                pos -= incr;
-                dist = (dist / 2) + (dist & 0x1);
-                if (pos < 0) {
-                    pos = 0;
-                }
-            }
-        } else {
-            if (dist == 0 || pos == (sz - 1)) {
-                search = false;
-            } else if (dist == 1) {
-                dist = 0;
-                pos++;
-            } else {
-                int incr = dist / 2;
-                pos += incr;
-                dist = (dist / 2) + (dist & 0x1);
-                if (pos >= sz) {
-                    pos = sz - 1;
-                }
-            }
-        }
+    if (symbols_.findAddress(addr, &(*info)[SymbInfo_Name], &off) != 0) {
+        (*info)[SymbInfo_Name].make_string("");
     }
+    (*info)[SymbInfo_Address].make_uint64(off);
 }
 
 int ArmSourceService::symbol2Address(const char *name, uint64_t *addr) {
-    for (unsigned i = 0; i < symbolListSortByName_.size(); i++) {
-        AttributeType &item = symbolListSortByName_[i];
-        if (item[Symbol_Name].is_equal(name)) {
-            *addr = item[Symbol_Addr].to_uint64();
-            return 0;
-        }
-    }
-    return -1;
+    return symbols_.findName(name, addr);
 }
 
 void ArmSourceService::registerBreakpoint(uint64_t addr,
@@ -20,6 +20,7 @@
 #include <iclass.h>
 #include <iservice.h>
 #include "coreservices/isrccode.h"
+#include "generic/symtab_generic.h"
 #include "coreservices/icpuarm.h"
 
 namespace debugger {
@@ -45,7 +46,7 @@ class ArmSourceService : public IService,
     virtual void clearSymbols();
 
     virtual void getSymbols(AttributeType *list) {
-        *list = symbolListSortByName_;
+        symbols_.getList(list);
     }
 
     virtual void addressToSymbol(uint64_t addr, AttributeType *info);
@@ -110,8 +111,7 @@ class ArmSourceService : public IService,
     AttributeType cpu_;
     AttributeType endianess_;
     AttributeType brList_;
-    AttributeType symbolListSortByName_;
-    AttributeType symbolListSortByAddr_;
+    SymbolTableGeneric symbols_;
 
     ICpuArm *iarm_;
 };
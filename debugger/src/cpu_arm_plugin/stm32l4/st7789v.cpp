@@ -37,6 +37,14 @@ void ST7789VCmdType::getFrame(AttributeType *res, bool diff) {
     memcpy(res->data(), p->frame_, sizeof(p->frame_));
 }
 
+const char *ST7789VCmdType::getSurfaceName() {
+    return static_cast<ST7789V *>(parent_)->surfaceName_.to_string();
+}
+
+void ST7789VCmdType::publishFrame(AttributeType *res) {
+    static_cast<ST7789V *>(parent_)->publishFrame(res);
+}
+
 ST7789V::ST7789V(const char *name) :
     IService(name),
     pinRD_(this),
@@ -59,9 +67,32 @@ ST7789V::ST7789V(const char *name) :
     m_x = 0;
     m_y = 0;
     last_modified_pixel_ = 0;
+
+    surfaceName_.make_string("");
+    shm_ = 0;
+    surface_ = 0;
+    surfaceSize_ = 0;
+    memset(const_cast<uint8_t *>(dirty_), 1, sizeof(dirty_));
+    memset(dirtyPrev_, 1, sizeof(dirtyPrev_));
 }
 
 void ST7789V::postinitService() {
+    char tstr[256];
+    RISCV_sprintf(tstr, sizeof(tstr), "/%s_%d",
+                  getObjName(), RISCV_get_pid());
+    surfaceSize_ = DisplaySurfaceType::getSize(ST7789V_WIDTH, ST7789V_HEIGHT);
+    shm_ = RISCV_memshare_create(tstr, surfaceSize_);
+    if (shm_) {
+        surface_ = static_cast<DisplaySurfaceType *>(
+                    RISCV_memshare_map(shm_, surfaceSize_));
+    }
+    if (surface_) {
+        surfaceName_.make_string(tstr);
+        memset(surface_, 0, surfaceSize_);
+        surface_->width = ST7789V_WIDTH;
+        surface_->height = ST7789V_HEIGHT;
+    }
+
     iexec_ = static_cast<ICmdExecutor *>
         (RISCV_get_service_iface(cmdexec_.to_string(), IFACE_CMD_EXECUTOR));
     if (!iexec_) {
@@ -90,6 +121,15 @@ void ST7789V::predeleteService() {
         iexec_->unregisterCommand(static_cast<ICommand *>(pcmd_));
         delete pcmd_;
     }
+    if (surface_) {
+        RISCV_memshare_unmap(surface_, surfaceSize_);
+        surface_ = 0;
+    }
+    if (shm_) {
+        RISCV_memshare_delete(shm_);
+        RISCV_memshare_remove(surfaceName_.to_string());
+        shm_ = 0;
+    }
 }
 
 void ST7789V::connectListener(IIOPortListener32 *iface,
@@ -199,11 +239,62 @@ void ST7789V::madctl() {
 }
 
 void ST7789V::iled_setpixel(uint32_t rgb) {
-    int pix_idx = m_y*ST7789V_HEIGHT + ST7789V_HEIGHT-m_x-1;
+    int col = m_y;
+    int row = ST7789V_HEIGHT - m_x - 1;
+    if (col >= ST7789V_WIDTH || row < 0) {
+        return;
+    }
+    int pix_idx = col*ST7789V_HEIGHT + row;
     if (frame_[pix_idx] != rgb) {
         last_modified_pixel_ = pix_idx;
+        frame_[pix_idx] = rgb;
+        dirty_[(col / DISPLAY_TILE_SIZE) * ST7789V_TILES_Y
+               + row / DISPLAY_TILE_SIZE] = 1;
     }
-    frame_[pix_idx] = rgb;
+}
+
+/**
+ * GUI thread reads the front buffer until it requests the next frame.
+ * Back buffer gets tiles modified since the previous publishing and tiles
+ * that were written only into the current front buffer.
+ */
+void ST7789V::publishFrame(AttributeType *res) {
+    uint8_t upd[ST7789V_TILES];
+    unsigned cnt = 0;
+    if (!surface_) {
+        res->make_list(0);
+        return;
+    }
+    for (int i = 0; i < ST7789V_TILES; i++) {
+        upd[i] = dirty_[i];
+        if (upd[i]) {
+            dirty_[i] = 0;
+            cnt++;
+        }
+    }
+    RISCV_memory_barrier();
+
+    uint32_t back = surface_->front ^ 1;
+    uint32_t *dst = surface_->buffer(back);
+    res->make_list(cnt);
+    cnt = 0;
+    for (int i = 0; i < ST7789V_TILES; i++) {
+        if (upd[i] || dirtyPrev_[i]) {
+            int col = (i / ST7789V_TILES_Y) * DISPLAY_TILE_SIZE;
+            int row = (i % ST7789V_TILES_Y) * DISPLAY_TILE_SIZE;
+            for (int n = 0; n < DISPLAY_TILE_SIZE; n++) {
+                int off = (col + n) * ST7789V_HEIGHT + row;
+                memcpy(&dst[off], &frame_[off],
+                       DISPLAY_TILE_SIZE * sizeof(uint32_t));
+            }
+        }
+        if (upd[i]) {
+            (*res)[cnt++].make_int64(i);
+        }
+        dirtyPrev_[i] = upd[i];
+    }
+    RISCV_memory_barrier();
+    surface_->front = back;
 }
 
 
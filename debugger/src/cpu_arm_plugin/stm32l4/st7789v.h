@@ -32,6 +32,9 @@ namespace debugger {
 
 static const int ST7789V_WIDTH  = 320;
 static const int ST7789V_HEIGHT = 240;
+static const int ST7789V_TILES_Y = ST7789V_HEIGHT / DISPLAY_TILE_SIZE;
+static const int ST7789V_TILES = ST7789V_TILES_Y
+                               * (ST7789V_WIDTH / DISPLAY_TILE_SIZE);
 
 class ST7789VCmdType : public GenericDisplayCmdType {
  public:
@@ -43,6 +46,8 @@ class ST7789VCmdType : public GenericDisplayCmdType {
     virtual int getHeight() { return ST7789V_HEIGHT; }
     virtual uint32_t getBkgColor() { return 0; }
     virtual void getFrame(AttributeType *res, bool diff);
+    virtual const char *getSurfaceName();
+    virtual void publishFrame(AttributeType *res);
 
  protected:
     int last_pixel_;
@@ -149,6 +154,7 @@ class ST7789V : public IService,
     void processCommand();
 
     void iled_setpixel(uint32_t rgb);
+    void publishFrame(AttributeType *res);
 
     /** Actions */
     void caset();
@@ -180,6 +186,13 @@ class ST7789V : public IService,
     uint8_t cmdBufPos_;
     uint32_t frame_[ST7789V_HEIGHT * ST7789V_WIDTH];
     int last_modified_pixel_;
+
+    AttributeType surfaceName_;
+    sharemem_def shm_;
+    DisplaySurfaceType *surface_;
+    int surfaceSize_;
+    volatile uint8_t dirty_[ST7789V_TILES];     // modified since publishing
+    uint8_t dirtyPrev_[ST7789V_TILES];          // missed in back buffer
 };
 /*----------------------------------------------------------------------------*/
 
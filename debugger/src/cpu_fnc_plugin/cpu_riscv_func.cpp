@@ -25,6 +25,7 @@ namespace debugger {
 CpuRiver_Functional::CpuRiver_Functional(const char *name) :
     CpuGeneric(name) {
     registerInterface(static_cast<ICpuRiscV *>(this));
+    registerInterface(static_cast<IIrqListener *>(this));
     registerAttribute("VendorID", &vendorid_);
     registerAttribute("ImplementationID", &implementationid_);
     registerAttribute("ContextID", &contextid_);
@@ -32,12 +33,32 @@ CpuRiver_Functional::CpuRiver_Functional(const char *name) :
     registerAttribute("ListExtISA", &listExtISA_);
     registerAttribute("CLINT", &clint_);
     registerAttribute("PLIC", &plic_);
+    registerAttribute("BlockCacheSize", &blockCacheSize_);
+    registerAttribute("FpuMode", &fpuMode_);
+    registerAttribute("MulMode", &mulMode_);
+
+    fpuMode_.make_string("Reference");
+    mulMode_.make_string("Native");
 
     mmuReservatedAddr_ = 0;
     mmuReservedAddrWatchdog_ = 0;
+    irqLines_.val = 0;
+    irqPolling_ = true;
+    decode32_ = 0;
+    blocks_ = 0;
+    blockCacheMask_ = 0;
+    blockEpoch_ = 1;
+    blockRec_ = 0;
+    blockRecNpc_ = 0;
 }
 
 CpuRiver_Functional::~CpuRiver_Functional() {
+    if (decode32_) {
+        delete [] decode32_;
+    }
+    if (blocks_) {
+        delete [] blocks_;
+    }
 }
 
 void CpuRiver_Functional::postinitService() {
@@ -60,6 +81,18 @@ void CpuRiver_Functional::postinitService() {
             addIsaExtensionM();
         }
     }
+    buildDecoder();
+
+    // Translation blocks cache size should be power of 2
+    if (blockCacheSize_.to_int() > 0) {
+        uint32_t sz = 1;
+        while (sz < blockCacheSize_.to_uint32()) {
+            sz <<= 1;
+        }
+        blockCacheMask_ = sz - 1;
+        blocks_ = new BlockType[sz];
+        memset(blocks_, 0, sz * sizeof(BlockType));
+    }
 
     // Power-on
     reset(0);
@@ -80,6 +113,23 @@ void CpuRiver_Functional::postinitService() {
                     clint_.to_string());
     }
 
+    if (iirqloc_ && iirqext_) {
+        IIrqListener *ilstn = static_cast<IIrqListener *>(this);
+        int hartid = hartid_.to_int();
+        irqPolling_ = false;
+        if (!iirqloc_->registerIrqListener(2*hartid, ilstn,
+                                           IrqLine_Software)) {
+            irqPolling_ = true;
+        }
+        if (!iirqloc_->registerIrqListener(2*hartid + 1, ilstn,
+                                           IrqLine_Timer)) {
+            irqPolling_ = true;
+        }
+        if (!iirqext_->registerIrqListener(0, ilstn, IrqLine_External)) {
+            irqPolling_ = true;
+        }
+    }
+
     pcmd_br_ = new CmdBrRiscv(dmibar_.to_uint64(), 0);
     icmdexec_->registerCommand(static_cast<ICommand *>(pcmd_br_));
 
@@ -150,6 +200,9 @@ void CpuRiver_Functional::handleInterrupts() {
     int ctx = 0;
     csr_mcause_type mcause;
     csr_mstatus_type mstatus;
+    if (!irqPolling_ && irqLines_.val == 0) {
+        return;
+    }
     mstatus.value = readCSR(CSR_mstatus);
     if (mstatus.bits.MIE == 0) {
         return;
@@ -161,7 +214,8 @@ void CpuRiver_Functional::handleInterrupts() {
     // Check software interrupt
     mcause.value = 0;
     if (mie.bits.MSIE == 1) {
-        if (iirqloc_->getPendingRequest(2*hartid_.to_int())) {
+        if (irqPolling_ ? iirqloc_->getPendingRequest(2*hartid_.to_int())
+                        : irqLines_.line[IrqLine_Software]) {
             mcause.bits.irq = 1;
             mcause.bits.code = 3;
         }
@@ -169,7 +223,8 @@ void CpuRiver_Functional::handleInterrupts() {
 
     // Check mtimer interrupt
     if (!mcause.bits.irq && mie.bits.MTIE == 1) {
-        if (iirqloc_->getPendingRequest(2*hartid_.to_int() + 1)) {
+        if (irqPolling_ ? iirqloc_->getPendingRequest(2*hartid_.to_int() + 1)
+                        : irqLines_.line[IrqLine_Timer]) {
             mcause.bits.irq = 1;
             mcause.bits.code = 7;
         }
@@ -178,7 +233,8 @@ void CpuRiver_Functional::handleInterrupts() {
     // Check PLIC interrupt request
     if (!mcause.bits.irq && mie.bits.MEIE == 1) {
         // external interrupt disabled
-        int irqidx = iirqext_->getPendingRequest(ctx);
+        int irqidx = irqPolling_ ? iirqext_->getPendingRequest(ctx)
+                                 : irqLines_.line[IrqLine_External];
         if (irqidx != IRQ_REQUEST_NONE) {
             mcause.bits.irq = 1;
             mcause.bits.code = 11;
@@ -234,28 +290,118 @@ void CpuRiver_Functional::reset(IFace *isource) {
     mmuReservedAddrWatchdog_ = 0;
 }
 
-GenericInstruction *CpuRiver_Functional::decodeInstruction(Reg64Type *cache) {
-    RiscvInstruction *instr = NULL;
-    int hash_idx = hash32(cacheline_[0].buf32[0]);
-    for (unsigned i = 0; i < listInstr_[hash_idx].size(); i++) {
-        instr = static_cast<RiscvInstruction *>(
-                        listInstr_[hash_idx][i].to_iface());
-        if (instr->parse(cacheline_[0].buf32)) {
+/**
+ * Convert registered instruction lists into lookup tables:
+ *   - 32-bits instructions are indexed by opcode, funct3 and funct7 fields
+ *     so that only a few candidates (usually one) should be checked;
+ *   - 16-bits compressed instructions are indexed by the whole opcode value.
+ * Candidates keep the registration order so the result is the same as for
+ * sequential search in the hash lists.
+ */
+void CpuRiver_Functional::buildDecoder() {
+    const uint32_t KEY_BITS = 0xFE00707F;
+    RiscvInstruction *instr;
+    uint32_t keyval;
+    unsigned total = 1;     // reserve one empty list for the illegal opcodes
+    AttributeType *plist;
+
+    // Pass 1: count all candidates
+    for (int k = 0; k < DECODE32_KEY_TOTAL; k++) {
+        plist = &listInstr_[hash32(static_cast<uint32_t>(k) << 2)];
+        keyval = ((k & 0x1F) << 2) | ((k & 0xE0) << 7) | ((k & 0x7F00) << 17)
+               | 0x3;
+        for (unsigned i = 0; i < plist->size(); i++) {
+            instr = static_cast<RiscvInstruction *>((*plist)[i].to_iface());
+            if (((keyval ^ instr->opcode()) & instr->mask() & KEY_BITS) == 0) {
+                total++;
+            }
+        }
+        total++;
+    }
+
+    // Pass 2: fill lists and re-use identical list of the previous funct7
+    if (decode32_) {
+        delete [] decode32_;
+    }
+    decode32_ = new DecodeEntryType[total];
+    memset(decode32_, 0, total * sizeof(DecodeEntryType));
+    unsigned cnt = 1;
+    for (int k = 0; k < DECODE32_KEY_TOTAL; k++) {
+        plist = &listInstr_[hash32(static_cast<uint32_t>(k) << 2)];
+        keyval = ((k & 0x1F) << 2) | ((k & 0xE0) << 7) | ((k & 0x7F00) << 17)
+               | 0x3;
+        DecodeEntryType *pstart = &decode32_[cnt];
+        for (unsigned i = 0; i < plist->size(); i++) {
+            instr = static_cast<RiscvInstruction *>((*plist)[i].to_iface());
+            if (((keyval ^ instr->opcode()) & instr->mask() & KEY_BITS) == 0) {
+                decode32_[cnt].mask = instr->mask();
+                decode32_[cnt].opcode = instr->opcode();
+                decode32_[cnt].instr = instr;
+                cnt++;
+            }
+        }
+        decode32_[cnt++].instr = 0;
+        decodeIdx32_[k] = static_cast<uint32_t>(pstart - decode32_);
+
+        if (k >= 0x100) {
+            DecodeEntryType *pprev = &decode32_[decodeIdx32_[k - 0x100]];
+            DecodeEntryType *pcur = pstart;
+            while (pprev->instr && pprev->instr == pcur->instr) {
+                pprev++;
+                pcur++;
+            }
+            if (pprev->instr == 0 && pcur->instr == 0) {
+                decodeIdx32_[k] = decodeIdx32_[k - 0x100];
+                cnt = static_cast<unsigned>(pstart - decode32_);
+            }
+        }
+    }
+
+    // Compressed instructions
+    int cnt16 = 1;
+    memset(decode16_, 0, sizeof(decode16_));
+    memset(decodeIdx16_, 0, sizeof(decodeIdx16_));
+    for (int i = 0; i < DECODE16_TOTAL; i++) {
+        uint32_t payload[2] = {static_cast<uint32_t>(i), 0};
+        if ((i & 0x3) == 0x3) {
+            continue;
+        }
+        plist = &listInstr_[hash16(static_cast<uint16_t>(i))];
+        for (unsigned n = 0; n < plist->size(); n++) {
+            instr = static_cast<RiscvInstruction *>((*plist)[n].to_iface());
+            if (!instr->parse(payload)) {
+                continue;
+            }
+            int idx = 1;
+            while (idx < cnt16 && decode16_[idx] != instr) {
+                idx++;
+            }
+            if (idx == cnt16) {
+                if (cnt16 == 256) {
+                    RISCV_error("Too many compressed instructions %d", cnt16);
+                    break;
+                }
+                decode16_[cnt16++] = instr;
+            }
+            decodeIdx16_[i] = static_cast<uint8_t>(idx);
             break;
         }
-        instr = NULL;
-    }
-    // Check compressed instructions:
-    if (instr == NULL) {
-        hash_idx = hash16(cacheline_[0].buf16[0]);
-        for (unsigned i = 0; i < listInstr_[hash_idx].size(); i++) {
-            instr = static_cast<RiscvInstruction *>(
-                            listInstr_[hash_idx][i].to_iface());
-            if (instr->parse(cacheline_[0].buf32)) {
+    }
+}
+
+GenericInstruction *CpuRiver_Functional::decodeInstruction(Reg64Type *cache) {
+    RiscvInstruction *instr = NULL;
+    uint32_t op = cacheline_[0].buf32[0];
+    if ((op & 0x3) == 0x3) {
+        DecodeEntryType *p = &decode32_[decodeIdx32_[key32(op)]];
+        for (; p->instr; p++) {
+            if ((op & p->mask) == p->opcode) {
+                instr = p->instr;
                 break;
             }
-            instr = NULL;
         }
+    } else {
+        instr = decode16_[decodeIdx16_[op & 0xFFFF]];
     }
     if (mmuReservedAddrWatchdog_) {
         mmuReservedAddrWatchdog_--;
@@ -263,6 +409,126 @@ GenericInstruction *CpuRiver_Functional::decodeInstruction(Reg64Type *cache) {
     return instr;
 }
 
+void CpuRiver_Functional::flush(uint64_t addr) {
+    // Any flush request invalidates all translated blocks: they are short
+    // and such requests (fence.i, sw breakpoints) are rare.
+    blockEpoch_++;
+    blockRec_ = 0;
+    CpuGeneric::flush(addr);
+}
+
+/**
+ * Execute the whole translated block when it is available, otherwise
+ * use the generic pipeline that records new block while executing.
+ */
+void CpuRiver_Functional::updatePipeline() {
+    if (blocks_ && estate_ == CORE_Normal && !haltreq_) {
+        uint64_t npc = getNPC();
+        BlockType *blk = &blocks_[blockIndex(npc)];
+        if (blk->epoch == blockEpoch_ && blk->pc == npc
+            && !isStepEnabled() && !isTriggerArmed()) {
+            blockRec_ = 0;
+            executeBlock(blk);
+            return;
+        }
+    }
+    CpuGeneric::updatePipeline();
+}
+
+/**
+ * Run instructions one by one with the same per-step side effects as in
+ * updatePipeline() but without fetching and decoding. Block ends when the
+ * next instruction pointer doesn't follow recorded sequence (branch, trap
+ * or interrupt) or CPU state changed.
+ */
+void CpuRiver_Functional::executeBlock(BlockType *blk) {
+    uint64_t npc;
+    cachable_pc_ = false;
+    for (int i = 0; i < blk->size; i++) {
+        BlockInstrType *p = &blk->instr[i];
+        step_cnt_++;
+        setPC(getNPC());
+        branch_ = false;
+        fetch_addr_ = getPC();
+        cacheline_[0].buf32[0] = p->buf;
+        instr_ = p->instr;
+        if (mmuReservedAddrWatchdog_) {
+            mmuReservedAddrWatchdog_--;
+        }
+
+        trackContextStart();
+        oplen_ = instr_->exec(cacheline_);
+        CpuGeneric::trackContextEnd();
+        pc_z_ = getPC();
+
+        npc = getPC() + oplen_;
+        if (!branch_) {
+            setNPC(npc);
+        }
+
+        if (queue_.isPending(step_cnt_)) {
+            updateQueue();
+        }
+
+        handleTrap();
+
+        if (trace_ena_) {
+            traceStep();
+        }
+
+        if (getNPC() != npc || blk->epoch != blockEpoch_
+            || estate_ != CORE_Normal || haltreq_) {
+            break;
+        }
+    }
+}
+
+void CpuRiver_Functional::trackContextEnd() {
+    if (blocks_ && estate_ == CORE_Normal) {
+        recordBlock();
+    }
+    CpuGeneric::trackContextEnd();
+}
+
+/** Append just executed instruction to the recording block */
+void CpuRiver_Functional::recordBlock() {
+    uint64_t pc = getPC();
+    if (!instr_ || do_not_cache_) {
+        blockRec_ = 0;
+        return;
+    }
+    if (!blockRec_ || pc != blockRecNpc_ || blockRec_->epoch != blockEpoch_) {
+        blockRec_ = &blocks_[blockIndex(pc)];
+        blockRec_->pc = pc;
+        blockRec_->epoch = blockEpoch_;
+        blockRec_->size = 0;
+    }
+    BlockInstrType *p = &blockRec_->instr[blockRec_->size++];
+    p->instr = instr_;
+    p->buf = cacheline_[0].buf32[0];
+    blockRecNpc_ = pc + oplen_;
+
+    if (branch_ || exceptions_ || blockRec_->size == BLOCK_INSTR_MAX) {
+        blockRec_ = 0;
+    }
+}
+
+/** Triggers should be checked on each step so blocks cannot be used */
+bool CpuRiver_Functional::isTriggerArmed() {
+    TriggerStorageType *pt;
+    for (int i = 0; i < triggersTotal_.to_int(); i++) {
+        pt = &ptriggers_[i];
+        if (pt->data1.bitsdef.type == TriggerType_InstrCountMatch) {
+            return true;
+        }
+        if (pt->data1.bitsdef.type == TriggerType_AddrDataMatch
+            && pt->data1.mcontrol_bits.execute) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void CpuRiver_Functional::generateIllegalOpcode() {
     generateException(EXCEPTION_InstrIllegal, getPC());
     RISCV_error("Illegal instruction at 0x%08" RV_PRI64 "x", getPC());
@@ -423,6 +689,9 @@ uint64_t CpuRiver_Functional::readCSR(uint32_t regno) {
 void CpuRiver_Functional::writeCSR(uint32_t regno, uint64_t val) {
     bool wr_access = true;
     uint64_t trigidx;
+    if (estate_ == CORE_Halted) {
+        dbgEpoch_++;
+    }
     switch (regno) {
     // Read-Only registers
     case CSR_misa:
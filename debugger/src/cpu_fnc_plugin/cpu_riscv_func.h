@@ -28,7 +28,8 @@
 namespace debugger {
 
 class CpuRiver_Functional : public CpuGeneric,
-                            public ICpuRiscV {
+                            public ICpuRiscV,
+                            public IIrqListener {
  public:
     explicit CpuRiver_Functional(const char *name);
     virtual ~CpuRiver_Functional();
@@ -56,6 +57,7 @@ class CpuRiver_Functional : public CpuGeneric,
     virtual void generateExceptionLoadInstruction(uint64_t addr) override {
         generateException(EXCEPTION_InstrFault, addr);
     }
+    virtual void flush(uint64_t addr) override;
 
     /** DPort interface */
     virtual uint64_t readRegDbg(uint32_t regno) override;
@@ -65,21 +67,42 @@ class CpuRiver_Functional : public CpuGeneric,
     virtual uint64_t readCSR(uint32_t idx);
     virtual void writeCSR(uint32_t idx, uint64_t val);
     virtual uint64_t readGPR(uint32_t regno) { return R[regno]; }
-    virtual void writeGPR(uint32_t regno, uint64_t val) { R[regno] = val; }
+    virtual void writeGPR(uint32_t regno, uint64_t val) {
+        R[regno] = val;
+        dbgEpoch_++;
+    }
     virtual uint64_t readNonStandardReg(uint32_t regno) { return 0; }
     virtual void writeNonStandardReg(uint32_t regno, uint64_t val) {}
     virtual void mmuAddrReserve(uint64_t addr) override {
         mmuReservatedAddr_ = addr;
         mmuReservedAddrWatchdog_ = 64;
+        if (isched_) {
+            isched_->reserveAddr(schedSlot_, addr);
+        }
     }
     virtual bool mmuAddrRelease(uint64_t addr) override {
         bool success = 0;
         if (mmuReservedAddrWatchdog_ && mmuReservatedAddr_ == addr) {
             success = true;
             mmuReservedAddrWatchdog_ = 0;
+            // Reservation could be lost on SC or AMO of another hart
+            if (isched_) {
+                success = isched_->releaseAddr(schedSlot_, addr);
+            }
         }
         return success;
     }
+    /** AMO write breaks reservations of other harts */
+    void mmuAddrStore(uint64_t addr) {
+        if (isched_) {
+            isched_->storeAddr(schedSlot_, addr);
+        }
+    }
+
+    /** IIrqListener interface */
+    virtual void setIrqLine(int line, bool level) override {
+        irqLines_.line[line] = level ? 1 : 0;
+    }
 
  protected:
     /** CpuGeneric common methods */
@@ -92,8 +115,11 @@ class CpuRiver_Functional : public CpuGeneric,
     virtual void trackContextStart();
     /** // Stop tracking and write trace file */
     virtual void traceOutput() override;
+    virtual uint32_t traceIsa() override { return BinTraceIsa_RiscV; }
     virtual bool isStepEnabled() override;
     virtual void checkStackProtection() override;
+    virtual void updatePipeline() override;
+    virtual void trackContextEnd() override;
 
     void addIsaUserRV64I();
     void addIsaPrivilegedRV64I();
@@ -102,13 +128,19 @@ class CpuRiver_Functional : public CpuGeneric,
     void addIsaExtensionD();
     void addIsaExtensionF();
     void addIsaExtensionM();
-    unsigned addSupportedInstruction(RiscvInstruction *instr);
+    virtual unsigned addSupportedInstruction(RiscvInstruction *instr);
     uint32_t hash32(uint32_t val) { return (val >> 2) & 0x1f; }
     /** Compressed instruction */
     uint32_t hash16(uint16_t val) {
         uint32_t t1 = val & 0x3;
         return 0x20 | ((val >> 13) << 2) | t1;
     }
+    /** Decoder key: opcode[6:2], funct3[14:12], funct7[31:25] */
+    uint32_t key32(uint32_t val) {
+        return ((val >> 2) & 0x1F) | ((val >> 7) & 0xE0)
+             | ((val >> 17) & 0x7F00);
+    }
+    void buildDecoder();
 
  private:
     void switchContext(uint32_t prvnxt);
@@ -125,14 +157,74 @@ class CpuRiver_Functional : public CpuGeneric,
     static const int INSTR_HASH_TABLE_SIZE = 1 << 6;
     AttributeType listInstr_[INSTR_HASH_TABLE_SIZE];
 
+    // Lookup tables built once from the registered instructions list
+    static const int DECODE32_KEY_TOTAL = 1 << 15;
+    static const int DECODE16_TOTAL = 1 << 16;
+
+    struct DecodeEntryType {
+        uint32_t mask;
+        uint32_t opcode;
+        RiscvInstruction *instr;    // 0 ends the list of candidates
+    };
+    DecodeEntryType *decode32_;
+    uint32_t decodeIdx32_[DECODE32_KEY_TOTAL];  // key32 => decode32_ list
+    RiscvInstruction *decode16_[256];           // [0] is illegal instr.
+    uint8_t decodeIdx16_[DECODE16_TOTAL];       // opcode => decode16_ index
+
     IIrqController *iirqloc_;
     IIrqController *iirqext_;
 
+    enum EIrqLines {
+        IrqLine_Software,
+        IrqLine_Timer,
+        IrqLine_External,
+        IrqLine_Total
+    };
+    // Request levels driven by controllers. One byte per line so that
+    // controllers from other threads never do read-modify-write.
+    union IrqLinesType {
+        volatile uint8_t line[8];
+        volatile uint64_t val;
+    } irqLines_;
+    bool irqPolling_;           // controller without notifications
+
     CmdBrRiscv *pcmd_br_;
     ICommand *pcmd_cpu_;
 
     uint64_t mmuReservatedAddr_;
     int mmuReservedAddrWatchdog_;   // not exceed 64 instructions between LR/SC
+
+    AttributeType blockCacheSize_;
+    AttributeType fpuMode_;     // "Reference" bit-accurate or "Host" IEEE-754
+    AttributeType mulMode_;     // "Native" 128-bits or "Reference" RTL tree
+
+    static const int BLOCK_INSTR_MAX = 64;
+
+    struct BlockInstrType {
+        GenericInstruction *instr;
+        uint32_t buf;               // opcode value for the tracer and halt()
+    };
+
+    // Straight-line run of the decoded instructions started from 'pc'
+    struct BlockType {
+        uint64_t pc;
+        uint64_t epoch;             // block is valid if equal blockEpoch_
+        int size;
+        BlockInstrType instr[BLOCK_INSTR_MAX];
+    } *blocks_;
+    uint32_t blockCacheMask_;
+    uint64_t blockEpoch_;           // incremented on each flush
+    BlockType *blockRec_;           // block that is recording now
+    uint64_t blockRecNpc_;          // expected pc of the next recorded instr
+
+ private:
+    /** Translation blocks cache */
+    uint32_t blockIndex(uint64_t pc) {
+        return static_cast<uint32_t>(pc >> 1) & blockCacheMask_;
+    }
+    bool isTriggerArmed();
+    void recordBlock();
+    void executeBlock(BlockType *blk);
 };
 
 DECLARE_CLASS(CpuRiver_Functional)
@@ -30,7 +30,8 @@ DmiFunctional::DmiFunctional(const char *name)
     abstractauto(this, "abstractauto", 0x18*sizeof(uint32_t)),
     progbuf(this, "progbuf", 0x20*sizeof(uint32_t)),
     sbcs(this, "sbcs", 0x38*sizeof(uint32_t)),
-    haltsum0(this, "haltsum0", 0x40*sizeof(uint32_t)) {
+    haltsum0(this, "haltsum0", 0x40*sizeof(uint32_t)),
+    regsnapshot(this, "regsnapshot", 0x100*sizeof(uint32_t)) {
 
     registerInterface(static_cast<IDmi *>(this));
 
@@ -42,6 +43,9 @@ DmiFunctional::DmiFunctional(const char *name)
     registerAttribute("HartList", &hartlist_);
 
     phartdata_ = 0;
+    snapshotValid_ = false;
+    snapshotHart_ = 0;
+    snapshotEpoch_ = 0;
 }
 
 DmiFunctional::~DmiFunctional() {
@@ -57,6 +61,12 @@ void DmiFunctional::postinitService() {
     databuf.setRegTotal(dataregTotal_.to_int());
     progbuf.setRegTotal(progbufTotal_.to_int());
 
+    int regtotal = 0;
+    while (RISCV_DEBUG_REG_MAP[regtotal].name[0]) {
+        regtotal++;
+    }
+    regsnapshot.setRegTotal(1 + regtotal);
+
     ibus_ = static_cast<IMemoryOperation *>(
             RISCV_get_service_iface(sysbus_.to_string(),
                                     IFACE_MEMORY_OPERATION));
@@ -131,5 +141,39 @@ bool DmiFunctional::isCommandBusy() {
     return ret;
 }
 
+/**
+ * Registers are read from the CPU only once per halt epoch, any following
+ * request returns the stored copy. Running hart is read directly.
+ */
+uint64_t DmiFunctional::readRegSnapshot(int idx) {
+    uint32_t hartsel = getHartSelected();
+    IDPort *idport = phartdata_[hartsel].idport;
+    Reg64Type *snapshot = regsnapshot.getp();
+    int total = static_cast<int>(regsnapshot.getLength() / sizeof(Reg64Type));
+    if (idx == 0) {
+        return static_cast<uint64_t>(total - 1);
+    }
+    if (!idport) {
+        return 0;
+    }
+    if (!idport->isHalted()) {
+        snapshotValid_ = false;
+        return idport->readRegDbg(RISCV_DEBUG_REG_MAP[idx - 1].offset);
+    }
+
+    uint64_t epoch = idport->getDebugEpoch();
+    if (!snapshotValid_ || snapshotHart_ != hartsel
+        || snapshotEpoch_ != epoch) {
+        for (int i = 1; i < total; i++) {
+            snapshot[i].val =
+                idport->readRegDbg(RISCV_DEBUG_REG_MAP[i - 1].offset);
+        }
+        snapshotValid_ = true;
+        snapshotHart_ = hartsel;
+        snapshotEpoch_ = epoch;
+    }
+    return snapshot[idx].val;
+}
+
 }  // namespace debugger
 
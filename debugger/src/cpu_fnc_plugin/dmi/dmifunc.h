@@ -110,6 +110,8 @@ class DmiFunctional : public RegMemBankGeneric,
 
     virtual bool isSbaBusy() { return false; }
 
+    virtual uint64_t readRegSnapshot(int idx);
+
 
  private:
     AttributeType sysbus_;
@@ -126,6 +128,11 @@ class DmiFunctional : public RegMemBankGeneric,
         bool resumeack;
     } *phartdata_;
 
+    // Snapshot is valid while the hart stays halted with the same epoch
+    bool snapshotValid_;
+    uint32_t snapshotHart_;
+    uint64_t snapshotEpoch_;
+
     static const unsigned DM_STATE_IDLE = 0;
     static const unsigned DM_STATE_ACCESS = 1;
 
@@ -182,6 +189,7 @@ class DmiFunctional : public RegMemBankGeneric,
     PROGBUF_TYPE progbuf;       // 0x20..0x2f
     SBCS_TYPE sbcs;
     HALTSUM0_TYPE haltsum0;     // 0x40
+    REGSNAPSHOT_TYPE regsnapshot;   // 0x100.. non-standard
 };
 
 DECLARE_CLASS(DmiFunctional)
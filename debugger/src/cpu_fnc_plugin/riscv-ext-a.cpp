@@ -48,6 +48,7 @@ public:
         trans.action = MemAction_Read;
         trans.addr = R[u.bits.rs1];
         trans.xsize = rvbytes_;
+        icpu_->lockAtomic();
         if (trans.addr & (rvbytes_ - 1)) {
             trans.rpayload.b64[0] = 0;
             // AMO always should generate Store exceptions (spike)
@@ -71,10 +72,13 @@ public:
                 trans.wpayload.b64[0] = amo_op(R[u.bits.rs2], t);
                 if (icpu_->dma_memop(&trans) == TRANS_ERROR) {
                     icpu_->generateException(EXCEPTION_StoreFault, trans.addr);
+                } else {
+                    icpu_->mmuAddrStore(trans.addr);
                 }
                 icpu_->setReg(u.bits.rd, t);
             }
         }
+        icpu_->unlockAtomic();
         return 4;
     }
  protected:
@@ -314,6 +318,7 @@ public:
         trans.action = MemAction_Read;
         trans.addr = R[u.bits.rs1];
         trans.xsize = 4;
+        icpu_->lockAtomic();
         if (trans.addr & (trans.xsize - 1)) {
             trans.rpayload.b64[0] = 0;
             icpu_->generateException(EXCEPTION_LoadMisalign, icpu_->getPC());
@@ -330,6 +335,7 @@ public:
                 icpu_->setReg(u.bits.rd, t);
             }
         }
+        icpu_->unlockAtomic();
         return 4;
     }
 };
@@ -346,6 +352,7 @@ public:
         trans.action = MemAction_Read;
         trans.addr = R[u.bits.rs1];
         trans.xsize = 8;
+        icpu_->lockAtomic();
         if (trans.addr & (trans.xsize - 1)) {
             trans.rpayload.b64[0] = 0;
             icpu_->generateException(EXCEPTION_LoadMisalign, icpu_->getPC());
@@ -357,6 +364,7 @@ public:
                 icpu_->setReg(u.bits.rd, trans.rpayload.b32[0]);
             }
         }
+        icpu_->unlockAtomic();
         return 4;
     }
 };
@@ -371,6 +379,7 @@ public:
         ISA_R_type u;
         u.value = payload->buf32[0];
         bool error = 1;
+        icpu_->lockAtomic();
         if (icpu_->mmuAddrRelease(R[u.bits.rs1])) {
             trans.action = MemAction_Write;
             trans.addr = R[u.bits.rs1];
@@ -387,6 +396,7 @@ public:
                 }
             }
         }
+        icpu_->unlockAtomic();
         icpu_->setReg(u.bits.rd, error);    // success
         return 4;
     }
@@ -402,6 +412,7 @@ public:
         ISA_R_type u;
         u.value = payload->buf32[0];
         bool error = 1;
+        icpu_->lockAtomic();
         if (icpu_->mmuAddrRelease(R[u.bits.rs1])) {
             trans.action = MemAction_Write;
             trans.addr = R[u.bits.rs1];
@@ -418,6 +429,7 @@ public:
                 }
             }
         }
+        icpu_->unlockAtomic();
         icpu_->setReg(u.bits.rd, error);    // success
         return 4;
     }
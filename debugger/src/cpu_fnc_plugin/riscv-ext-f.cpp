@@ -19,6 +19,9 @@
 #include "api_core.h"
 #include "riscv-isa.h"
 #include "cpu_riscv_func.h"
+#include <cfenv>
+#include <cmath>
+#include <string.h>
 
 namespace debugger {
 
@@ -1653,28 +1656,527 @@ class FSUB_D : public FpuInstruction {
     }
 };
 
+/**
+ * Host IEEE-754 mode. Arithmetic is executed by the host FPU with the
+ * rounding mode of the instruction and fflags are taken from the host
+ * exception flags. Results may differ from RTL in the tininess detection
+ * and RMM is executed as RNE (host has no ties-to-max-magnitude mode).
+ */
+class FpuHostInstruction : public RiscvInstruction {
+ public:
+    FpuHostInstruction(CpuRiver_Functional *icpu, const char *name,
+                       const char *bits)
+        : RiscvInstruction(icpu, name, bits) {}
+
+ protected:
+    static const uint64_t CANONICAL_NAN = 0x7FF8000000000000ull;
+    enum ERoundingMode {
+        RM_RNE, RM_RTZ, RM_RDN, RM_RUP, RM_RMM, RM_DYN = 7
+    };
+
+    /** Returns -1 on reserved value, illegal instruction is raised */
+    int roundingMode(ISA_R_type u) {
+        int rm = u.bits.funct3;
+        if (rm == RM_DYN) {
+            csr_fcsr_type fcsr;
+            fcsr.value = icpu_->readCSR(CSR_fcsr);
+            rm = static_cast<int>(fcsr.bits.FRM);
+        }
+        if (rm > RM_RMM) {
+            icpu_->generateException(EXCEPTION_InstrIllegal, icpu_->getPC());
+            return -1;
+        }
+        return rm;
+    }
+
+    void beginHostOp(int rm) {
+        static const int HOST_RM[5] = {
+            FE_TONEAREST, FE_TOWARDZERO, FE_DOWNWARD, FE_UPWARD, FE_TONEAREST
+        };
+        fesetround(HOST_RM[rm]);
+        feclearexcept(FE_ALL_EXCEPT);
+    }
+
+    void endHostOp() {
+        int except = fetestexcept(FE_ALL_EXCEPT);
+        fesetround(FE_TONEAREST);
+        if (except == 0) {
+            return;
+        }
+        csr_fcsr_type fcsr;
+        fcsr.value = icpu_->readCSR(CSR_fcsr);
+        fcsr.bits.NX |= (except & FE_INEXACT) ? 1 : 0;
+        fcsr.bits.UF |= (except & FE_UNDERFLOW) ? 1 : 0;
+        fcsr.bits.OF |= (except & FE_OVERFLOW) ? 1 : 0;
+        fcsr.bits.DZ |= (except & FE_DIVBYZERO) ? 1 : 0;
+        fcsr.bits.NV |= (except & FE_INVALID) ? 1 : 0;
+        icpu_->writeCSR(CSR_fcsr, fcsr.value);
+    }
+
+    void raiseFlags(bool nv, bool nx) {
+        csr_fcsr_type fcsr;
+        fcsr.value = icpu_->readCSR(CSR_fcsr);
+        fcsr.bits.NV |= nv ? 1 : 0;
+        fcsr.bits.NX |= nx ? 1 : 0;
+        icpu_->writeCSR(CSR_fcsr, fcsr.value);
+    }
+
+    bool isNaN(Reg64Type v) {
+        return v.f64bits.exp == 0x7FF && (v.val & 0x000FFFFFFFFFFFFFull);
+    }
+
+    bool isSignalingNaN(Reg64Type v) {
+        return isNaN(v) && !(v.val & 0x0008000000000000ull);
+    }
+
+    /**
+     * Volatile operands and result keep the operation between the fenv
+     * calls, otherwise it may be folded or moved past fetestexcept().
+     */
+    int execArith(Reg64Type *payload, int op) {
+        ISA_R_type u;
+        Reg64Type dest;
+        volatile double a, b, res;
+        u.value = payload->buf32[0];
+        int rm = roundingMode(u);
+        if (rm < 0) {
+            return 4;
+        }
+        Reg64Type src1, src2;
+        src1.val = RF[u.bits.rs1];
+        src2.val = RF[u.bits.rs2];
+        a = src1.f64;
+        b = src2.f64;
+        beginHostOp(rm);
+        switch (op) {
+        case 0: res = a + b; break;
+        case 1: res = a - b; break;
+        case 2: res = a * b; break;
+        default: res = a / b;
+        }
+        endHostOp();
+        dest.f64 = res;
+        if (isNaN(dest)) {
+            dest.val = CANONICAL_NAN;
+        }
+        icpu_->setReg(RegFpu_Offset + u.bits.rd, dest.val);
+        return 4;
+    }
+
+    /** Integer operand is rounded with the instruction rounding mode */
+    int execInt2Double(Reg64Type *payload, bool sign, bool w32) {
+        ISA_R_type u;
+        Reg64Type src1, dest;
+        u.value = payload->buf32[0];
+        int rm = roundingMode(u);
+        if (rm < 0) {
+            return 4;
+        }
+        src1.val = R[u.bits.rs1];
+        volatile int64_t ival = static_cast<int64_t>(src1.val);
+        volatile uint64_t uval = src1.val;
+        volatile double res;
+        if (w32) {
+            ival = static_cast<int32_t>(src1.buf32[0]);
+            uval = src1.buf32[0];
+        }
+        beginHostOp(rm);
+        if (sign) {
+            res = static_cast<double>(ival);
+        } else {
+            res = static_cast<double>(uval);
+        }
+        endHostOp();
+        dest.f64 = res;
+        icpu_->setReg(RegFpu_Offset + u.bits.rd, dest.val);
+        return 4;
+    }
+
+    /**
+     * Out of range values and NaN saturate with NV flag, in-range
+     * results raise NX only when rounding changed the value.
+     */
+    int execDouble2Int(Reg64Type *payload, bool sign, bool w32) {
+        ISA_R_type u;
+        Reg64Type src1, dest;
+        u.value = payload->buf32[0];
+        int rm = roundingMode(u);
+        if (rm < 0) {
+            return 4;
+        }
+        src1.val = RF[u.bits.rs1];
+        double x = src1.f64;
+        double r = x;
+        switch (rm) {
+        case RM_RTZ: r = trunc(x); break;
+        case RM_RDN: r = floor(x); break;
+        case RM_RUP: r = ceil(x); break;
+        case RM_RMM: r = round(x); break;
+        default: r = nearbyint(x);
+        }
+
+        // Bounds as exact doubles: [lo, hi)
+        double lo, hi;
+        uint64_t minval, maxval;
+        if (w32) {
+            lo = sign ? -2147483648.0 : 0.0;
+            hi = sign ? 2147483648.0 : 4294967296.0;
+            minval = sign ? 0xFFFFFFFF80000000ull : 0;
+            maxval = sign ? 0x000000007FFFFFFFull : 0xFFFFFFFFFFFFFFFFull;
+        } else {
+            lo = sign ? -9223372036854775808.0 : 0.0;
+            hi = sign ? 9223372036854775808.0 : 18446744073709551616.0;
+            minval = sign ? 0x8000000000000000ull : 0;
+            maxval = sign ? 0x7FFFFFFFFFFFFFFFull : 0xFFFFFFFFFFFFFFFFull;
+        }
+
+        if (isNaN(src1)) {
+            dest.val = maxval;
+            raiseFlags(true, false);
+        } else if (r < lo) {
+            dest.val = minval;
+            raiseFlags(true, false);
+        } else if (r >= hi) {
+            dest.val = maxval;
+            raiseFlags(true, false);
+        } else {
+            if (sign) {
+                dest.val = static_cast<uint64_t>(static_cast<int64_t>(r));
+            } else {
+                dest.val = static_cast<uint64_t>(r);
+            }
+            if (w32) {
+                // 32-bits results are sign-extended for both W and WU
+                dest.val = static_cast<uint64_t>(
+                    static_cast<int64_t>(static_cast<int32_t>(dest.val)));
+            }
+            if (r != x) {
+                raiseFlags(false, true);
+            }
+        }
+        icpu_->setReg(u.bits.rd, dest.val);
+        return 4;
+    }
+
+    /** FEQ signals NV on signaling NaN only, FLT/FLE on any NaN */
+    int execCompare(Reg64Type *payload, int op) {
+        ISA_R_type u;
+        Reg64Type src1, src2;
+        uint64_t res = 0;
+        u.value = payload->buf32[0];
+        src1.val = RF[u.bits.rs1];
+        src2.val = RF[u.bits.rs2];
+        if (isNaN(src1) || isNaN(src2)) {
+            if (op != 0 || isSignalingNaN(src1) || isSignalingNaN(src2)) {
+                raiseFlags(true, false);
+            }
+        } else {
+            switch (op) {
+            case 0: res = src1.f64 == src2.f64 ? 1 : 0; break;
+            case 1: res = src1.f64 < src2.f64 ? 1 : 0; break;
+            default: res = src1.f64 <= src2.f64 ? 1 : 0;
+            }
+        }
+        icpu_->setReg(u.bits.rd, res);
+        return 4;
+    }
+
+    /** NaN operand returns the other one, -0.0 is less than +0.0 */
+    int execMinMax(Reg64Type *payload, bool max) {
+        ISA_R_type u;
+        Reg64Type src1, src2, dest;
+        u.value = payload->buf32[0];
+        src1.val = RF[u.bits.rs1];
+        src2.val = RF[u.bits.rs2];
+        if (isSignalingNaN(src1) || isSignalingNaN(src2)) {
+            raiseFlags(true, false);
+        }
+        if (isNaN(src1) && isNaN(src2)) {
+            dest.val = CANONICAL_NAN;
+        } else if (isNaN(src1)) {
+            dest = src2;
+        } else if (isNaN(src2)) {
+            dest = src1;
+        } else if (src1.f64 == src2.f64) {
+            // Equal values differ only in sign of zero
+            if (max) {
+                dest.val = src1.val & src2.val;
+            } else {
+                dest.val = src1.val | src2.val;
+            }
+        } else if ((src1.f64 > src2.f64) == max) {
+            dest = src1;
+        } else {
+            dest = src2;
+        }
+        icpu_->setReg(RegFpu_Offset + u.bits.rd, dest.val);
+        return 4;
+    }
+};
+
+/**
+ * @brief The FADD.D executed by the host FPU
+ */
+class FADD_D_Host : public FpuHostInstruction {
+ public:
+    FADD_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FADD_D", "0000001??????????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execArith(payload, 0);
+    }
+};
+
+/**
+ * @brief The FSUB.D executed by the host FPU
+ */
+class FSUB_D_Host : public FpuHostInstruction {
+ public:
+    FSUB_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FSUB_D", "0000101??????????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execArith(payload, 1);
+    }
+};
+
+/**
+ * @brief The FMUL.D executed by the host FPU
+ */
+class FMUL_D_Host : public FpuHostInstruction {
+ public:
+    FMUL_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FMUL_D", "0001001??????????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execArith(payload, 2);
+    }
+};
+
+/**
+ * @brief The FDIV.D executed by the host FPU
+ */
+class FDIV_D_Host : public FpuHostInstruction {
+ public:
+    FDIV_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FDIV_D", "0001101??????????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execArith(payload, 3);
+    }
+};
+
+/**
+ * @brief The FEQ.D executed by the host FPU
+ */
+class FEQ_D_Host : public FpuHostInstruction {
+ public:
+    FEQ_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FEQ_D", "1010001??????????010?????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execCompare(payload, 0);
+    }
+};
+
+/**
+ * @brief The FLT.D executed by the host FPU
+ */
+class FLT_D_Host : public FpuHostInstruction {
+ public:
+    FLT_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FLT_D", "1010001??????????001?????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execCompare(payload, 1);
+    }
+};
+
+/**
+ * @brief The FLE.D executed by the host FPU
+ */
+class FLE_D_Host : public FpuHostInstruction {
+ public:
+    FLE_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FLE_D", "1010001??????????000?????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execCompare(payload, 2);
+    }
+};
+
+/**
+ * @brief The FMIN.D executed by the host FPU
+ */
+class FMIN_D_Host : public FpuHostInstruction {
+ public:
+    FMIN_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FMIN_D", "0010101??????????000?????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execMinMax(payload, false);
+    }
+};
+
+/**
+ * @brief The FMAX.D executed by the host FPU
+ */
+class FMAX_D_Host : public FpuHostInstruction {
+ public:
+    FMAX_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FMAX_D", "0010101??????????001?????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execMinMax(payload, true);
+    }
+};
+
+/**
+ * @brief The FCVT.D.L executed by the host FPU
+ */
+class FCVT_D_L_Host : public FpuHostInstruction {
+ public:
+    FCVT_D_L_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_D_L", "110100100010?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execInt2Double(payload, true, false);
+    }
+};
+
+/**
+ * @brief The FCVT.D.LU executed by the host FPU
+ */
+class FCVT_D_LU_Host : public FpuHostInstruction {
+ public:
+    FCVT_D_LU_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_D_LU", "110100100011?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execInt2Double(payload, false, false);
+    }
+};
+
+/**
+ * @brief The FCVT.D.W executed by the host FPU
+ */
+class FCVT_D_W_Host : public FpuHostInstruction {
+ public:
+    FCVT_D_W_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_D_W", "110100100000?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execInt2Double(payload, true, true);
+    }
+};
+
+/**
+ * @brief The FCVT.D.WU executed by the host FPU
+ */
+class FCVT_D_WU_Host : public FpuHostInstruction {
+ public:
+    FCVT_D_WU_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_D_WU", "110100100001?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execInt2Double(payload, false, true);
+    }
+};
+
+/**
+ * @brief The FCVT.L.D executed by the host FPU
+ */
+class FCVT_L_D_Host : public FpuHostInstruction {
+ public:
+    FCVT_L_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_L_D", "110000100010?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execDouble2Int(payload, true, false);
+    }
+};
+
+/**
+ * @brief The FCVT.LU.D executed by the host FPU
+ */
+class FCVT_LU_D_Host : public FpuHostInstruction {
+ public:
+    FCVT_LU_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_LU_D", "110000100011?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execDouble2Int(payload, false, false);
+    }
+};
+
+/**
+ * @brief The FCVT.W.D executed by the host FPU
+ */
+class FCVT_W_D_Host : public FpuHostInstruction {
+ public:
+    FCVT_W_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_W_D", "110000100000?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execDouble2Int(payload, true, true);
+    }
+};
+
+/**
+ * @brief The FCVT.WU.D executed by the host FPU
+ */
+class FCVT_WU_D_Host : public FpuHostInstruction {
+ public:
+    FCVT_WU_D_Host(CpuRiver_Functional *icpu) : FpuHostInstruction(icpu,
+        "FCVT_WU_D", "110000100001?????????????1010011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        return execDouble2Int(payload, false, true);
+    }
+};
+
 void CpuRiver_Functional::addIsaExtensionD() {
-    addSupportedInstruction(new FADD_D(this));
-    addSupportedInstruction(new FCVT_D_L(this));
-    addSupportedInstruction(new FCVT_D_LU(this));
-    addSupportedInstruction(new FCVT_D_W(this));
-    addSupportedInstruction(new FCVT_D_WU(this));
-    addSupportedInstruction(new FCVT_L_D(this));
-    addSupportedInstruction(new FCVT_LU_D(this));
-    addSupportedInstruction(new FCVT_W_D(this));
-    addSupportedInstruction(new FCVT_WU_D(this));
-    addSupportedInstruction(new FDIV_D(this));
-    addSupportedInstruction(new FEQ_D(this));
+    if (strcmp(fpuMode_.to_string(), "Host") == 0) {
+        addSupportedInstruction(new FADD_D_Host(this));
+        addSupportedInstruction(new FCVT_D_L_Host(this));
+        addSupportedInstruction(new FCVT_D_LU_Host(this));
+        addSupportedInstruction(new FCVT_D_W_Host(this));
+        addSupportedInstruction(new FCVT_D_WU_Host(this));
+        addSupportedInstruction(new FCVT_L_D_Host(this));
+        addSupportedInstruction(new FCVT_LU_D_Host(this));
+        addSupportedInstruction(new FCVT_W_D_Host(this));
+        addSupportedInstruction(new FCVT_WU_D_Host(this));
+        addSupportedInstruction(new FDIV_D_Host(this));
+        addSupportedInstruction(new FEQ_D_Host(this));
+        addSupportedInstruction(new FLE_D_Host(this));
+        addSupportedInstruction(new FLT_D_Host(this));
+        addSupportedInstruction(new FMAX_D_Host(this));
+        addSupportedInstruction(new FMIN_D_Host(this));
+        addSupportedInstruction(new FMUL_D_Host(this));
+        addSupportedInstruction(new FSUB_D_Host(this));
+    } else {
+        addSupportedInstruction(new FADD_D(this));
+        addSupportedInstruction(new FCVT_D_L(this));
+        addSupportedInstruction(new FCVT_D_LU(this));
+        addSupportedInstruction(new FCVT_D_W(this));
+        addSupportedInstruction(new FCVT_D_WU(this));
+        addSupportedInstruction(new FCVT_L_D(this));
+        addSupportedInstruction(new FCVT_LU_D(this));
+        addSupportedInstruction(new FCVT_W_D(this));
+        addSupportedInstruction(new FCVT_WU_D(this));
+        addSupportedInstruction(new FDIV_D(this));
+        addSupportedInstruction(new FEQ_D(this));
+        addSupportedInstruction(new FLE_D(this));
+        addSupportedInstruction(new FLT_D(this));
+        addSupportedInstruction(new FMAX_D(this));
+        addSupportedInstruction(new FMIN_D(this));
+        addSupportedInstruction(new FMUL_D(this));
+        addSupportedInstruction(new FSUB_D(this));
+    }
     addSupportedInstruction(new FLD(this));
-    addSupportedInstruction(new FLE_D(this));
-    addSupportedInstruction(new FLT_D(this));
-    addSupportedInstruction(new FMAX_D(this));
-    addSupportedInstruction(new FMIN_D(this));
     addSupportedInstruction(new FMOV_D_X(this));
     addSupportedInstruction(new FMOV_X_D(this));
-    addSupportedInstruction(new FMUL_D(this));
     addSupportedInstruction(new FSD(this));
-    addSupportedInstruction(new FSUB_D(this));
 
     uint64_t isa = readCSR(CSR_misa);
     isa |= (1LL << ('D' - 'A'));
@@ -19,6 +19,10 @@
 #include "api_core.h"
 #include "riscv-isa.h"
 #include "cpu_riscv_func.h"
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace debugger {
 
@@ -512,6 +516,95 @@ class MULHU : public RiscvInstruction {
     }
 };
 
+/**
+ * @brief High half of the unsigned 64x64 bits product
+ *
+ * Native 128-bits multiplication is used when the compiler provides it,
+ * otherwise the product is assembled from 32-bits halves.
+ */
+static inline uint64_t mulhu64(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return __umulh(a, b);
+#else
+    uint64_t a0 = a & 0xFFFFFFFFull, a1 = a >> 32;
+    uint64_t b0 = b & 0xFFFFFFFFull, b1 = b >> 32;
+    uint64_t p00 = a0 * b0;
+    uint64_t p01 = a0 * b1;
+    uint64_t p10 = a1 * b0;
+    uint64_t mid = (p00 >> 32) + (p01 & 0xFFFFFFFFull) + (p10 & 0xFFFFFFFFull);
+    return a1 * b1 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+#endif
+}
+
+/**
+ * @brief MULH computed by the host multiplier
+ *
+ * Signed high half is derived from the unsigned one by subtracting the
+ * second operand for each negative operand.
+ */
+class MULH_Native : public RiscvInstruction {
+ public:
+    MULH_Native(CpuRiver_Functional *icpu)
+        : RiscvInstruction(icpu, "MULH", "0000001??????????001?????0110011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        ISA_R_type u;
+        u.value = payload->buf32[0];
+        uint64_t a1 = R[u.bits.rs1];
+        uint64_t a2 = R[u.bits.rs2];
+        uint64_t res = mulhu64(a1, a2);
+        if (a1 >> 63) {
+            res -= a2;
+        }
+        if (a2 >> 63) {
+            res -= a1;
+        }
+        icpu_->setReg(u.bits.rd, res);
+        return 4;
+    }
+};
+
+/**
+ * @brief MULHSU computed by the host multiplier
+ */
+class MULHSU_Native : public RiscvInstruction {
+ public:
+    MULHSU_Native(CpuRiver_Functional *icpu)
+        : RiscvInstruction(icpu, "MULHSU", "0000001??????????010?????0110011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        ISA_R_type u;
+        u.value = payload->buf32[0];
+        uint64_t a1 = R[u.bits.rs1];
+        uint64_t a2 = R[u.bits.rs2];
+        uint64_t res = mulhu64(a1, a2);
+        if (a1 >> 63) {
+            res -= a2;
+        }
+        icpu_->setReg(u.bits.rd, res);
+        return 4;
+    }
+};
+
+/**
+ * @brief MULHU computed by the host multiplier
+ */
+class MULHU_Native : public RiscvInstruction {
+ public:
+    MULHU_Native(CpuRiver_Functional *icpu)
+        : RiscvInstruction(icpu, "MULHU", "0000001??????????011?????0110011") {}
+
+    virtual int exec(Reg64Type *payload) {
+        ISA_R_type u;
+        u.value = payload->buf32[0];
+        icpu_->setReg(u.bits.rd, mulhu64(R[u.bits.rs1], R[u.bits.rs2]));
+        return 4;
+    }
+};
+
 /**
  * @brief The MULW 32-bits signed multiplication (RV64I)
  *
@@ -556,7 +649,7 @@ public:
         int64_t rs1 = static_cast<int64_t>(R[u.bits.rs1]);
         int64_t rs2 = static_cast<int64_t>(R[u.bits.rs2]);
         if (R[u.bits.rs2]) {
-            if (rs1 == (1ull << 63) && rs2 == -1ll) {
+            if (rs1 == (-1ll << 63) && rs2 == -1ll) {
                 // exception overflow
                 res = 0;
             } else {
@@ -615,7 +708,7 @@ public:
         int64_t rs1 = static_cast<int64_t>(a1);
         int64_t rs2 = static_cast<int64_t>(a2);
         if (a2) {
-            if (rs1 == (1ull << 63) && rs2 == -1ll) {
+            if (rs1 == (-1ll << 63) && rs2 == -1ll) {
                 // overflow exception
                 res = 0;
             } else {
@@ -659,9 +752,16 @@ void CpuRiver_Functional::addIsaExtensionM() {
     addSupportedInstruction(new DIVUW(this));
     addSupportedInstruction(new DIVW(this));
     addSupportedInstruction(new MUL(this));
-    addSupportedInstruction(new MULH(this));
-    addSupportedInstruction(new MULHSU(this));
-    addSupportedInstruction(new MULHU(this));
+    if (strcmp(mulMode_.to_string(), "Reference") == 0) {
+        // Partial products tree of the RTL multiplier
+        addSupportedInstruction(new MULH(this));
+        addSupportedInstruction(new MULHSU(this));
+        addSupportedInstruction(new MULHU(this));
+    } else {
+        addSupportedInstruction(new MULH_Native(this));
+        addSupportedInstruction(new MULHSU_Native(this));
+        addSupportedInstruction(new MULHU_Native(this));
+    }
     addSupportedInstruction(new MULW(this));
     addSupportedInstruction(new REM(this));
     addSupportedInstruction(new REMU(this));
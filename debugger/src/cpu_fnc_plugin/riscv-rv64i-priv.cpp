@@ -335,7 +335,8 @@ public:
 /** 
  * @brief FENCE_I (memory barrier)
  *
- * Not used in functional model so that cache is not modeling.
+ * Functional model doesn't model cache but it has to drop all decoded
+ * instructions and translated blocks to support self-modifying code.
  */
 class FENCE_I : public RiscvInstruction {
 public:
@@ -343,6 +344,7 @@ public:
         RiscvInstruction(icpu, "FENCE_I", "?????????????????001?????0001111") {}
 
     virtual int exec(Reg64Type *payload) {
+        icpu_->flush(~0ull);
         return 4;
     }
 };
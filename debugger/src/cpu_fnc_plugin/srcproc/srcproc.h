@@ -20,6 +20,7 @@
 #include <iclass.h>
 #include <iservice.h>
 #include "coreservices/isrccode.h"
+#include "generic/symtab_generic.h"
 
 namespace debugger {
 
@@ -51,7 +52,7 @@ public:
     virtual void clearSymbols();
 
     virtual void getSymbols(AttributeType *list) {
-        *list = symbolListSortByName_;
+        symbols_.getList(list);
     }
 
     virtual void addressToSymbol(uint64_t addr, AttributeType *info);
@@ -81,8 +82,7 @@ private:
     disasm_opcode_f tblOpcode1_[32];
     disasm_opcode16_f tblCompressed_[32];
     AttributeType brList_;
-    AttributeType symbolListSortByName_;
-    AttributeType symbolListSortByAddr_;
+    SymbolTableGeneric symbols_;
 };
 
 DECLARE_CLASS(RiscvSourceService)
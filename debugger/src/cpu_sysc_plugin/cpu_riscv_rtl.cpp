@@ -39,12 +39,14 @@ CpuRiscV_RTL::CpuRiscV_RTL(const char *name)
     registerAttribute("FreqHz", &freqHz_);
     registerAttribute("InVcdFile", &InVcdFile_);
     registerAttribute("OutVcdFile", &OutVcdFile_);
+    registerAttribute("LockstepChecker", &lockstep_);
 
     bus_.make_string("");
     freqHz_.make_uint64(1);
     fpuEnable_.make_boolean(true);
     InVcdFile_.make_string("");
     OutVcdFile_.make_string("");
+    lockstep_.make_string("");
     RISCV_event_create(&config_done_, "riscv_sysc_config_done");
     RISCV_register_hap(static_cast<IHap *>(this));
 }
@@ -122,6 +124,17 @@ void CpuRiscV_RTL::postinitService() {
     }
     core_->generateVCD(i_vcd_, o_vcd_);
 
+    if (lockstep_.size()) {
+        ILockstepChecker *ichk = static_cast<ILockstepChecker *>(
+            RISCV_get_service_iface(lockstep_.to_string(),
+                                    IFACE_LOCKSTEP_CHECKER));
+        if (!ichk) {
+            RISCV_error("ILockstepChecker interface '%s' not found",
+                        lockstep_.to_string());
+        }
+        core_->setLockstepChecker(ichk);
+    }
+
     pcmd_br_ = new CmdBrRiscv(dmibar_.to_uint64(), 0);
     icmdexec_->registerCommand(static_cast<ICommand *>(pcmd_br_));
 
@@ -227,7 +240,7 @@ void CpuRiscV_RTL::createSystemC() {
                                asyncReset_.to_bool(),
                                fpuEnable_.to_bool(),
                                coherenceEnable_.to_bool(),
-                               tracerEnable_.to_bool());
+                               tracerEnable_.to_bool() || lockstep_.size() != 0);
     core_->i_clk(wrapper_->o_clk);
     core_->i_nrst(w_sys_nrst);
     core_->i_msti(corei0);
@@ -18,6 +18,8 @@
  *                           trace files to compare them with functional model
  *             InVcdFile   - Stimulus VCD file
  *             OutVcdFile  - Reference VCD file with any number of signals
+ *             LockstepChecker - Service that compares retired instructions
+ *                           with the reference functional model in-process
  *
  * @note       When GenerateRef is true Core uses step counter instead 
  *             of clock counter to generate callbacks.
@@ -36,6 +38,7 @@
 #include "coreservices/icmdexec.h"
 #include "coreservices/itap.h"
 #include "coreservices/iirq.h"
+#include "coreservices/ilockstep.h"
 #include "cmds/cmd_br_riscv.h"
 #include "rtl_wrapper.h"
 #include "l1serdes.h"
@@ -108,6 +111,7 @@ class CpuRiscV_RTL : public IService,
     AttributeType freqHz_;
     AttributeType InVcdFile_;
     AttributeType OutVcdFile_;
+    AttributeType lockstep_;
     event_def config_done_;
 
     IIrqController *iirqloc_;
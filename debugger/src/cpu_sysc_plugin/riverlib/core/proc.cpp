@@ -509,6 +509,12 @@ void Processor::generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd) {
     }
 }
 
+void Processor::setLockstepChecker(ILockstepChecker *ichk) {
+    if (trace0) {
+        trace0->setLockstepChecker(ichk);
+    }
+}
+
 void Processor::comb() {
     w_mem_resp_error = i_resp_data_load_fault || i_resp_data_store_fault
                     || i_resp_data_er_mpu_store || i_resp_data_er_mpu_load;
@@ -99,6 +99,7 @@ SC_MODULE(Processor) {
 
     void comb();
     void generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd);
+    void setLockstepChecker(ILockstepChecker *ichk);
 
     SC_HAS_PROCESS(Processor);
 
@@ -58,6 +58,7 @@ Tracer::Tracer(sc_module_name name_, bool async_reset, const char *trace_file)
     i_reg_ignored("i_reg_ignored") {
     async_reset_ = async_reset;
     fl_ = 0;
+    ilockstep_ = 0;
     if (strlen(trace_file)) {
         fl_ = fopen(trace_file, "wb");
     }
@@ -692,6 +693,15 @@ void Tracer::generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd) {
     }
 }
 
+/** Commits are compared in-process so the text log isn't written */
+void Tracer::setLockstepChecker(ILockstepChecker *ichk) {
+    ilockstep_ = ichk;
+    if (ilockstep_ && fl_) {
+        fclose(fl_);
+        fl_ = 0;
+    }
+}
+
 void Tracer::registers() {
 
     TraceStepType *p_e_wr = &trace_tbl_[tr_wcnt_];
@@ -768,7 +778,12 @@ void Tracer::registers() {
         if (!entry_valid) {
             break;
         }
-        trace_output(&trace_tbl_[tr_rcnt_]);
+        if (fl_) {
+            trace_output(&trace_tbl_[tr_rcnt_]);
+        }
+        if (ilockstep_) {
+            lockstep_output(&trace_tbl_[tr_rcnt_]);
+        }
         tr_rcnt_ = (tr_rcnt_ + 1) %  TRACE_TBL_SZ;
     }
 }
@@ -819,5 +834,40 @@ void Tracer::trace_output(TraceStepType *tr) {
     }
 }
 
+void Tracer::lockstep_output(TraceStepType *tr) {
+    LockstepCommitType c;
+    LockstepActionType *pa;
+    uint64_t msk[4] = {0xFFull, 0xFFFFull, 0xFFFFFFFFull, ~0ull};
+
+    c.cnt = tr->exec_cnt;
+    c.pc = tr->pc;
+    c.instr = tr->instr;
+    c.actioncnt = 0;
+    for (int i = 0; i < tr->memactioncnt
+                    && c.actioncnt < LOCKSTEP_ACTIONS_MAX; i++) {
+        MemopActionType *pm = &tr->memaction[i];
+        if (pm->ignored) {
+            continue;
+        }
+        pa = &c.action[c.actioncnt++];
+        pa->type = pm->store ? LockstepAction_Store : LockstepAction_Load;
+        pa->size = static_cast<uint8_t>(1 << pm->size);
+        pa->regidx = 0;
+        pa->addr = pm->memaddr;
+        pa->data = pm->data & msk[pm->size];
+    }
+    for (int i = 0; i < tr->regactioncnt
+                    && c.actioncnt < LOCKSTEP_ACTIONS_MAX; i++) {
+        RegActionType *pr = &tr->regaction[i];
+        pa = &c.action[c.actioncnt++];
+        pa->type = LockstepAction_Reg;
+        pa->size = 8;
+        pa->regidx = static_cast<uint16_t>(pr->waddr);
+        pa->addr = 0;
+        pa->data = pr->wres;
+    }
+    ilockstep_->commitInstruction(&c);
+}
+
 }  // namespace debugger
 
@@ -22,6 +22,7 @@
 #include <systemc.h>
 #include <string>
 #include "../river_cfg.h"
+#include "coreservices/ilockstep.h"
 
 namespace debugger {
 
@@ -57,6 +58,7 @@ SC_MODULE(Tracer) {
     Tracer(sc_module_name name_, bool async_reset, const char *trace_file);
 
     void generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd);
+    void setLockstepChecker(ILockstepChecker *ichk);
 
  private:
     static const int TRACE_TBL_SZ = 64;
@@ -89,6 +91,7 @@ SC_MODULE(Tracer) {
     };
 
     void trace_output(TraceStepType *tr);
+    void lockstep_output(TraceStepType *tr);
     void task_disassembler(uint32_t instr);
 
     TraceStepType trace_tbl_[TRACE_TBL_SZ];
@@ -98,6 +101,7 @@ SC_MODULE(Tracer) {
     int tr_opened_;
 
     FILE *fl_;
+    ILockstepChecker *ilockstep_;
     char disasm[1024];
 
     bool async_reset_;
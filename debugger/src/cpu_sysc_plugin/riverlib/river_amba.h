@@ -65,6 +65,9 @@ SC_MODULE(RiverAmba) {
     virtual ~RiverAmba();
 
     void generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd);
+    void setLockstepChecker(ILockstepChecker *ichk) {
+        river0->setLockstepChecker(ichk);
+    }
 
  private:
     RiverTop *river0;
@@ -80,6 +80,9 @@ SC_MODULE(RiverTop) {
     virtual ~RiverTop();
 
     void generateVCD(sc_trace_file *i_vcd, sc_trace_file *o_vcd);
+    void setLockstepChecker(ILockstepChecker *ichk) {
+        proc0->setLockstepChecker(ichk);
+    }
  private:
 
     Processor *proc0;
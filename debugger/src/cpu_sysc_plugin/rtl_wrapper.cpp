@@ -63,6 +63,9 @@ RtlWrapper::RtlWrapper(IFace *parent, sc_module_name name) : sc_module(name),
     w_seip = 0;
     iirqloc_ = 0;
     iirqext_ = 0;
+    rburst_addr_ = 0;
+    rburst_size_ = 0;
+    rburst_resp_ = TRANS_OK;
 
     SC_METHOD(comb);
     sensitive << w_interrupt;
@@ -316,6 +319,14 @@ void RtlWrapper::sys_bus_proc() {
     uint64_t toff;
     switch (r.state.read()) {
     case State_Read:
+        if (readBurstBeat(r.req_addr.read())) {
+            w_resp_valid = 1;
+            wb_resp_data = trans.rpayload.b64[0];
+            if (resp == TRANS_ERROR) {
+                w_r_error = 1;
+            }
+            break;
+        }
         trans.action = MemAction_Read;
         trans.addr = r.req_addr.read();
         trans.xsize = 8;
@@ -352,6 +363,40 @@ void RtlWrapper::sys_bus_proc() {
     }
 }
 
+/**
+ * Aligned incrementing burst is read with the single bus transaction on the
+ * first beat, the next beats are taken from the buffer. Returns false if
+ * the beat has to be requested separately.
+ */
+bool RtlWrapper::readBurstBeat(uint64_t addr) {
+    if (rburst_size_ == 0) {
+        if (r.req_burst.read() != 1 || r.req_len.read() == 0
+            || (addr & (BUS_DATA_BYTES - 1)) != 0) {
+            return false;
+        }
+        trans.action = MemAction_Read;
+        trans.addr = addr;
+        trans.xsize = (r.req_len.read() + 1) * BUS_DATA_BYTES;
+        trans.wstrb = 0;
+        trans.burst = Burst_Incr;
+        trans.bsize = BUS_DATA_BYTES;
+        trans.bpayload = rburst_;
+        rburst_resp_ = ibus_->b_transport(&trans);
+        rburst_addr_ = addr;
+        rburst_size_ = trans.xsize;
+    }
+    if (addr < rburst_addr_ || addr >= rburst_addr_ + rburst_size_) {
+        rburst_size_ = 0;
+        return false;
+    }
+    memcpy(trans.rpayload.b8, &rburst_[addr - rburst_addr_], BUS_DATA_BYTES);
+    resp = rburst_resp_;
+    if (r.req_len.read() == 0) {
+        rburst_size_ = 0;
+    }
+    return true;
+}
+
 uint64_t RtlWrapper::mask2offset(uint8_t mask) {
     for (int i = 0; i < BUS_DATA_BYTES; i++) {
         if (mask & 0x1) {
@@ -141,6 +141,7 @@ class RtlWrapper : public sc_module,
     IFace *getInterface(const char *name) { return iparent_; }
     uint64_t mask2offset(uint8_t mask);
     uint32_t mask2size(uint8_t mask);       // nask with removed offset
+    bool readBurstBeat(uint64_t addr);
 
  private:
     IIrqController *iirqloc_;
@@ -150,6 +151,13 @@ class RtlWrapper : public sc_module,
     int clockCycles_;   // default in [ps]
     ClockAsyncTQueueType step_queue_;
 
+    // Incrementing read burst is requested from the bus at the first beat
+    static const int RBURST_MAX_BYTES = 256 * BUS_DATA_BYTES;
+    uint8_t rburst_[RBURST_MAX_BYTES];
+    uint64_t rburst_addr_;
+    uint32_t rburst_size_;
+    ETransStatus rburst_resp_;
+
     sc_uint<32> t_trans_idx_up;
     sc_uint<32> t_trans_idx_down;
 };
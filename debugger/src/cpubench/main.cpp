@@ -0,0 +1,163 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Microbenchmark of the functional RISC-V instructions. Every
+ *             M-extension instruction is executed by exec() with the
+ *             Native and Reference multiplier, results of both modes are
+ *             compared on the same operands (Reference tree doesn't negate
+ *             0x8000000000000000 in MULH and MULHSU):
+ *                 cpubench [-n iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include <api_core.h>
+#include "cpu_riscv_func.h"
+
+using namespace debugger;
+
+/** Collects instructions instead of building the decoder */
+class BenchCpu : public CpuRiver_Functional {
+ public:
+    BenchCpu(const char *name, const char *mulmode)
+        : CpuRiver_Functional(name) {
+        AttributeType cfg;
+        char tstr[64];
+        RISCV_sprintf(tstr, sizeof(tstr), "[['MulMode','%s']]", mulmode);
+        cfg.from_config(tstr);
+        initService(&cfg);
+        addIsaExtensionM();
+    }
+
+    virtual unsigned addSupportedInstruction(RiscvInstruction *instr) {
+        list_.push_back(instr);
+        return 0;
+    }
+
+    RiscvInstruction *getInstr(const char *name) {
+        for (unsigned i = 0; i < list_.size(); i++) {
+            if (strcmp(list_[i]->name(), name) == 0) {
+                return list_[i];
+            }
+        }
+        return 0;
+    }
+
+    std::vector<RiscvInstruction *> list_;
+};
+
+static const int OPERANDS_TOTAL = 1024;     // power of 2
+static const int REG_RD = 3;
+static const int REG_RS1 = 1;
+static const int REG_RS2 = 2;
+
+/** Random values with the corner cases at the beginning of the table */
+static void fillOperands(uint64_t *op) {
+    static const uint64_t corner[] = {
+        0, 1, ~0ull, 0x8000000000000000ull, 0x7FFFFFFFFFFFFFFFull,
+        0x100000000ull, 0xFFFFFFFFull, 0x80000000ull, 2, ~1ull
+    };
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    int cnt = static_cast<int>(sizeof(corner) / sizeof(corner[0]));
+    for (int i = 0; i < OPERANDS_TOTAL; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        op[i] = i < cnt ? corner[i] : x;
+    }
+}
+
+static uint64_t execOne(BenchCpu *cpu, RiscvInstruction *instr,
+                        Reg64Type *payload, uint64_t a, uint64_t b) {
+    uint64_t *R = cpu->getpRegs();
+    R[REG_RS1] = a;
+    R[REG_RS2] = b;
+    instr->exec(payload);
+    return R[REG_RD];
+}
+
+/** Returns executed instructions per microsecond */
+static double measure(BenchCpu *cpu, RiscvInstruction *instr,
+                      Reg64Type *payload, const uint64_t *op, int iter) {
+    uint64_t *R = cpu->getpRegs();
+    uint64_t t1 = RISCV_get_time_ms();
+    for (int i = 0; i < iter; i++) {
+        R[REG_RS1] = op[i & (OPERANDS_TOTAL - 1)];
+        R[REG_RS2] = op[(i * 7 + 3) & (OPERANDS_TOTAL - 1)];
+        instr->exec(payload);
+    }
+    uint64_t dt = RISCV_get_time_ms() - t1;
+    if (dt == 0) {
+        dt = 1;
+    }
+    return static_cast<double>(iter) / (1000.0 * static_cast<double>(dt));
+}
+
+int main(int argc, char* argv[]) {
+    int iter = 10000000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iter = atoi(argv[++i]);
+        } else {
+            printf("Usage: cpubench [-n iterations]\n");
+            return 1;
+        }
+    }
+
+    RISCV_init();
+    uint64_t op[OPERANDS_TOTAL];
+    fillOperands(op);
+
+    BenchCpu *cpuNative = new BenchCpu("bench_native", "Native");
+    BenchCpu *cpuRef = new BenchCpu("bench_ref", "Reference");
+
+    printf("%-8s %14s %14s %8s %10s\n",
+           "instr", "Native Mop/s", "Ref. Mop/s", "gain", "mismatch");
+    for (unsigned n = 0; n < cpuNative->list_.size(); n++) {
+        RiscvInstruction *instrNative = cpuNative->list_[n];
+        RiscvInstruction *instrRef = cpuRef->getInstr(instrNative->name());
+        Reg64Type payload;
+        payload.val = instrNative->opcode() | (REG_RD << 7)
+                    | (REG_RS1 << 15) | (REG_RS2 << 20);
+
+        int mismatch = 0;
+        for (int i = 0; i < OPERANDS_TOTAL; i++) {
+            for (int k = 0; k < 16; k++) {
+                uint64_t a = op[i];
+                uint64_t b = op[(i + k * 61) & (OPERANDS_TOTAL - 1)];
+                if (execOne(cpuNative, instrNative, &payload, a, b)
+                    != execOne(cpuRef, instrRef, &payload, a, b)) {
+                    if (mismatch++ == 0) {
+                        printf("    %s(%016" RV_PRI64 "x, %016" RV_PRI64 "x)"
+                               " differs\n", instrNative->name(), a, b);
+                    }
+                }
+            }
+        }
+
+        double mopsNative = measure(cpuNative, instrNative, &payload, op, iter);
+        double mopsRef = measure(cpuRef, instrRef, &payload, op, iter);
+        printf("%-8s %14.1f %14.1f %7.1fx %10d\n",
+               instrNative->name(), mopsNative, mopsRef,
+               mopsNative / mopsRef, mismatch);
+    }
+
+    delete cpuNative;
+    delete cpuRef;
+    RISCV_cleanup();
+    return 0;
+}
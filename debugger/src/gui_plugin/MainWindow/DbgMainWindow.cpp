@@ -97,6 +97,8 @@ DbgMainWindow::DbgMainWindow(IGui *igui) : QMainWindow() {
 
     connect(this, SIGNAL(signalSimulationTime(double)),
                   SLOT(slotSimulationTime(double)));
+    connect(this, SIGNAL(signalTargetStateChanged(bool)),
+                  SLOT(slotTargetStateChanged(bool)));
 }
 
 DbgMainWindow::~DbgMainWindow() {
@@ -496,6 +498,13 @@ void DbgMainWindow::slotUpdateByTimer() {
     emit signalUpdateByTimer();
 }
 
+/** Views are refreshed right after halt without waiting the next tick */
+void DbgMainWindow::slotTargetStateChanged(bool running) {
+    if (!running) {
+        emit signalUpdateByTimer();
+    }
+}
+
 void DbgMainWindow::slotActionAbout() {
     QString build;
     build = QString::asprintf("Version: 1.0\nBuild:     %s\n", __DATE__);
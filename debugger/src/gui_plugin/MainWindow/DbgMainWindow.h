@@ -52,6 +52,7 @@ class DbgMainWindow : public QMainWindow,
 
  private slots:
     void slotUpdateByTimer();
+    void slotTargetStateChanged(bool running);
     void slotActionAbout();
     void slotActionTargetRun();
     void slotActionTargetHalt();
@@ -36,6 +36,12 @@ LedDisplay::LedDisplay(IGui *gui, QWidget *parent, const char *objname)
     RISCV_sprintf(tstr, sizeof(tstr), "%s frame diff", objname);
     cmdframe_.make_string(tstr);
 
+    RISCV_sprintf(tstr, sizeof(tstr), "%s frame surface", objname);
+    cmdsurface_.make_string(tstr);
+    shm_ = 0;
+    surface_ = 0;
+    surfaceSize_ = 0;
+
     const AttributeType &cfgDisplay = 
         (*igui_->getpConfig())["DemoM4Widgets"]["Display"];
 
@@ -72,6 +78,12 @@ LedDisplay::LedDisplay(IGui *gui, QWidget *parent, const char *objname)
 
 LedDisplay::~LedDisplay() {
     igui_->removeFromQueue(static_cast<IGuiCmdHandler *>(this));
+    if (surface_) {
+        RISCV_memshare_unmap(surface_, surfaceSize_);
+    }
+    if (shm_) {
+        RISCV_memshare_delete(shm_);
+    }
 }
 
 void LedDisplay::handleResponse(const char *cmd) {
@@ -83,6 +95,12 @@ void LedDisplay::handleResponse(const char *cmd) {
         } else {
             requested_ = false;
         }
+    } else if (strcmp(cmd, cmdsurface_.to_string()) == 0) {
+        if (respFrame_.is_list() && respFrame_.size()) {
+            emit signalHandleResponse();
+        } else {
+            requested_ = false;
+        }
     }
 }
 
@@ -100,25 +118,82 @@ void LedDisplay::slotConfigurate() {
                                 screenshot_scale_*height_));
     pixmapScreenshot_.fill(QColor(respConfig_["BkgColor"].to_uint32()));
 
+    const AttributeType &surface = respConfig_["Surface"];
+    if (surface.is_string() && surface.size()) {
+        openSurface(surface.to_string());
+    }
+
     RISCV_memory_barrier();
     requested_ = false;
 }
 
+void LedDisplay::openSurface(const char *name) {
+    surfaceSize_ = DisplaySurfaceType::getSize(width_, height_);
+    shm_ = RISCV_memshare_create(name, surfaceSize_);
+    if (!shm_) {
+        return;
+    }
+    surface_ = static_cast<DisplaySurfaceType *>(
+                RISCV_memshare_map(shm_, surfaceSize_));
+    if (surface_ && (surface_->width != static_cast<uint32_t>(width_)
+                  || surface_->height != static_cast<uint32_t>(height_))) {
+        RISCV_memshare_unmap(surface_, surfaceSize_);
+        surface_ = 0;
+    }
+}
+
 void LedDisplay::slotUpdateByTimer() {
     if (requested_) {
         return;
     }
-    igui_->registerCommand(static_cast<IGuiCmdHandler *>(this),
-                          cmdframe_.to_string(), &respFrame_, true);
+    if (surface_) {
+        igui_->registerCommand(static_cast<IGuiCmdHandler *>(this),
+                              cmdsurface_.to_string(), &respFrame_, true);
+    } else {
+        igui_->registerCommand(static_cast<IGuiCmdHandler *>(this),
+                              cmdframe_.to_string(), &respFrame_, true);
+    }
     requested_ = true;
 }
 
+/** Only listed tiles are read directly from the front buffer and redrawn */
+void LedDisplay::drawTiles(QPainter *p, QPainter *p2) {
+    const uint32_t *pframe = surface_->buffer(surface_->front);
+    int tiles_y = (height_ + DISPLAY_TILE_SIZE - 1) / DISPLAY_TILE_SIZE;
+    FrameItemType pix;
+    for (unsigned i = 0; i < respFrame_.size(); i++) {
+        int tile = respFrame_[i].to_int();
+        int x0 = (tile / tiles_y) * DISPLAY_TILE_SIZE;
+        int y0 = (tile % tiles_y) * DISPLAY_TILE_SIZE;
+        for (pix.x = x0; pix.x < x0 + DISPLAY_TILE_SIZE
+                         && pix.x < width_; pix.x++) {
+            for (pix.y = y0; pix.y < y0 + DISPLAY_TILE_SIZE
+                             && pix.y < height_; pix.y++) {
+                pix.rgb = pframe[pix.x * height_ + pix.y];
+                drawPixel(p, &pix, scale_);
+                drawPixel(p2, &pix, screenshot_scale_);
+            }
+        }
+        update(scale_ * x0, scale_ * y0,
+               scale_ * DISPLAY_TILE_SIZE, scale_ * DISPLAY_TILE_SIZE);
+    }
+}
+
 void LedDisplay::slotHandleResponse() {
     QPainter p(&pixmap_);
     QPainter p2(&pixmapScreenshot_);
     p.setRenderHint(QPainter::Antialiasing, false);
     p2.setRenderHint(QPainter::Antialiasing, false);
 
+    if (respFrame_.is_list()) {
+        drawTiles(&p, &p2);
+        p2.end();
+        p.end();
+        RISCV_memory_barrier();
+        requested_ = false;
+        return;
+    }
+
     uint32_t *pframe = reinterpret_cast<uint32_t *>(respFrame_.data());
     unsigned sz = respFrame_.size() / sizeof(uint32_t);
     FrameItemType pix;
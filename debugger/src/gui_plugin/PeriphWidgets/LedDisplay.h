@@ -19,6 +19,7 @@
 #include "api_core.h"   // MUST BE BEFORE QtWidgets.h or any other Qt header.
 #include "attribute.h"
 #include "igui.h"
+#include "coreservices/idisplay.h"
 
 #include <QtWidgets/QWidget>
 #include <QtGui/QAction>
@@ -60,11 +61,14 @@ class LedDisplay : public QWidget,
         uint32_t rgb;
     };
     void drawPixel(QPainter *p, FrameItemType *pix, int scale);
+    void openSurface(const char *name);
+    void drawTiles(QPainter *p, QPainter *p2);
 
 private:
     IGui *igui_;
     AttributeType cmdconfig_;
     AttributeType cmdframe_;
+    AttributeType cmdsurface_;
     AttributeType respConfig_;
     AttributeType respFrame_;
 
@@ -78,6 +82,10 @@ private:
     int screenshot_scale_;
 
     bool requested_;
+
+    sharemem_def shm_;
+    DisplaySurfaceType *surface_;   // zero-copy frame when model supports it
+    int surfaceSize_;
 };
 
 }  // namespace debugger
@@ -50,9 +50,9 @@ GuiPlugin::GuiPlugin(const char *name)
     RISCV_event_create(&config_done_, "eventGuiGonfigGone");
     RISCV_register_hap(static_cast<IHap *>(this));
 
-    cmdwrcnt_ = 0;
-    cmdrdcnt_ = 0;
-    pcmdwr_ = cmdbuf_;
+    RISCV_event_create(&cmd_pending_, "eventGuiCmdPending");
+    RISCV_mutex_init(&mutexQueue_);
+    RISCV_mutex_init(&mutexProc_);
 
     // Adding path to platform libraries:
     char core_path[1024];
@@ -74,6 +74,9 @@ GuiPlugin::GuiPlugin(const char *name)
 
 GuiPlugin::~GuiPlugin() {
     RISCV_event_close(&config_done_);
+    RISCV_event_close(&cmd_pending_);
+    RISCV_mutex_destroy(&mutexQueue_);
+    RISCV_mutex_destroy(&mutexProc_);
 }
 
 void GuiPlugin::postinitService() {
@@ -96,36 +99,49 @@ const AttributeType *GuiPlugin::getpConfig() {
     return &guiConfig_;
 }
 
+/** Widget repeating its request before it was executed gets one response */
 void GuiPlugin::registerCommand(IGuiCmdHandler *iface,
                                 const char *req,
                                 AttributeType *resp,
                                 bool silent) {
-    size_t sztoend = sizeof(cmdbuf_) - (pcmdwr_ - cmdbuf_);
-    size_t szwr = strlen(req) + 1;
-    if (sztoend < szwr) {
-        pcmdwr_ = cmdbuf_;
+    RISCV_mutex_lock(&mutexQueue_);
+    if (iface) {
+        for (size_t i = 0; i < cmds_.size(); i++) {
+            CmdType &cmd = cmds_[i];
+            if (cmd.iface == iface && cmd.resp == resp && cmd.req == req) {
+                cmd.silent = cmd.silent && silent;
+                RISCV_mutex_unlock(&mutexQueue_);
+                return;
+            }
+        }
     }
-    memcpy(pcmdwr_, req, szwr);
-    cmds_[cmdwrcnt_].req = pcmdwr_;
-    cmds_[cmdwrcnt_].resp = resp;
-    cmds_[cmdwrcnt_].silent = silent;
-    cmds_[cmdwrcnt_].iface = iface;
-    pcmdwr_ += szwr;
-    RISCV_memory_barrier();
-    ++cmdwrcnt_;   // CMD_QUEUE_SIZE = 256
+    CmdType cmd;
+    cmd.req = req;
+    cmd.resp = resp;
+    cmd.silent = silent;
+    cmd.iface = iface;
+    cmds_.push_back(cmd);
+    RISCV_event_set(&cmd_pending_);
+    RISCV_mutex_unlock(&mutexQueue_);
 }
 
 void GuiPlugin::removeFromQueue(IFace *iface) {
-    CmdType *pcmd;
-    uint8_t rd = cmdrdcnt_;
-    while (rd != cmdwrcnt_) {
-        pcmd = &cmds_[rd];
-        if (pcmd->iface == iface) {
-            pcmd->iface = 0;
-            pcmd->resp = 0;
+    RISCV_mutex_lock(&mutexProc_);
+    RISCV_mutex_lock(&mutexQueue_);
+    for (size_t i = 0; i < proc_.size(); i++) {
+        if (proc_[i].iface == iface) {
+            proc_[i].iface = 0;
+            proc_[i].resp = 0;
+        }
+    }
+    for (size_t i = 0; i < cmds_.size(); i++) {
+        if (cmds_[i].iface == iface) {
+            cmds_[i].iface = 0;
+            cmds_[i].resp = 0;
         }
-        ++rd;
     }
+    RISCV_mutex_unlock(&mutexQueue_);
+    RISCV_mutex_unlock(&mutexProc_);
 }
 
 void GuiPlugin::externalCommand(AttributeType *req) {
@@ -142,10 +158,12 @@ void GuiPlugin::busyLoop() {
     RISCV_event_wait(&config_done_);
 
     while (isEnabled()) {
-        if (cmdwrcnt_ == cmdrdcnt_) {
-            RISCV_sleep_ms(50);
-            continue;
+        RISCV_mutex_lock(&mutexQueue_);
+        if (cmds_.empty()) {
+            RISCV_event_clear(&cmd_pending_);
         }
+        RISCV_mutex_unlock(&mutexQueue_);
+        RISCV_event_wait(&cmd_pending_);
 
         processCmdQueue();
     }
@@ -153,24 +171,35 @@ void GuiPlugin::busyLoop() {
     delete ui_;
 }
 
-bool GuiPlugin::processCmdQueue() {
+void GuiPlugin::processCmdQueue() {
     CmdType *pcmd;
 
-    while (cmdrdcnt_ != cmdwrcnt_) {
-        pcmd = &cmds_[cmdrdcnt_];
+    RISCV_mutex_lock(&mutexProc_);
+    RISCV_mutex_lock(&mutexQueue_);
+    proc_.swap(cmds_);
+    RISCV_mutex_unlock(&mutexQueue_);
+    RISCV_mutex_unlock(&mutexProc_);
+
+    for (size_t i = 0; i < proc_.size(); i++) {
+        RISCV_mutex_lock(&mutexProc_);
+        pcmd = &proc_[i];
         if (pcmd->resp) {
-            iexec_->exec(pcmd->req, pcmd->resp, pcmd->silent);
+            iexec_->exec(pcmd->req.c_str(), pcmd->resp, pcmd->silent);
         }
         if (pcmd->iface) {
-            pcmd->iface->handleResponse(pcmd->req);
+            pcmd->iface->handleResponse(pcmd->req.c_str());
         }
-        RISCV_memory_barrier();
-        ++cmdrdcnt_;
+        RISCV_mutex_unlock(&mutexProc_);
     }
-    return false;
+
+    RISCV_mutex_lock(&mutexProc_);
+    proc_.clear();
+    RISCV_mutex_unlock(&mutexProc_);
 }
 
 void GuiPlugin::stop() {
+    RISCV_event_clear(&loopEnable_);
+    RISCV_event_set(&cmd_pending_);
     IThread::stop();
 }
 
@@ -25,6 +25,8 @@
 #include "coreservices/icmdexec.h"
 #include "MainWindow/DbgMainWindow.h"
 #include "qt_wrapper.h"
+#include <string>
+#include <vector>
 
 namespace debugger {
 
@@ -59,11 +61,9 @@ protected:
     virtual void busyLoop();
 
 private:
-    bool processCmdQueue();
+    void processCmdQueue();
 
 private:
-    static const int CMD_QUEUE_SIZE = 256;
-
     AttributeType guiConfig_;
     AttributeType cmdexec_;
 
@@ -71,17 +71,24 @@ private:
     QtWrapper *ui_;
 
     event_def config_done_;
+    event_def cmd_pending_;     // set while cmds_ isn't empty
 
-    char cmdbuf_[1024*1024];
-    char *pcmdwr_;
     struct CmdType {
         bool silent;
-        const char *req;
+        std::string req;
         IGuiCmdHandler *iface;
         AttributeType *resp;
-    } cmds_[CMD_QUEUE_SIZE];
-    uint8_t cmdwrcnt_;
-    uint8_t cmdrdcnt_;
+    };
+    /**
+     * Widgets push into cmds_ from any thread under mutexQueue_. Plugin
+     * thread moves them into proc_ and executes under mutexProc_, so that
+     * removeFromQueue() returns only when the widget isn't in use anymore.
+     * Lock order: mutexProc_ then mutexQueue_.
+     */
+    std::vector<CmdType> cmds_;
+    std::vector<CmdType> proc_;
+    mutex_def mutexQueue_;
+    mutex_def mutexProc_;
 };
 
 DECLARE_CLASS(GuiPlugin)
@@ -21,6 +21,7 @@
 #include "services/debug/udp_dbglink.h"
 #include "services/debug/edcl.h"
 #include "services/debug/cpumonitor.h"
+#include "services/debug/lockstep.h"
 #include "services/debug/codecov_generic.h"
 #include "services/debug/greth.h"
 #include "services/debug/dsu/dsu.h"
@@ -33,6 +34,7 @@
 #include "services/remote/tcpclient.h"
 #include "services/remote/tcpserver.h"
 #include "services/remote/dpiclient.h"
+#include "services/sched/hartsched.h"
 #include "services/comport/comport.h"
 #include "services/console/autocompleter.h"
 #include "services/console/console.h"
@@ -88,6 +90,8 @@ extern "C" int RISCV_init() {
     REGISTER_CLASS_IDX(Greth, 17)
     REGISTER_CLASS_IDX(DSU, 18);
     REGISTER_CLASS_IDX(TcpJtagBitBangClient, 19);
+    REGISTER_CLASS_IDX(HartScheduler, 20);
+    REGISTER_CLASS_IDX(LockstepChecker, 21);
 
     pcore_->load_plugins();
     return 0;
@@ -343,6 +347,16 @@ extern "C" int RISCV_printf(void *iface, int level,
     int ret = 0;
     va_list arg;
     IFace *iout = reinterpret_cast<IFace *>(iface);
+    IService *iserv = NULL;
+    if (iout && strcmp(iout->getFaceName(), IFACE_SERVICE) == 0) {
+        // Check the level before the lock to keep filtered messages cheap
+        iserv = static_cast<IService *>(iout);
+        AttributeType *local_level = 
+                static_cast<AttributeType *>(iserv->getAttribute("LogLevel"));
+        if (level > static_cast<int>(local_level->to_int64())) {
+            return 0;
+        }
+    }
     uint64_t cur_t = pcore_->getTimestamp();
 
     char *buf = pcore_->getpBufLog();
@@ -351,14 +365,7 @@ extern "C" int RISCV_printf(void *iface, int level,
     if (iout == NULL) {
         ret = RISCV_sprintf(buf, buf_sz,
                     "[%" RV_PRI64 "d, \"%s\", \"", cur_t, "unknown");
-    } else if (strcmp(iout->getFaceName(), IFACE_SERVICE) == 0) {
-        IService *iserv = static_cast<IService *>(iout);
-        AttributeType *local_level = 
-                static_cast<AttributeType *>(iserv->getAttribute("LogLevel"));
-        if (level > static_cast<int>(local_level->to_int64())) {
-            pcore_->unlockPrintf();
-            return 0;
-        }
+    } else if (iserv) {
         ret = RISCV_sprintf(buf, buf_sz,
                 "[%" RV_PRI64 "d, \"%s\", \"", cur_t, iserv->getObjName());
     } else if (strcmp(iout->getFaceName(), IFACE_CLASS) == 0) {
@@ -449,6 +456,43 @@ extern "C" void RISCV_memory_barrier() {
 #endif
 }
 
+extern "C" void RISCV_atomic_inc64(volatile uint64_t *val) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    InterlockedIncrement64(reinterpret_cast<volatile LONG64 *>(val));
+#else
+    __sync_fetch_and_add(val, 1);
+#endif
+}
+
+extern "C" void *RISCV_atomic_cas_ptr(void * volatile *dst,
+                                      void *oldval, void *newval) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    return InterlockedCompareExchangePointer(dst, newval, oldval);
+#else
+    return __sync_val_compare_and_swap(dst, oldval, newval);
+#endif
+}
+
+extern "C" uint32_t RISCV_atomic_or32(volatile uint32_t *dst,
+                                     uint32_t val) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    return static_cast<uint32_t>(
+        InterlockedOr(reinterpret_cast<volatile LONG *>(dst),
+                      static_cast<LONG>(val)));
+#else
+    return __sync_fetch_and_or(dst, val);
+#endif
+}
+
+extern "C" void RISCV_atomic_add64(volatile uint64_t *dst, uint64_t val) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    InterlockedExchangeAdd64(reinterpret_cast<volatile LONG64 *>(dst),
+                             static_cast<LONG64>(val));
+#else
+    __sync_fetch_and_add(dst, val);
+#endif
+}
+
 extern "C" void RISCV_thread_create(void *data) {
     LibThreadType *p = (LibThreadType *)data;
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -618,7 +662,7 @@ extern "C" void* RISCV_memshare_map(sharemem_def h, int sz) {
                         sz);
 #else
     ret = mmap(NULL, sz + 1, PROT_READ|PROT_WRITE, MAP_SHARED, h, 0);
-    if (ret < 0) {
+    if (ret == MAP_FAILED) {
         ret = 0;
     }
 #endif
@@ -644,6 +688,69 @@ extern "C" void RISCV_memshare_delete(sharemem_def h) {
 #endif
 }
 
+extern "C" void RISCV_memshare_remove(const char *name) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    // Mapping object is removed when the last handle is closed
+#else
+    shm_unlink(name);
+#endif
+}
+
+extern "C" void *RISCV_memory_reserve(uint64_t sz) {
+    void *ret = 0;
+#if defined(_WIN32) || defined(__CYGWIN__)
+    ret = VirtualAlloc(NULL, static_cast<SIZE_T>(sz),
+                       MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    ret = mmap(NULL, static_cast<size_t>(sz), PROT_READ|PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (ret == MAP_FAILED) {
+        ret = 0;
+    }
+#endif
+    if (ret == 0) {
+        RISCV_error("Couldn't reserve %" RV_PRI64 "d bytes", sz);
+    }
+    return ret;
+}
+
+extern "C" uint64_t RISCV_memory_map_file(void *addr, uint64_t sz,
+                                          const char *filename) {
+    uint64_t fsz = 0;
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    fsz = static_cast<uint64_t>(ftell(fp));
+    if (fsz > sz) {
+        fsz = sz;
+    }
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+    // Replace anonymous pages, the image is read on demand by the page faults
+    if (fsz && mmap(addr, static_cast<size_t>(fsz), PROT_READ|PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, fileno(fp), 0) != MAP_FAILED) {
+        fclose(fp);
+        return fsz;
+    }
+#endif
+    fseek(fp, 0, SEEK_SET);
+    fsz = fread(addr, 1, static_cast<size_t>(fsz), fp);
+    fclose(fp);
+    return fsz;
+}
+
+extern "C" void RISCV_memory_release(void *addr, uint64_t sz) {
+    if (addr == 0) {
+        return;
+    }
+#if defined(_WIN32) || defined(__CYGWIN__)
+    VirtualFree(addr, 0, MEM_RELEASE);
+#else
+    munmap(addr, static_cast<size_t>(sz));
+#endif
+}
+
 extern "C" int RISCV_mutex_init(mutex_def *mutex) {
 #if defined(_WIN32) || defined(__CYGWIN__)
     InitializeCriticalSection(mutex);
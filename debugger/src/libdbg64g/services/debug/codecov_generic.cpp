@@ -15,9 +15,20 @@
  */
 
 #include "codecov_generic.h"
+#include <string.h>
+#include <time.h>
 
 namespace debugger {
 
+static int popcount32(uint32_t v) {
+    int ret = 0;
+    while (v) {
+        v &= v - 1;
+        ret++;
+    }
+    return ret;
+}
+
 int CoverageCmdType::isValid(AttributeType *args) {
     if (!(*args)[0u].is_equal("coverage")) {
         return CMD_INVALID;
@@ -33,6 +44,27 @@ void CoverageCmdType::exec(AttributeType *args, AttributeType *res) {
             return;
         }
     }
+    if (args->size() >= 3 && (*args)[1].is_string()
+        && (*args)[2].is_string()) {
+        const char *srcname = "image";
+        int err = -1;
+        if (args->size() > 3 && (*args)[3].is_string()) {
+            srcname = (*args)[3].to_string();
+        }
+        if ((*args)[1].is_equal("lcov")) {
+            err = p->exportLcov((*args)[2].to_string(), srcname);
+        } else if ((*args)[1].is_equal("cobertura")) {
+            err = p->exportCobertura((*args)[2].to_string(), srcname);
+        } else {
+            generateError(res, "Unknown export format");
+            return;
+        }
+        res->make_nil();
+        if (err) {
+            generateError(res, "Can't write coverage file");
+        }
+        return;
+    }
     res->make_floating(p->getCoverage());
 }
 
@@ -43,7 +75,17 @@ GenericCodeCoverage::GenericCodeCoverage(const char *name) : IService(name) {
     registerAttribute("SourceCode", static_cast<IAttribute *>(&src_));
     registerAttribute("Paged", static_cast<IAttribute *>(&paged_));
     registerAttribute("Regions", static_cast<IAttribute *>(&regions_));
+    iexec_ = 0;
+    isrc_ = 0;
+    pcmd_ = 0;
     track_sz_ = 0;
+    dir_ = new DirType * volatile[DIR_TOTAL];
+    memset(const_cast<DirType **>(dir_), 0, DIR_TOTAL * sizeof(DirType *));
+}
+
+GenericCodeCoverage::~GenericCodeCoverage() {
+    clearMap();
+    delete [] dir_;
 }
 
 void GenericCodeCoverage::postinitService() {
@@ -77,7 +119,6 @@ void GenericCodeCoverage::postinitService() {
         AttributeType &item = regions_[i];
         track_sz_ += item[1].to_uint64() - item[0u].to_uint64() + 1;
     }
-    memset(flash_, 0, sizeof(flash_));
 }
 
 void GenericCodeCoverage::predeleteService() {
@@ -86,137 +127,342 @@ void GenericCodeCoverage::predeleteService() {
     }
 }
 
+void GenericCodeCoverage::clearMap() {
+    for (unsigned i = 0; i < DIR_TOTAL; i++) {
+        DirType *dir = dir_[i];
+        if (!dir) {
+            continue;
+        }
+        for (unsigned n = 0; n < (1u << DIR_BITS); n++) {
+            delete dir->page[n];
+        }
+        delete dir;
+        dir_[i] = 0;
+    }
+}
+
+/**
+ * Concurrent allocation is resolved by compare-and-swap, the loser
+ * releases its copy and uses the installed one.
+ */
+GenericCodeCoverage::PageType *GenericCodeCoverage::getPage(uint64_t addr,
+                                                            bool alloc) {
+    unsigned idir = static_cast<unsigned>(addr >> (PAGE_BITS + DIR_BITS));
+    unsigned ipage = static_cast<unsigned>(addr >> PAGE_BITS)
+                   & ((1u << DIR_BITS) - 1);
+    DirType *dir = dir_[idir];
+    if (!dir) {
+        if (!alloc) {
+            return 0;
+        }
+        DirType *t = new DirType;
+        memset(t, 0, sizeof(DirType));
+        dir = static_cast<DirType *>(RISCV_atomic_cas_ptr(
+            reinterpret_cast<void * volatile *>(&dir_[idir]), 0, t));
+        if (dir) {
+            delete t;
+        } else {
+            dir = t;
+        }
+    }
+    PageType *page = dir->page[ipage];
+    if (!page && alloc) {
+        PageType *t = new PageType;
+        memset(t, 0, sizeof(PageType));
+        page = static_cast<PageType *>(RISCV_atomic_cas_ptr(
+            reinterpret_cast<void * volatile *>(&dir->page[ipage]), 0, t));
+        if (page) {
+            delete t;
+        } else {
+            page = t;
+        }
+    }
+    return page;
+}
+
+/** Already marked words are only read, counters get newly set bits */
+void GenericCodeCoverage::markBits(PageType *page, uint64_t off,
+                                   uint64_t cnt) {
+    while (cnt) {
+        unsigned w = static_cast<unsigned>(off >> 5);
+        unsigned sh = static_cast<unsigned>(off & 0x1F);
+        unsigned n = 32 - sh;
+        if (n > cnt) {
+            n = static_cast<unsigned>(cnt);
+        }
+        uint32_t mask = (n == 32 ? ~0u : ((1u << n) - 1)) << sh;
+        if ((page->bits[w] & mask) != mask) {
+            uint32_t prev = RISCV_atomic_or32(&page->bits[w], mask);
+            int newbits = popcount32(mask & ~prev);
+            if (newbits) {
+                RISCV_atomic_add64(&page->used, newbits);
+            }
+        }
+        off += n;
+        cnt -= n;
+    }
+}
+
+uint64_t GenericCodeCoverage::countBits(PageType *page, uint64_t off,
+                                        uint64_t cnt) {
+    uint64_t ret = 0;
+    if (off == 0 && cnt == PAGE_SIZE) {
+        return page->used;
+    }
+    while (cnt) {
+        unsigned w = static_cast<unsigned>(off >> 5);
+        unsigned sh = static_cast<unsigned>(off & 0x1F);
+        unsigned n = 32 - sh;
+        if (n > cnt) {
+            n = static_cast<unsigned>(cnt);
+        }
+        uint32_t mask = (n == 32 ? ~0u : ((1u << n) - 1)) << sh;
+        ret += popcount32(page->bits[w] & mask);
+        off += n;
+        cnt -= n;
+    }
+    return ret;
+}
+
+/** Instruction at the end of the address space wraps to the zero address */
 void GenericCodeCoverage::markAddress(uint64_t addr, uint8_t oplen) {
-    addr = paged2flat(addr);
-    if (addr < sizeof(flash_)) {
-        flash_[addr] = oplen;
+    uint64_t sz = oplen;
+    addr &= ADDR_MASK;
+    while (sz) {
+        uint64_t off = addr & PAGE_MASK;
+        uint64_t cnt = PAGE_SIZE - off;
+        if (cnt > sz) {
+            cnt = sz;
+        }
+        markBits(getPage(addr, true), off, cnt);
+        addr = (addr + cnt) & ADDR_MASK;
+        sz -= cnt;
     }
 }
 
-uint64_t GenericCodeCoverage::paged2flat(uint64_t addr) {
-    if (!paged_.to_bool()) {
-        return addr;
+bool GenericCodeCoverage::isMarked(uint64_t addr) {
+    addr &= ADDR_MASK;
+    PageType *page = getPage(addr, false);
+    if (!page) {
+        return false;
     }
-    return addr % sizeof(flash_);
+    uint64_t off = addr & PAGE_MASK;
+    return (page->bits[off >> 5] >> (off & 0x1F)) & 1;
 }
 
-double GenericCodeCoverage::getCoverage() {
-    uint64_t used = 0;
-    uint64_t off = 0;
-    uint64_t inc_bytes;
-    double ret;
+/** Marked bytes in [start, end], not allocated directories are skipped */
+uint64_t GenericCodeCoverage::countRange(uint64_t start, uint64_t end) {
+    uint64_t ret = 0;
+    uint64_t addr = start & ADDR_MASK;
+    end &= ADDR_MASK;
+    while (addr <= end) {
+        uint64_t next;
+        if (!dir_[addr >> (PAGE_BITS + DIR_BITS)]) {
+            next = (addr | (DIR_SPAN - 1)) + 1;
+        } else {
+            next = (addr | PAGE_MASK) + 1;
+            if (next > end + 1) {
+                next = end + 1;
+            }
+            PageType *page = getPage(addr, false);
+            if (page) {
+                ret += countBits(page, addr & PAGE_MASK, next - addr);
+            }
+        }
+        if (next <= addr) {
+            break;      // end of address space
+        }
+        addr = next;
+    }
+    return ret;
+}
 
-    for (unsigned i = 0; i < regions_.size(); i++) {
-        AttributeType &item = regions_[i];
-        uint64_t sec_start = paged2flat(item[0u].to_uint32());
-        uint64_t sec_end = paged2flat(item[1].to_uint32());
-        uint64_t sec_sz = sec_end - sec_start + 1;
-        off = 0;
-        while (off < sec_sz) {
-            if (!flash_[sec_start + off]) {
-                off++;
-            } else {
-                inc_bytes = flash_[sec_start + off];
-                if ((sec_start + off + inc_bytes) > sec_end) {
-                    inc_bytes = 1 + sec_end - (sec_start + off);
-                }
-                used += inc_bytes;
-                off += inc_bytes;
+/** @return first address in [start, end] with the other state or end + 1 */
+uint64_t GenericCodeCoverage::findChange(uint64_t start, uint64_t end,
+                                         bool marked) {
+    uint64_t addr = start;
+    while (addr <= end) {
+        PageType *page = getPage(addr, false);
+        if (!page) {
+            if (marked) {
+                return addr;
             }
+            addr = (addr | PAGE_MASK) + 1;
+            continue;
+        }
+        uint64_t off = addr & PAGE_MASK;
+        uint32_t word = page->bits[off >> 5];
+        if ((off & 0x1F) == 0 && word == (marked ? ~0u : 0u)) {
+            addr += 32;
+            continue;
+        }
+        if (((word >> (off & 0x1F)) & 1) != (marked ? 1u : 0u)) {
+            return addr;
         }
+        addr++;
     }
+    return end + 1;
+}
 
-    ret = 100.0*static_cast<double>(used)/track_sz_;
-    return ret;
+double GenericCodeCoverage::getCoverage() {
+    uint64_t used = 0;
+    if (track_sz_ == 0) {
+        return 0;
+    }
+    for (unsigned i = 0; i < regions_.size(); i++) {
+        AttributeType &item = regions_[i];
+        used += countRange(item[0u].to_uint64(), item[1].to_uint64());
+    }
+    return 100.0*static_cast<double>(used)/track_sz_;
 }
 
 void GenericCodeCoverage::getCoverageDetailed(AttributeType *resp) {
     resp->attr_free();
     resp->make_list(0);
-    unsigned off;
-    uint8_t marked;
     AttributeType item;
     AttributeType symbol;
-    bool split_section;
-    enum EStage {
-        SectionMarked,
-        SectionCleared,
-    } estage;
     char tstr[256];
     item.make_list(4);
 
     for (unsigned i = 0; i < regions_.size(); i++) {
         AttributeType &region = regions_[i];
-        unsigned sec_start = region[0u].to_uint32();
-        unsigned sec_end = region[1].to_uint32();
-        unsigned sec_sz = sec_end - sec_start + 1;
-        unsigned sec_cnt = 0;
-        off = sec_start;
-        marked = flash_[paged2flat(sec_start)];
-
-        if (flash_[paged2flat(off)]) {
-            item[0u].make_boolean(true);
-            estage = SectionMarked;
-        } else {
-            item[0u].make_boolean(false);
-            estage = SectionCleared;
-        }
-        item[1].make_uint64(sec_start);        // start addess initial value
-        item[2].make_uint64(sec_start);        // end address initial value
-        isrc_->addressToSymbol(sec_start, &symbol);
-        RISCV_sprintf(tstr, sizeof(tstr), "%s+0x%x",
-                        symbol[0u].to_string(), symbol[1].to_uint32());
-        item[3].make_string(tstr);
-
-        while (sec_cnt < sec_sz) {
-            marked = flash_[paged2flat(off)];
-            split_section = false;
-
-            switch (estage) {
-            case SectionMarked:
-                if (!marked) {
-                    estage = SectionCleared;
-                    split_section = true;
-                }
-                break;
-            case SectionCleared:
-                if (marked) {
-                    estage = SectionMarked;
-                    split_section = true;
-                }
-                break;
-            default:;
-            }
-
-            if (split_section) {
-                resp->add_to_list(&item);
-
-                // init attribute for the next sections
-                item[0u].make_boolean(marked ? true: false);
-                item[1].make_uint64(off);               // start address
-                item[2].make_uint64(off);               // end address initial value
-                isrc_->addressToSymbol(off, &symbol);
-                RISCV_sprintf(tstr, sizeof(tstr), "%s+0x%x",
-                              symbol[0u].to_string(), symbol[1].to_uint32());
-                item[3].make_string(tstr);
-            }
+        uint64_t sec_start = region[0u].to_uint64() & ADDR_MASK;
+        uint64_t sec_end = region[1].to_uint64() & ADDR_MASK;
+        uint64_t off = sec_start;
+        while (off <= sec_end) {
+            bool marked = isMarked(off);
+            uint64_t next = findChange(off, sec_end, marked);
+            item[0u].make_boolean(marked);
+            item[1].make_uint64(off);               // start address
+            item[2].make_uint64(next - 1);          // end address
+            isrc_->addressToSymbol(off, &symbol);
+            RISCV_sprintf(tstr, sizeof(tstr), "%s+0x%x",
+                          symbol[0u].to_string(), symbol[1].to_uint32());
+            item[3].make_string(tstr);
+            resp->add_to_list(&item);
+            off = next;
+        }
+    }
+}
 
-            if (marked) {
-                for (uint8_t n = 0; n < marked; n++) {
-                    if (sec_cnt < sec_sz) {
-                        item[2].make_uint64(off);   // end address update
-                    }
-                    off++;
-                    sec_cnt++;
-                }
-            } else {
-                item[2].make_uint64(off);           // end address update
-                off++;
-                sec_cnt++;
-            }
+/** Functions with known size as [[name, addr, size, used bytes], *] */
+void GenericCodeCoverage::getFunctions(AttributeType *list) {
+    AttributeType symbols;
+    AttributeType item;
+    list->make_list(0);
+    if (!isrc_) {
+        return;
+    }
+    isrc_->getSymbols(&symbols);
+    item.make_list(4);
+    for (unsigned i = 0; i < symbols.size(); i++) {
+        AttributeType &symb = symbols[i];
+        uint64_t addr = symb[Symbol_Addr].to_uint64();
+        uint64_t sz = symb[Symbol_Size].to_uint64();
+        if (!(symb[Symbol_Type].to_uint64() & SYMBOL_TYPE_FUNCTION)
+            || sz == 0) {
+            continue;
         }
-        resp->add_to_list(&item);
+        item[0u].make_string(symb[Symbol_Name].to_string());
+        item[1].make_uint64(addr);
+        item[2].make_uint64(sz);
+        item[3].make_uint64(countRange(addr, addr + sz - 1));
+        list->add_to_list(&item);
+    }
+}
+
+/**
+ * Functions have no line information so that each of them is reported
+ * as one line with index in the symbols list. Function is hit when its
+ * entry point was executed.
+ */
+int GenericCodeCoverage::exportLcov(const char *filename,
+                                    const char *srcname) {
+    AttributeType funcs;
+    unsigned hit = 0;
+    FILE *fd = fopen(filename, "w");
+    if (!fd) {
+        return -1;
+    }
+    getFunctions(&funcs);
+    fprintf(fd, "TN:%s\nSF:%s\n", getObjName(), srcname);
+    for (unsigned i = 0; i < funcs.size(); i++) {
+        fprintf(fd, "FN:%u,%s\n", i + 1, funcs[i][0u].to_string());
+    }
+    for (unsigned i = 0; i < funcs.size(); i++) {
+        int entry = isMarked(funcs[i][1].to_uint64()) ? 1 : 0;
+        hit += entry;
+        fprintf(fd, "FNDA:%d,%s\n", entry, funcs[i][0u].to_string());
+    }
+    fprintf(fd, "FNF:%u\nFNH:%u\n", funcs.size(), hit);
+    for (unsigned i = 0; i < funcs.size(); i++) {
+        fprintf(fd, "DA:%u,%d\n", i + 1,
+                isMarked(funcs[i][1].to_uint64()) ? 1 : 0);
+    }
+    fprintf(fd, "LF:%u\nLH:%u\nend_of_record\n", funcs.size(), hit);
+    fclose(fd);
+    return 0;
+}
+
+/**
+ * Each function is reported as one line, so lines-covered/lines-valid count
+ * functions while line-rate is the part of executed bytes.
+ */
+int GenericCodeCoverage::exportCobertura(const char *filename,
+                                         const char *srcname) {
+    AttributeType funcs;
+    uint64_t used = 0;
+    uint64_t total = 0;
+    unsigned hit = 0;
+    FILE *fd = fopen(filename, "w");
+    if (!fd) {
+        return -1;
+    }
+    getFunctions(&funcs);
+    for (unsigned i = 0; i < funcs.size(); i++) {
+        total += funcs[i][2].to_uint64();
+        used += funcs[i][3].to_uint64();
+        hit += isMarked(funcs[i][1].to_uint64()) ? 1 : 0;
+    }
+    double rate = total ? static_cast<double>(used) / total : 0;
+
+    fprintf(fd, "<?xml version=\"1.0\" ?>\n");
+    fprintf(fd, "<coverage line-rate=\"%.4f\" branch-rate=\"0\" "
+                "lines-covered=\"%u\" lines-valid=\"%u\" "
+                "version=\"1.0\" timestamp=\"%" RV_PRI64 "d\">\n",
+                rate, hit, funcs.size(), static_cast<uint64_t>(time(0)));
+    fprintf(fd, "  <packages>\n"
+                "    <package name=\"%s\" line-rate=\"%.4f\">\n"
+                "      <classes>\n"
+                "        <class name=\"%s\" filename=\"%s\" "
+                "line-rate=\"%.4f\">\n"
+                "          <methods>\n",
+                getObjName(), rate, srcname, srcname, rate);
+    for (unsigned i = 0; i < funcs.size(); i++) {
+        AttributeType &f = funcs[i];
+        fprintf(fd, "            <method name=\"%s\" signature=\"\" "
+                    "line-rate=\"%.4f\">\n"
+                    "              <lines><line number=\"%u\" "
+                    "hits=\"%d\"/></lines>\n"
+                    "            </method>\n",
+                f[0u].to_string(),
+                static_cast<double>(f[3].to_uint64()) / f[2].to_uint64(),
+                i + 1, isMarked(f[1].to_uint64()) ? 1 : 0);
+    }
+    fprintf(fd, "          </methods>\n"
+                "          <lines>\n");
+    for (unsigned i = 0; i < funcs.size(); i++) {
+        fprintf(fd, "            <line number=\"%u\" hits=\"%d\"/>\n",
+                i + 1, isMarked(funcs[i][1].to_uint64()) ? 1 : 0);
     }
+    fprintf(fd, "          </lines>\n"
+                "        </class>\n"
+                "      </classes>\n"
+                "    </package>\n"
+                "  </packages>\n"
+                "</coverage>\n");
+    fclose(fd);
+    return 0;
 }
 
 }  // namespace debugger
@@ -12,6 +12,11 @@
  *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
  *  See the License for the specific language governing permissions and
  *  limitations under the License.
+ *
+ * @details    Executed bytes are marked in the sparse bitmap that covers
+ *             39-bits address space: directory of 16 MB blocks with 4 KB
+ *             pages allocated on the first access. Pages and counters are
+ *             updated lock-free so that several harts may share one tracker.
  */
 
 #pragma once
@@ -41,9 +46,13 @@ class CoverageCmdType : public ICommand {
             "        coverage ranges\n"
             "    3. Read list with detailed information and symbol names:\n"
             "        coverage detailed\n"
+            "    4. Export per function coverage in lcov or Cobertura XML:\n"
+            "        coverage lcov <file> [source_name]\n"
+            "        coverage cobertura <file> [source_name]\n"
             "Example:\n"
             "    coverage\n"
-            "    coverage detailed");
+            "    coverage detailed\n"
+            "    coverage lcov fw.info fw.c");
     }
 
     /** ICommand */
@@ -59,7 +68,8 @@ class GenericCodeCoverage : public IService,
                             public ICoverageTracker {
  public:
     explicit GenericCodeCoverage(const char *name);
- 
+    virtual ~GenericCodeCoverage();
+
     /** IService interface */
     virtual void postinitService();
     virtual void predeleteService();
@@ -70,22 +80,49 @@ class GenericCodeCoverage : public IService,
     /** Common commands access methods */
     virtual double getCoverage();
     virtual void getCoverageDetailed(AttributeType *resp);
+    /** @return 0 on success */
+    virtual int exportLcov(const char *filename, const char *srcname);
+    virtual int exportCobertura(const char *filename, const char *srcname);
 
  protected:
-    uint64_t paged2flat(uint64_t addr);
+    static const int ADDR_BITS = 39;
+    static const int PAGE_BITS = 12;
+    static const int DIR_BITS = 12;
+    static const uint64_t ADDR_MASK = (1ull << ADDR_BITS) - 1;
+    static const uint64_t PAGE_SIZE = 1ull << PAGE_BITS;
+    static const uint64_t PAGE_MASK = PAGE_SIZE - 1;
+    static const uint64_t DIR_SPAN = 1ull << (PAGE_BITS + DIR_BITS);
+    static const unsigned DIR_TOTAL = 1u << (ADDR_BITS - PAGE_BITS - DIR_BITS);
+
+    struct PageType {
+        volatile uint32_t bits[PAGE_SIZE / 32];
+        volatile uint64_t used;                 // marked bytes in page
+    };
+    struct DirType {
+        PageType * volatile page[1 << DIR_BITS];
+    };
+
+    PageType *getPage(uint64_t addr, bool alloc);
+    void markBits(PageType *page, uint64_t off, uint64_t cnt);
+    uint64_t countBits(PageType *page, uint64_t off, uint64_t cnt);
+    bool isMarked(uint64_t addr);
+    uint64_t countRange(uint64_t start, uint64_t end);
+    uint64_t findChange(uint64_t start, uint64_t end, bool marked);
+    void getFunctions(AttributeType *list);
+    void clearMap();
 
  protected:
     AttributeType cmdexec_;
     AttributeType src_;
     AttributeType regions_;
-    AttributeType paged_;
+    AttributeType paged_;       // not used, full address space is tracked
 
     ICmdExecutor *iexec_;
     ISourceCode *isrc_;
     CoverageCmdType *pcmd_;
 
     uint64_t track_sz_;
-    uint8_t flash_[128*1024];
+    DirType * volatile *dir_;   // DIR_TOTAL entries
 };
 
 DECLARE_CLASS(GenericCodeCoverage)
@@ -23,7 +23,9 @@ EdclService::EdclService(const char *name) : IService(name) {
     registerInterface(static_cast<ITap *>(this));
     registerAttribute("Transport", &transport_);
     registerAttribute("seq_cnt", &seq_cnt_);
+    registerAttribute("WindowSize", &windowSize_);
     seq_cnt_.make_uint64(0);
+    windowSize_.make_int64(16);
     itransport_ = 0;
 
     dbgRdTRansactionCnt_ = 0;
@@ -44,220 +46,259 @@ void EdclService::postinitService() {
 }
 
 int EdclService::read(uint64_t addr, int bytes, uint8_t *obuf) {
-    int txoff, rxoff;
-    UdpEdclCommonType req = {0};
-    UdpEdclCommonType rsp;
-    uint32_t align_addr;
-    uint32_t align_offset;
-    int align_length;
-    uint32_t obuf_len;
-    uint32_t obuf_off = 0;
+    EdclTransferType t;
+    if (!itransport_) {
+        RISCV_error("UDP transport not defined, addr=%x", addr);
+        return TAP_ERROR;
+    }
+    if (bytes <= 0) {
+        return 0;
+    }
 
-    align_offset = addr & 0x3ul;
-    align_addr = addr & ~0x3ul;
-    align_length = static_cast<int>((bytes + align_offset + 3) & ~0x3ul);
+    t.write = false;
+    t.offset = static_cast<int>(addr & 0x3ul);
+    t.align_addr = static_cast<uint32_t>(addr & ~0x3ul);
+    t.align_length = (bytes + t.offset + 3) & ~0x3;
+    t.bytes = bytes;
+    t.buf = obuf;
+    return transfer(&t);
+}
 
+int EdclService::write(uint64_t addr, int bytes, uint8_t *ibuf) {
+    EdclTransferType t;
     if (!itransport_) {
-        RISCV_error("UDP transport not defined, addr=%x", align_addr);
+        RISCV_error("UDP transport not defined, addr=%x", addr);
         return TAP_ERROR;
     }
+    if (bytes <= 0) {
+        return 0;
+    }
 
-    int rd_bytes = 0;
-    while (rd_bytes < align_length && rd_bytes != TAP_ERROR) {
-        req.control.request.seqidx = 
-                    static_cast<uint32_t>(seq_cnt_.to_uint64());
-        req.control.request.write = 0;
-        req.address = static_cast<uint32_t>(align_addr + rd_bytes);
-        if ((align_length - rd_bytes) > EDCL_PAYLOAD_MAX_BYTES) {
-            req.control.request.len = 
-                    static_cast<uint32_t>(EDCL_PAYLOAD_MAX_BYTES);
-        } else {
-            req.control.request.len =
-                static_cast<uint32_t>(align_length - rd_bytes);
+    t.write = true;
+    t.offset = static_cast<int>(addr & 0x3ul);
+    t.align_addr = static_cast<uint32_t>(addr & ~0x3ul);
+    t.align_length = (bytes + t.offset + 3) & ~0x3;
+    t.bytes = bytes;
+    t.buf = ibuf;
+
+    // Unaligned first and last words are modified partially:
+    if (t.offset != 0) {
+        if (read(t.align_addr, 4, t.head) == TAP_ERROR) {
+            return TAP_ERROR;
+        }
+    }
+    if (((t.offset + bytes) & 0x3) != 0) {
+        if (t.offset != 0 && t.align_length == 4) {
+            memcpy(t.tail, t.head, 4);
+        } else if (read(t.align_addr + t.align_length - 4, 4, t.tail)
+                    == TAP_ERROR) {
+            return TAP_ERROR;
         }
+    }
+    return transfer(&t);
+}
 
-        txoff = write16(tx_buf_, 0, req.offset);
-        txoff = write32(tx_buf_, txoff, req.control.word);
-        txoff = write32(tx_buf_, txoff, req.address);
+/**
+ * Sliding window of the requests without response. The slave accepts
+ * requests only with the expected sequence index and rejects others with
+ * NAK containing this expected index, so that only the rejected or lost
+ * requests are re-sent with the new indexes.
+ */
+int EdclService::transfer(EdclTransferType *t) {
+    int total = (t->align_length + EDCL_PAYLOAD_MAX_BYTES - 1)
+                / EDCL_PAYLOAD_MAX_BYTES;
+    int window = windowSize_.to_int();
+    int base = 0;               // the oldest request without response
+    int next = 0;               // the next new request
+    int retry = 0;
+    bool nakIgnore = false;     // NAKs on requests sent before resync
+    uint32_t nakSeq = 0;
+    UdpEdclCommonType rsp;
+    EdclSlotType *slot;
 
-        txoff = itransport_->sendData(tx_buf_, txoff);
-        if (txoff == -1) {
-            RISCV_error("Data sending error", NULL);
-            rd_bytes = TAP_ERROR;
-            break;
+    if (window < 1) {
+        window = 1;
+    } else if (window > EDCL_WINDOW_MAX) {
+        window = EDCL_WINDOW_MAX;
+    }
+
+    while (base < total) {
+        for (int i = base; i < next; i++) {
+            slot = &slots_[i % window];
+            if (slot->state != Slot_Resend) {
+                continue;
+            }
+            if (sendRequest(t, i, slot->seqidx) == -1) {
+                return TAP_ERROR;
+            }
+            slot->state = Slot_Sent;
+        }
+        while (next < total && (next - base) < window) {
+            slot = &slots_[next % window];
+            slot->seqidx = seq_cnt_.to_uint32() & EDCL_SEQIDX_MASK;
+            slot->state = Slot_Sent;
+            if (sendRequest(t, next, slot->seqidx) == -1) {
+                return TAP_ERROR;
+            }
+            seq_cnt_.make_uint64((slot->seqidx + 1) & EDCL_SEQIDX_MASK);
+            next++;
         }
 
-        dbgRdTRansactionCnt_++;
-        rxoff = itransport_->readData(rx_buf_, sizeof(rx_buf_));
+        int rxoff = itransport_->readData(rx_buf_, sizeof(rx_buf_));
         if (rxoff == -1) {
             RISCV_error("Data receiving error", NULL);
-            rd_bytes = TAP_ERROR;
-            break;
-        } 
+            return TAP_ERROR;
+        }
         if (rxoff == 0) {
-            RISCV_error("No response. Break read transaction[%d] at %08x",
-                        dbgRdTRansactionCnt_, req.address);
-            rd_bytes = TAP_ERROR;
-            break;
+            if (++retry > EDCL_RETRY_MAX) {
+                RISCV_error("No response. Break transaction[%d] at %08x",
+                            dbgRdTRansactionCnt_,
+                            t->align_addr + base * EDCL_PAYLOAD_MAX_BYTES);
+                return TAP_ERROR;
+            }
+            // Request or response was lost: repeat with the same indexes
+            for (int i = base; i < next; i++) {
+                slot = &slots_[i % window];
+                if (slot->state == Slot_Sent) {
+                    slot->state = Slot_Resend;
+                }
+            }
+            continue;
+        }
+        if (rxoff < static_cast<int>(sizeof(UdpEdclCommonType))) {
+            continue;
         }
+        retry = 0;
 
         rsp.control.word = read32(&rx_buf_[2]);
+        uint32_t seqidx = rsp.control.response.seqidx;
 
         const char *NAK[2] = {"ACK", "NAK"};
-        RISCV_debug("EDCL read: %s[%d], len = %d", 
+        RISCV_debug("EDCL %s: %s[%d], len = %d",
+                    t->write ? "write" : "read",
                     NAK[rsp.control.response.nak],
-                    rsp.control.response.seqidx,
+                    seqidx,
                     rsp.control.response.len);
 
-        // Retry with new sequence counter.
         if (rsp.control.response.nak) {
+            if (nakIgnore && seqidx == nakSeq) {
+                continue;
+            }
             RISCV_info("Sequence counter detected %d. Re-sending transaction.",
-                         rsp.control.response.seqidx);
-            seq_cnt_.make_uint64(rsp.control.response.seqidx);
+                         seqidx);
+            resyncWindow(base, next, window, seqidx);
+            nakIgnore = true;
+            nakSeq = seqidx;
             continue;
         }
 
-        // Try to receive next packet:
-        if (rsp.control.response.seqidx != seq_cnt_.to_uint32()) {
-            RISCV_error("Wrong ID received %d != %d. Try again.",
-                        seq_cnt_.to_uint32(), rsp.control.response.seqidx);
-
-            rxoff = itransport_->readData(rx_buf_, sizeof(rx_buf_));
-            if (rxoff <= 0) {
-                rd_bytes = TAP_ERROR;
-                break;
+        for (int i = base; i < next; i++) {
+            slot = &slots_[i % window];
+            if (slot->state == Slot_Done || slot->seqidx != seqidx) {
+                continue;
             }
-            rsp.control.word = read32(&rx_buf_[2]);
-            if (rsp.control.response.seqidx != seq_cnt_.to_uint32()) {
-                rd_bytes = TAP_ERROR;
-                break;
+            if (!t->write) {
+                storeResponse(t, i, rxoff - 10);
             }
+            slot->state = Slot_Done;
+            nakIgnore = false;
+            break;
         }
-
-        obuf_len = rsp.control.response.len;
-        if ((obuf_off + obuf_len) > static_cast<uint32_t>(bytes)) {
-            // exclude alignment bytes from buffer end
-            obuf_len = static_cast<uint32_t>(bytes) - obuf_off;
-        }
-        if (align_offset) {
-            if (rd_bytes == 0) {
-                memcpy(&obuf[obuf_off], &rx_buf_[10 + align_offset], obuf_len);
-                obuf_off += (rsp.control.response.len - align_offset);
-            } else {
-                memcpy(&obuf[obuf_off], &rx_buf_[10], obuf_len);
-                obuf_off += obuf_len;
-            }
-        } else {
-            memcpy(&obuf[obuf_off], &rx_buf_[10], obuf_len);
-            obuf_off += obuf_len;
+        while (base < next && slots_[base % window].state == Slot_Done) {
+            base++;
         }
-        rd_bytes += rsp.control.response.len;
-        seq_cnt_.make_uint64((seq_cnt_.to_uint64() + 1) & 0x3FFF);
     }
-    return bytes;
+    return t->bytes;
 }
 
-int EdclService::write(uint64_t addr, int bytes, uint8_t *ibuf) {
-    int off;
-    UdpEdclCommonType req = {0};
-    UdpEdclCommonType rsp;
-    uint32_t align_addr;
-    uint32_t align_offset;
-    uint32_t align_offset0;
-    int align_length;
-    uint32_t ibuf_len;
-    uint32_t ibuf_off = 0;
-    uint32_t ubytes = static_cast<uint32_t>(bytes);
-
-    if (!itransport_) {
-        RISCV_error("UDP transport not defined, addr=%x", addr);
-        return TAP_ERROR;
-    }
-
-    align_offset = addr & 0x3ul;
-    align_addr = addr & ~0x3ul;
-    align_length = static_cast<int>((bytes + align_offset + 3) & ~0x3ul);
-    align_offset0 = align_offset;
-
-    int wr_bytes = 0;
-    while (wr_bytes < align_length && wr_bytes != -1) {
-        req.control.request.seqidx =
-                    static_cast<uint32_t>(seq_cnt_.to_uint64());
-        req.control.request.write = 1;
-        req.address = static_cast<uint32_t>(align_addr + wr_bytes);
-        if ((align_length - wr_bytes) > EDCL_PAYLOAD_MAX_BYTES) {
-            req.control.request.len =
-                    static_cast<uint32_t>(EDCL_PAYLOAD_MAX_BYTES);
-        } else {
-            req.control.request.len =
-                    static_cast<uint32_t>(align_length - wr_bytes);
+/**
+ * Requests with the indexes starting from the expected one weren't
+ * accepted and get the new indexes. If the expected index isn't in the
+ * window at all, all requests without response are re-numbered.
+ */
+void EdclService::resyncWindow(int base, int next, int window,
+                               uint32_t expected) {
+    EdclSlotType *slot;
+    uint32_t oldest = seq_cnt_.to_uint32();
+    for (int i = base; i < next; i++) {
+        slot = &slots_[i % window];
+        if (slot->state != Slot_Done) {
+            oldest = slot->seqidx;
+            break;
         }
-
-        off = write16(tx_buf_, 0, req.offset);
-        off = write32(tx_buf_, off, req.control.word);
-        off = write32(tx_buf_, off, req.address);
-
-        ibuf_len = req.control.request.len;
-        // Alignment at the and of buffer
-        if (ibuf_off + req.control.request.len - align_offset0 > ubytes) {
-            read(req.address, 8, &tx_buf_[off]);
-            ibuf_len = align_offset0 + ubytes - ibuf_off;
+    }
+    uint32_t inflight = (seq_cnt_.to_uint32() - oldest) & EDCL_SEQIDX_MASK;
+    uint32_t accepted = (expected - oldest) & EDCL_SEQIDX_MASK;
+    bool desync = accepted >= inflight;
+    uint32_t seqidx = expected;
+
+    for (int i = base; i < next; i++) {
+        slot = &slots_[i % window];
+        if (slot->state == Slot_Done) {
+            continue;
         }
-        // Alignment at the begin of buffer
-        if (align_offset0 != 0) {
-            off += read(align_addr, align_offset, &tx_buf_[off]);
-            ibuf_len -= align_offset;
+        if (!desync
+            && ((slot->seqidx - oldest) & EDCL_SEQIDX_MASK) < accepted) {
+            continue;
         }
-        // seqidx can be modified by alingment reading
-        req.control.request.seqidx =
-                    static_cast<uint32_t>(seq_cnt_.to_uint64());
-        write32(tx_buf_, 2, req.control.word);
+        slot->seqidx = seqidx;
+        slot->state = Slot_Resend;
+        seqidx = (seqidx + 1) & EDCL_SEQIDX_MASK;
+    }
+    seq_cnt_.make_uint64(seqidx);
+}
 
-        memcpy(&tx_buf_[off], &ibuf[ibuf_off], ibuf_len);
-        ibuf_off += ibuf_len;
-        align_offset0 = 0;      // only for zero step
+int EdclService::sendRequest(EdclTransferType *t, int idx, uint32_t seqidx) {
+    UdpEdclCommonType req = {0};
+    int off = idx * EDCL_PAYLOAD_MAX_BYTES;
+    int len = t->align_length - off;
+    if (len > EDCL_PAYLOAD_MAX_BYTES) {
+        len = EDCL_PAYLOAD_MAX_BYTES;
+    }
 
-        off = itransport_->sendData(tx_buf_, 10 + req.control.request.len);
-        if (off == -1) {
-            RISCV_error("Data sending error", NULL);
-            wr_bytes = -1;
-            break;
+    req.control.request.seqidx = seqidx;
+    req.control.request.write = t->write ? 1 : 0;
+    req.control.request.len = static_cast<uint32_t>(len);
+    req.address = t->align_addr + static_cast<uint32_t>(off);
+
+    int txoff = write16(tx_buf_, 0, req.offset);
+    txoff = write32(tx_buf_, txoff, req.control.word);
+    txoff = write32(tx_buf_, txoff, req.address);
+
+    if (t->write) {
+        // Caller's data with the unmodified bytes of unaligned words
+        int from = off > t->offset ? off : t->offset;
+        int to = off + len < t->offset + t->bytes ? off + len
+                                                  : t->offset + t->bytes;
+        for (int i = off; i < from; i++) {
+            tx_buf_[txoff + i - off] = t->head[i & 0x3];
         }
-
-        off = itransport_->readData(rx_buf_, sizeof(rx_buf_));
-        if (off == -1) {
-            RISCV_error("Data receiving error", NULL);
-            wr_bytes = -1;
-            break;
-        } 
-        if (off == 0) {
-            RISCV_error("No response. Break write transaction.", NULL);
-            wr_bytes = -1;
-            break;
+        memcpy(&tx_buf_[txoff + from - off], &t->buf[from - t->offset],
+               to - from);
+        for (int i = to; i < off + len; i++) {
+            tx_buf_[txoff + i - off] = t->tail[i & 0x3];
         }
+        txoff += len;
+    }
 
-        rsp.control.word = read32(&rx_buf_[2]);
-
-        // Warning:
-        //   response length = 0;
-        const char *NAK[2] = {"ACK", "NAK"};
-        RISCV_debug("EDCL write: %s[%d], len = %d", 
-                    NAK[rsp.control.response.nak],
-                    rsp.control.response.seqidx,
-                    req.control.request.len);
-
-        // Retry with new sequence counter.
-        if (rsp.control.response.nak) {
-            RISCV_info("Sequence counter detected %d. Re-sending transaction.",
-                         rsp.control.response.seqidx);
-            seq_cnt_.make_uint64(rsp.control.response.seqidx);
-            continue;
-        }
+    dbgRdTRansactionCnt_++;
+    if (itransport_->sendData(tx_buf_, txoff) != txoff) {
+        RISCV_error("Data sending error", NULL);
+        return -1;
+    }
+    return txoff;
+}
 
-        wr_bytes += req.control.request.len;
-        seq_cnt_.make_uint64(seq_cnt_.to_uint64() + 1);
+/** Response data are copied directly into the caller's buffer */
+void EdclService::storeResponse(EdclTransferType *t, int idx, int len) {
+    int off = idx * EDCL_PAYLOAD_MAX_BYTES;
+    int from = off > t->offset ? off : t->offset;
+    int to = off + len < t->offset + t->bytes ? off + len
+                                              : t->offset + t->bytes;
+    if (to > from) {
+        memcpy(&t->buf[from - t->offset], &rx_buf_[10 + from - off],
+               to - from);
     }
-    return bytes;
 }
 
 int EdclService::write16(uint8_t *buf, int off, uint16_t v) {
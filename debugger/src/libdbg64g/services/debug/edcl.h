@@ -38,6 +38,33 @@ public:
     virtual int write(uint64_t addr, int bytes, uint8_t *ibuf);
 
 private:
+    /** Aligned memory range split on the EDCL requests */
+    struct EdclTransferType {
+        bool write;
+        uint32_t align_addr;    // 4-bytes aligned start address
+        int align_length;       // 4-bytes aligned length
+        int offset;             // caller's data offset in aligned range
+        int bytes;              // caller's data length
+        uint8_t *buf;           // caller's buffer
+        uint8_t head[4];        // first word content to keep on write
+        uint8_t tail[4];        // last word content to keep on write
+    };
+
+    /** Window slot state of the in-flight request */
+    enum ESlotState {
+        Slot_Sent,
+        Slot_Resend,
+        Slot_Done
+    };
+    struct EdclSlotType {
+        ESlotState state;
+        uint32_t seqidx;
+    };
+
+    int transfer(EdclTransferType *t);
+    int sendRequest(EdclTransferType *t, int idx, uint32_t seqidx);
+    void storeResponse(EdclTransferType *t, int idx, int len);
+    void resyncWindow(int base, int next, int window, uint32_t expected);
     int write16(uint8_t *buf, int off, uint16_t v);
     int write32(uint8_t *buf, int off, uint32_t v);
     uint32_t read32(uint8_t *buf);
@@ -47,13 +74,20 @@ private:
      * following value up to 242 words. */
     static const int EDCL_PAYLOAD_MAX_WORDS32 = 8;
     static const int EDCL_PAYLOAD_MAX_BYTES  = 4*EDCL_PAYLOAD_MAX_WORDS32;
+    /** Maximum number of requests without response */
+    static const int EDCL_WINDOW_MAX = 64;
+    /** Number of sequential timeouts before the error reporting */
+    static const int EDCL_RETRY_MAX = 3;
+    static const uint32_t EDCL_SEQIDX_MASK = 0x3FFF;
 
     uint8_t tx_buf_[4096];
     uint8_t rx_buf_[4096];
     ILink *itransport_;
     AttributeType transport_;
     AttributeType seq_cnt_;
+    AttributeType windowSize_;
 
+    EdclSlotType slots_[EDCL_WINDOW_MAX];
     int dbgRdTRansactionCnt_;
 };
 
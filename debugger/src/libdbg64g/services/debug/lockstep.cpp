@@ -0,0 +1,268 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <api_core.h>
+#include "lockstep.h"
+#include "coreservices/ireset.h"
+#include "coreservices/idport.h"
+#include <string.h>
+
+namespace debugger {
+
+LockstepChecker::LockstepChecker(const char *name)
+    : IService(name), IHap(HAP_ConfigDone) {
+    registerInterface(static_cast<IThread *>(this));
+    registerInterface(static_cast<IHap *>(this));
+    registerInterface(static_cast<ILockstepChecker *>(this));
+    registerAttribute("RefCpu", &refCpu_);
+    registerAttribute("HistoryDepth", &historyDepth_);
+    registerAttribute("StopOnError", &stopOnError_);
+
+    refCpu_.make_string("");
+    historyDepth_.make_int64(8);
+    stopOnError_.make_boolean(true);
+
+    RISCV_event_create(&eventConfigDone_, "lockstep_config_done");
+    RISCV_register_hap(static_cast<IHap *>(this));
+
+    iref_ = 0;
+    wcnt_ = 0;
+    rcnt_ = 0;
+    failed_ = false;
+    hist_ = 0;
+    histDepth_ = 0;
+    checked_ = 0;
+    descr_[0] = '\0';
+}
+
+LockstepChecker::~LockstepChecker() {
+    RISCV_event_close(&eventConfigDone_);
+    if (hist_) {
+        delete [] hist_;
+    }
+}
+
+void LockstepChecker::postinitService() {
+    iref_ = static_cast<ILockstepHart *>(
+        RISCV_get_service_iface(refCpu_.to_string(), IFACE_LOCKSTEP_HART));
+    if (!iref_) {
+        RISCV_error("ILockstepHart interface '%s' not found",
+                    refCpu_.to_string());
+        return;
+    }
+
+    histDepth_ = historyDepth_.to_int();
+    if (histDepth_ < 1) {
+        histDepth_ = 1;
+    }
+    hist_ = new HistoryType[histDepth_];
+    memset(hist_, 0, histDepth_ * sizeof(HistoryType));
+
+    const AttributeType *glb = RISCV_get_global_settings();
+    if ((*glb)["SimEnable"].to_bool()) {
+        if (!run()) {
+            RISCV_error("Can't create thread.", NULL);
+            return;
+        }
+    }
+}
+
+void LockstepChecker::hapTriggered(EHapType type,
+                                   uint64_t param,
+                                   const char *descr) {
+    RISCV_unregister_hap(static_cast<IHap *>(this));
+    RISCV_event_set(&eventConfigDone_);
+}
+
+/** Producer side: entry is published after it was completely written */
+void LockstepChecker::commitInstruction(const LockstepCommitType *c) {
+    while (wcnt_ - rcnt_ >= RING_SIZE) {
+        if (failed_ || !isEnabled()) {
+            return;
+        }
+        RISCV_sleep_ms(0);
+    }
+    if (failed_) {
+        return;
+    }
+    ring_[wcnt_ & (RING_SIZE - 1)] = *c;
+    RISCV_memory_barrier();
+    wcnt_ = wcnt_ + 1;
+}
+
+/**
+ * Reference hart is disabled and nobody else powers it on, so it would stay
+ * in the reset state and never retire an instruction.
+ */
+void LockstepChecker::startReference() {
+    const char *name = refCpu_.to_string();
+    IPower *ipwr = static_cast<IPower *>(
+        RISCV_get_service_iface(name, IFACE_POWER));
+    IDPort *idport = static_cast<IDPort *>(
+        RISCV_get_service_iface(name, IFACE_DPORT));
+    if (ipwr) {
+        ipwr->power(POWER_ON);
+    }
+    if (idport && idport->isHalted()) {
+        idport->resumereq();
+    }
+}
+
+void LockstepChecker::busyLoop() {
+    HistoryType *h;
+    RISCV_event_wait(&eventConfigDone_);
+    startReference();
+
+    while (isEnabled() && !failed_) {
+        if (rcnt_ == wcnt_) {
+            RISCV_sleep_ms(0);
+            continue;
+        }
+        RISCV_memory_barrier();
+        h = &hist_[checked_ % histDepth_];
+        h->dut = ring_[rcnt_ & (RING_SIZE - 1)];
+        RISCV_memory_barrier();
+        rcnt_ = rcnt_ + 1;
+
+        if (!iref_->stepCommit(&h->ref)) {
+            memset(&h->ref, 0, sizeof(h->ref));
+            RISCV_sprintf(descr_, sizeof(descr_), "%s",
+                          "reference hart doesn't retire instructions");
+            reportDivergence();
+        } else if (!compareCommit(&h->dut, &h->ref)) {
+            reportDivergence();
+        } else {
+            checked_++;
+        }
+    }
+    RISCV_info("%" RV_PRI64 "d instructions matched", checked_);
+}
+
+/** Returns number of memory accesses, writes into x0 are skipped */
+int LockstepChecker::splitActions(const LockstepCommitType *c,
+                                  const LockstepActionType **mem,
+                                  const LockstepActionType **reg) {
+    int memcnt = 0;
+    int regcnt = 0;
+    for (int i = 0; i < c->actioncnt; i++) {
+        const LockstepActionType *p = &c->action[i];
+        if (p->type != LockstepAction_Reg) {
+            mem[memcnt++] = p;
+        } else if (p->regidx != 0) {
+            reg[regcnt++] = p;
+        }
+    }
+    reg[regcnt] = 0;
+    return memcnt;
+}
+
+/**
+ * Models report register writes and memory accesses of one instruction
+ * in different order, so they are compared as two separate lists.
+ */
+bool LockstepChecker::compareCommit(const LockstepCommitType *dut,
+                                    const LockstepCommitType *ref) {
+    const LockstepActionType *dmem[LOCKSTEP_ACTIONS_MAX];
+    const LockstepActionType *dreg[LOCKSTEP_ACTIONS_MAX + 1];
+    const LockstepActionType *rmem[LOCKSTEP_ACTIONS_MAX];
+    const LockstepActionType *rreg[LOCKSTEP_ACTIONS_MAX + 1];
+    int dmemcnt, rmemcnt;
+
+    if (dut->pc != ref->pc) {
+        RISCV_sprintf(descr_, sizeof(descr_),
+                      "pc %08" RV_PRI64 "x != %08" RV_PRI64 "x",
+                      dut->pc, ref->pc);
+        return false;
+    }
+
+    dmemcnt = splitActions(dut, dmem, dreg);
+    rmemcnt = splitActions(ref, rmem, rreg);
+    if (dmemcnt != rmemcnt) {
+        RISCV_sprintf(descr_, sizeof(descr_),
+                      "%d memory accesses != %d", dmemcnt, rmemcnt);
+        return false;
+    }
+    for (int i = 0; i < dmemcnt; i++) {
+        if (dmem[i]->type != rmem[i]->type
+            || dmem[i]->size != rmem[i]->size
+            || dmem[i]->addr != rmem[i]->addr
+            || dmem[i]->data != rmem[i]->data) {
+            RISCV_sprintf(descr_, sizeof(descr_),
+                          "memory access %d mismatch", i);
+            return false;
+        }
+    }
+
+    for (int i = 0; dreg[i] || rreg[i]; i++) {
+        if (!dreg[i] || !rreg[i]) {
+            RISCV_sprintf(descr_, sizeof(descr_), "%s",
+                          "number of register writes mismatch");
+            return false;
+        }
+        if (dreg[i]->regidx != rreg[i]->regidx
+            || dreg[i]->data != rreg[i]->data) {
+            RISCV_sprintf(descr_, sizeof(descr_),
+                          "register write %d mismatch", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+void LockstepChecker::printCommit(const char *src,
+                                  const LockstepCommitType *c) {
+    RISCV_info("%s %9" RV_PRI64 "d: %08" RV_PRI64 "x: %08x",
+               src, c->cnt, c->pc, c->instr);
+    for (int i = 0; i < c->actioncnt; i++) {
+        const LockstepActionType *p = &c->action[i];
+        switch (p->type) {
+        case LockstepAction_Reg:
+            RISCV_info("%20s %c%-3d <= %016" RV_PRI64 "x",
+                       "", p->regidx < 32 ? 'x' : 'f', p->regidx & 0x1F,
+                       p->data);
+            break;
+        case LockstepAction_Load:
+            RISCV_info("%20s [%08" RV_PRI64 "x] => %016" RV_PRI64 "x (%d)",
+                       "", p->addr, p->data, p->size);
+            break;
+        default:
+            RISCV_info("%20s [%08" RV_PRI64 "x] <= %016" RV_PRI64 "x (%d)",
+                       "", p->addr, p->data, p->size);
+        }
+    }
+}
+
+/** Matched instructions are printed for context, then both models state */
+void LockstepChecker::reportDivergence() {
+    uint64_t start = 0;
+    if (checked_ >= static_cast<uint64_t>(histDepth_)) {
+        start = checked_ - histDepth_ + 1;
+    }
+    failed_ = true;
+    RISCV_error("Divergence after %" RV_PRI64 "d matched instructions: %s",
+                checked_, descr_);
+    for (uint64_t i = start; i < checked_; i++) {
+        printCommit("    ", &hist_[i % histDepth_].dut);
+    }
+    printCommit("dut ", &hist_[checked_ % histDepth_].dut);
+    printCommit("ref ", &hist_[checked_ % histDepth_].ref);
+
+    if (stopOnError_.to_bool()) {
+        RISCV_break_simulation();
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,97 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Checked model (RTL tracer) pushes retired instructions into
+ *             the single-producer single-consumer ring, checker thread
+ *             executes the same instruction on the reference hart and
+ *             compares PC, register writes and memory accesses.
+ *             Reference hart should have 'Enable' = false so that it
+ *             doesn't run its own thread, and it needs its own copy of
+ *             the memory with the same image.
+ */
+
+#ifndef __DEBUGGER_SERVICES_DEBUG_LOCKSTEP_H__
+#define __DEBUGGER_SERVICES_DEBUG_LOCKSTEP_H__
+
+#include "iclass.h"
+#include "iservice.h"
+#include "ihap.h"
+#include "coreservices/ithread.h"
+#include "coreservices/ilockstep.h"
+
+namespace debugger {
+
+class LockstepChecker : public IService,
+                        public IThread,
+                        public IHap,
+                        public ILockstepChecker {
+ public:
+    explicit LockstepChecker(const char *name);
+    virtual ~LockstepChecker();
+
+    /** IService interface */
+    virtual void postinitService() override;
+
+    /** IHap */
+    virtual void hapTriggered(EHapType type, uint64_t param,
+                              const char *descr) override;
+
+    /** ILockstepChecker */
+    virtual void commitInstruction(const LockstepCommitType *c) override;
+
+ protected:
+    /** IThread interface */
+    virtual void busyLoop() override;
+
+ private:
+    int splitActions(const LockstepCommitType *c,
+                     const LockstepActionType **mem,
+                     const LockstepActionType **reg);
+    bool compareCommit(const LockstepCommitType *dut,
+                       const LockstepCommitType *ref);
+    void printCommit(const char *src, const LockstepCommitType *c);
+    void reportDivergence();
+    void startReference();
+
+ private:
+    static const uint32_t RING_SIZE = 1024;     // power of 2
+
+    AttributeType refCpu_;
+    AttributeType historyDepth_;
+    AttributeType stopOnError_;
+
+    ILockstepHart *iref_;
+
+    LockstepCommitType ring_[RING_SIZE];
+    volatile uint32_t wcnt_;                    // written by producer only
+    volatile uint32_t rcnt_;                    // written by checker only
+    volatile bool failed_;
+
+    struct HistoryType {
+        LockstepCommitType dut;
+        LockstepCommitType ref;
+    } *hist_;
+    int histDepth_;
+    uint64_t checked_;
+    char descr_[256];
+
+    event_def eventConfigDone_;
+};
+
+DECLARE_CLASS(LockstepChecker)
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_SERVICES_DEBUG_LOCKSTEP_H__
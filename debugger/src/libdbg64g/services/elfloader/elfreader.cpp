@@ -211,7 +211,6 @@ int ElfReaderService::loadSections() {
             processDebugSymbol(sh);
         }
     }
-    symbolList_.sort(LoadSh_name);
     if (isrc_) {
         isrc_->addSymbols(&symbolList_);
     }
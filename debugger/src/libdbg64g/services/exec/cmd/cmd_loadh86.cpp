@@ -21,8 +21,38 @@
 
 namespace debugger {
 
-//char bindata[1 << 24] = {0};
-//char flgdata[1 << 24] = {0};
+/** Image converted into binary file with the fixed size */
+class BinImageLoader : public ImageLoader {
+ public:
+    explicit BinImageLoader(uint32_t sz) : ImageLoader(), sz_(sz) {
+        buf_ = new uint8_t[sz];
+        memset(buf_, 0, sz);
+    }
+    virtual ~BinImageLoader() {
+        delete [] buf_;
+    }
+
+    void save(const char *filename) {
+        FILE *fw = fopen(filename, "wb");
+        if (fw) {
+            fwrite(buf_, 1, sz_, fw);
+            fclose(fw);
+        }
+    }
+
+ protected:
+    virtual bool writeBlock(uint64_t addr, const uint8_t *buf, uint32_t sz) {
+        if (addr + sz > sz_) {
+            return false;
+        }
+        memcpy(&buf_[addr], buf, sz);
+        return true;
+    }
+
+ private:
+    uint8_t *buf_;
+    uint32_t sz_;
+};
 
 CmdLoadH86::CmdLoadH86(uint64_t dmibar, ITap *tap)
     : ICommand("loadh86", dmibar, tap) {
@@ -37,7 +67,6 @@ CmdLoadH86::CmdLoadH86(uint64_t dmibar, ITap *tap)
         "Example:\n"
         "    loadh86 /home/c166/image.h86\n"
         "    loadh86 /home/c166/image.h86 34603008 image.bin\n");
-    addr_msb_ = 0;
 }
 
 int CmdLoadH86::isValid(AttributeType *args) {
@@ -58,153 +87,42 @@ void CmdLoadH86::exec(AttributeType *args, AttributeType *res) {
     res->make_nil();
 
     const char *filename = (*args)[1].to_string();
-    FILE *fp = fopen(filename, "rb");
-    if (!fp) {
-        generateError(res, "File not found");
-        return;
-    }
-    fseek(fp, 0, SEEK_END);
-    int sz = ftell(fp);
-    rewind(fp);
-    uint8_t *image = new uint8_t[sz];
-    fread(image, 1, sz, fp);
-    fclose(fp);
-
-    int off = 0;
-    uint64_t sec_addr;
-    int sec_sz;
-    uint8_t sec_data[1024];
-    int code = 0;
-    int maxadr = 0;
-
-    uint8_t *binFileBuf = 0;
-    unsigned binFileSz = 0;
     if (args->size() == 4) {
         // Writing to binary file
-        binFileSz =(*args)[2].to_uint32();
-        binFileBuf = new uint8_t[binFileSz];
-    }
-
-    Reg64Type t1;
-    t1.val = 0;
-    t1.bits.b1 = 1; // ndmreset
-    uint64_t addr = DSUREGBASE(ulocal.v.dmcontrol);
-    if (binFileBuf == 0) {
-        tap_->write(addr, 8, t1.buf);
-    }
-
-    while (code != -1) {
-        code = readline(image, off, sec_addr, sec_sz, sec_data);
-        switch (code) {
-        case 0:
-            if (binFileBuf == 0) {
-                tap_->write(sec_addr, sec_sz, sec_data);
-                //memcpy(&bindata[sec_addr & 0xFFFFFF], sec_data, sec_sz);
-                //memset(&flgdata[sec_addr & 0xFFFFFF], 0xff, sec_sz);
-            } else if ((sec_addr + sec_sz) <= binFileSz) {
-                memcpy(&binFileBuf[sec_addr], sec_data, sec_sz);
-            } else {
-                generateError(res, "Wrong file size");
-                code = -1;
-            }
-            break;
-        case 1:
-            // End of file marker. Correct ending
-            code = -1;
-            break;
-        case 4:
-            addr_msb_ = (static_cast<int>(sec_data[0]) << 8) | sec_data[1];
-            if (addr_msb_ > maxadr) {
-                maxadr = addr_msb_;
-            }
-            //if (addr_msb_ >= 0x00c0 && addr_msb_ < 0x0100) {
-                //addr_msb_ -= 0x00c0;
-                //bool st = true;
-            //}
-            break;
-        case 5:
-            //generateError(res, "EIP not supported");
-            break;
-        default:
-            generateError(res, "Wrong file format");
-            code = -1;
-        }
-    }
-
-    if (binFileBuf) {
-        FILE *fw = fopen((*args)[3].to_string(), "wb");
-        if (fw) {
-            fwrite(binFileBuf, 1, binFileSz, fw);
-            fclose(fw);
+        BinImageLoader loader((*args)[2].to_uint32());
+        if (!loader.loadH86(filename)) {
+            generateError(res, loader.getError());
+            return;
         }
+        loader.save((*args)[3].to_string());
+        return;
     }
 
-    delete [] image;
-}
-
-uint8_t CmdLoadH86::str2byte(uint8_t *pair) {
-    uint8_t ret = 0;
-    for (int i = 0; i < 2; i++) {
-        ret <<= 4;
-        if (pair[i] >= '0' && pair[i] <= '9') {
-            ret |= pair[i] - '0';
-        } else if (pair[i] >= 'A' && pair[i] <= 'F') {
-            ret |= pair[i] - 'A' + 10;
-        } else if (pair[i] >= 'a' && pair[i] <= 'f') {
-            ret |= pair[i] - 'a' + 10;
-        }
+    if (tap_) {
+        Reg64Type t1;
+        t1.val = 0;
+        t1.bits.b1 = 1; // ndmreset
+        uint64_t addr = DSUREGBASE(ulocal.v.dmcontrol);
+        tap_->write(addr, 8, t1.buf);
     }
-    return ret;
-}
 
-bool CmdLoadH86::check_crc(uint8_t *str, int sz) {
-    uint8_t sum = 0;
-    uint8_t *cur = str;
-    for (int i = 0; i < sz; i++) {
-        sum += str2byte(cur);
-        cur += 2;
+    TargetImageLoader loader(this);
+    if (!loader.loadH86(filename)) {
+        generateError(res, loader.getError());
+        return;
     }
-    sum = ~sum + 1;
-    uint8_t ctrl = str2byte(cur);
-    return ctrl == sum;
+    RISCV_printf(NULL, LOG_INFO, "Loaded %s: %" RV_PRI64 "d bytes, %.1f MB/s",
+                 filename, loader.getLoadedBytes(), loader.getRateMBs());
 }
 
-int CmdLoadH86::readline(uint8_t *img, int &off,
-                         uint64_t &addr, int &sz, uint8_t *out) {
-    int retcode = -1;
-    if (img[off++] != ':') {
-        return retcode;
-    }
-
-    sz = str2byte(&img[off]);
-    if (!check_crc(&img[off], sz + 4)) {
-        return retcode;
-    }
-    off += 2;
-
-    addr = addr_msb_;
-    for (int i = 0; i < 2; i++) {
-        addr <<= 8;
-        addr += str2byte(&img[off]);
-        off += 2;
-    }
-
-    retcode = str2byte(&img[off]);
-    off += 2;
-
-    for (int i = 0; i < sz; i++) {
-        out[i] = static_cast<char>(str2byte(&img[off]));
-        off += 2;
-    }
-    off += 2;  // skip checksum
-    if (img[off] == '\r' && img[off + 1] == '\n') {
-        off += 2;
-    } else if (img[off] == '\n') {
-        off += 1;
-    } else {
-        return -1;
+bool CmdLoadH86::TargetImageLoader::writeBlock(uint64_t addr,
+                                              const uint8_t *buf,
+                                              uint32_t sz) {
+    uint8_t *data = const_cast<uint8_t *>(buf);
+    if (p_->tap_) {
+        return p_->tap_->write(addr, static_cast<int>(sz), data) != TAP_ERROR;
     }
-    return retcode;
+    return p_->dma_write(addr, sz, data) == TRANS_OK;
 }
 
 }  // namespace debugger
@@ -111,148 +111,42 @@ void CmdLoadSrec::exec(AttributeType *args, AttributeType *res) {
     res->attr_free();
     res->make_nil();
 
-    const char *filename = (*args)[1].to_string();
-    FILE *fp = fopen(filename, "rb");
-    if (!fp) {
-        char tstr[1024];
-        RISCV_sprintf(tstr, sizeof(tstr), "can't open file %s", filename);
-        generateError(res, tstr);
-        return;
+    if (tap_) {
+        Reg64Type t1;
+        t1.val = 0;
+        t1.bits.b1 = 1; // ndmreset
+        uint64_t addr = DSUREGBASE(ulocal.v.dmcontrol);
+        tap_->write(addr, 8, t1.buf);
     }
-    fseek(fp, 0, SEEK_END);
-    int sz = ftell(fp);
-    rewind(fp);
-    uint8_t *image = new uint8_t[sz];
-    fread(image, 1, sz, fp);
-    fclose(fp);
-
-    int off = check_header(image);
-
-    Reg64Type t1;
-    t1.val = 0;
-    t1.bits.b1 = 1; // ndmreset
-    uint64_t addr = DSUREGBASE(ulocal.v.dmcontrol);
-    tap_->write(addr, 8, t1.buf);
 
-    uint64_t sec_addr;
-    int sec_sz;
-    uint8_t sec_data[1024];
-    while ((off = readline(image, off, sec_addr, sec_sz, sec_data)) != 0) {
-        tap_->write(sec_addr, sec_sz, sec_data);
-#ifdef SHOW_USAGE_INFO
-        mark_addr(sec_addr, sec_sz);
-#endif
+    TargetImageLoader loader(this);
+    const char *filename = (*args)[1].to_string();
+    if (!loader.loadSrec(filename)) {
+        generateError(res, loader.getError());
+        return;
     }
+    RISCV_printf(NULL, LOG_INFO, "Loaded %s: %" RV_PRI64 "d bytes, %.1f MB/s",
+                 filename, loader.getLoadedBytes(), loader.getRateMBs());
 
 //    soft_reset = 0;
 //    tap_->write(addr, 8, reinterpret_cast<uint8_t *>(&soft_reset));
-    delete [] image;
 
 #ifdef SHOW_USAGE_INFO
     print_flash_usage();
 #endif
 }
 
-uint8_t CmdLoadSrec::str2byte(uint8_t *pair) {
-    uint8_t ret = 0;
-    for (int i = 0; i < 2; i++) {
-        ret <<= 4;
-        if (pair[i] >= '0' && pair[i] <= '9') {
-            ret |= pair[i] - '0';
-        } else if (pair[i] >= 'A' && pair[i] <= 'F') {
-            ret |= pair[i] - 'A' + 10;
-        } else if (pair[i] >= 'a' && pair[i] <= 'f') {
-            ret |= pair[i] - 'a' + 10;
-        }
-    }
-    return ret;
-}
-
-bool CmdLoadSrec::check_crc(uint8_t *str, int sz) {
-    uint8_t sum = 0;
-    uint8_t *cur = str;
-    for (int i = 0; i < sz; i++) {
-        sum += str2byte(cur);
-        cur += 2;
-    }
-    sum = ~sum;
-    uint8_t ctrl = str2byte(cur);
-    return ctrl == sum;
-}
-
-int CmdLoadSrec::check_header(uint8_t *img) {
-    int off = 2;
-    if (img[0] != 'S' || img[1] != '0') {
-        return 0;
-    }
-    uint8_t sz = str2byte(&img[off]);
-    if (!check_crc(&img[off], sz)) {
-        return 0;
-    }
-
-    off += 2;
-    uint16_t addr = str2byte(&img[off]);
-    off += 2;
-    addr = (addr << 8) + str2byte(&img[off]);
-    off += 2;
-    if (addr != 0) {
-        return 0;
-    }
-    for (int i = 0; i < sz - 3; i++) {  // size (1) + addr (2) = 3
-        header_data_[i] = static_cast<char>(str2byte(&img[off]));
-        header_data_[i + 1] = 0;
-        off += 2;
-    }
-    off += 2;  // skip checksum
-    if (img[off] != '\r' || img[off + 1] != '\n') {
-        return 0;
-    }
-    return off + 2;
-}
-
-int CmdLoadSrec::readline(uint8_t *img, int off,
-                          uint64_t &addr, int &sz, uint8_t *out) {
-    if (img[off++] != 'S') {
-        return 0;
-    }
-    int bytes4addr = 0;
-    switch (img[off++]) {    // 16-bits address only
-    case '1':
-        bytes4addr = 2; // 16-bits address
-        break;
-    case '2':
-        bytes4addr = 3; // 24-bits address
-        break;
-    case '3':
-        bytes4addr = 4; // 32-bits address
-        break;
-    default:
-        return 0;
-    }
-    sz = str2byte(&img[off]);
-    if (!check_crc(&img[off], sz)) {
-        return 0;
-    }
-    sz -= 1;
-    off += 2;
-
-    addr = 0;
-    for (int i = 0; i < bytes4addr; i++) {
-        addr <<= 8;
-        addr += str2byte(&img[off]);
-        off += 2;
-        sz--;
-    }
-
-    for (int i = 0; i < sz; i++) {
-        out[i] = static_cast<char>(str2byte(&img[off]));
-        off += 2;
-    }
-    off += 2;  // skip checksum
-    if (img[off] != '\r' || img[off + 1] != '\n') {
-        return 0;
+bool CmdLoadSrec::TargetImageLoader::writeBlock(uint64_t addr,
+                                              const uint8_t *buf,
+                                              uint32_t sz) {
+    uint8_t *data = const_cast<uint8_t *>(buf);
+#ifdef SHOW_USAGE_INFO
+    mark_addr(addr, sz);
+#endif
+    if (p_->tap_) {
+        return p_->tap_->write(addr, static_cast<int>(sz), data) != TAP_ERROR;
     }
-    return off + 2;
+    return p_->dma_write(addr, sz, data) == TRANS_OK;
 }
 
 }  // namespace debugger
@@ -20,6 +20,7 @@
 #include "api_core.h"
 #include "coreservices/itap.h"
 #include "coreservices/icommand.h"
+#include "../../mem/imgloader.h"
 
 namespace debugger {
 
@@ -32,14 +33,16 @@ class CmdLoadSrec : public ICommand  {
     virtual void exec(AttributeType *args, AttributeType *res);
 
  private:
-    uint8_t str2byte(uint8_t *pair);
-    bool check_crc(uint8_t *str, int sz);
-    int check_header(uint8_t *img);
-    int readline(uint8_t *img, int off,
-                 uint64_t &addr, int &sz, uint8_t *out);
-
- private:
-    char header_data_[1024];
+    /** Blocks are sent as bus bursts or through debug port */
+    class TargetImageLoader : public ImageLoader {
+     public:
+        explicit TargetImageLoader(CmdLoadSrec *p) : ImageLoader(), p_(p) {}
+     protected:
+        virtual bool writeBlock(uint64_t addr, const uint8_t *buf,
+                                uint32_t sz) override;
+     private:
+        CmdLoadSrec *p_;
+    };
 };
 
 }  // namespace debugger
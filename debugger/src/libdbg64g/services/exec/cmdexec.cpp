@@ -72,8 +72,10 @@ void CmdExecutor::postinitService() {
     registerCommand(new CmdExit(dmibar_.to_uint64(), 0));
     registerCommand(new CmdLoadBin(dmibar_.to_uint64(), 0));
     registerCommand(new CmdLoadElf(dmibar_.to_uint64(), 0));
-    registerCommand(new CmdLoadH86(dmibar_.to_uint64(), 0));
-    registerCommand(new CmdLoadSrec(dmibar_.to_uint64(), 0));
+    registerCommand(tcmd = new CmdLoadH86(dmibar_.to_uint64(), 0));
+    tcmd->enableDMA(ibus_, dmibar_.to_uint64());
+    registerCommand(tcmd = new CmdLoadSrec(dmibar_.to_uint64(), 0));
+    tcmd->enableDMA(ibus_, dmibar_.to_uint64());
     registerCommand(new CmdLog(dmibar_.to_uint64(), 0));
     registerCommand(new CmdMemDump(dmibar_.to_uint64(), 0));
     registerCommand(tcmd = new CmdRead(dmibar_.to_uint64(), 0));
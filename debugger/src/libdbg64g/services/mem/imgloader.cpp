@@ -0,0 +1,348 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include "api_core.h"
+#include "imgloader.h"
+#include <string.h>
+
+namespace debugger {
+
+#define X -1
+const int8_t ImageLoader::HEX2BIN[256] = {
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,       // '0'..'9'
+    X, 10, 11, 12, 13, 14, 15, X,                         // 'A'..'F'
+    X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, 10, 11, 12, 13, 14, 15, X,                         // 'a'..'f'
+    X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+    X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+};
+#undef X
+
+ImageLoader::ImageLoader() {
+    img_ = 0;
+    imgsz_ = 0;
+    line_ = 0;
+    blk_ = new uint8_t[BLOCK_SIZE];
+    blkaddr_ = 0;
+    blkcnt_ = 0;
+    loaded_ = 0;
+    t_start_ = 0;
+    t_end_ = 0;
+    error_[0] = '\0';
+}
+
+ImageLoader::~ImageLoader() {
+    RISCV_memory_release(img_, imgsz_ + 2);
+    delete [] blk_;
+}
+
+double ImageLoader::getRateMBs() {
+    uint64_t dt = t_end_ - t_start_;
+    if (dt == 0) {
+        dt = 1;
+    }
+    return (static_cast<double>(imgsz_) / (1024.0 * 1024.0))
+            / (static_cast<double>(dt) / 1000.0);
+}
+
+/**
+ * Two zero bytes after the end of file terminate any record, so the
+ * parsers may look ahead without checking the size.
+ */
+bool ImageLoader::openImage(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    error_[0] = '\0';
+    line_ = 1;
+    blkcnt_ = 0;
+    loaded_ = 0;
+    t_start_ = RISCV_get_time_ms();
+    t_end_ = t_start_;
+    RISCV_memory_release(img_, imgsz_ + 2);
+    img_ = 0;
+    imgsz_ = 0;
+    if (fp == NULL) {
+        RISCV_sprintf(error_, sizeof(error_), "can't open file %s", filename);
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    imgsz_ = static_cast<uint64_t>(ftell(fp));
+    fclose(fp);
+
+    img_ = static_cast<uint8_t *>(RISCV_memory_reserve(imgsz_ + 2));
+    if (img_ == 0) {
+        RISCV_sprintf(error_, sizeof(error_),
+                      "can't reserve %" RV_PRI64 "d bytes", imgsz_ + 2);
+        return false;
+    }
+    if (RISCV_memory_map_file(img_, imgsz_, filename) != imgsz_) {
+        RISCV_sprintf(error_, sizeof(error_), "can't read file %s", filename);
+        return false;
+    }
+    return true;
+}
+
+void ImageLoader::closeImage(bool ret) {
+    if (ret) {
+        flush();
+    }
+    t_end_ = RISCV_get_time_ms();
+}
+
+void ImageLoader::setError(const char *descr) {
+    RISCV_sprintf(error_, sizeof(error_), "line %" RV_PRI64 "d: %s",
+                  line_, descr);
+}
+
+bool ImageLoader::putData(uint64_t addr, const uint8_t *buf, uint32_t sz) {
+    if (blkcnt_ && (addr != blkaddr_ + blkcnt_
+                    || blkcnt_ + sz > BLOCK_SIZE)) {
+        if (!flush()) {
+            return false;
+        }
+    }
+    if (blkcnt_ == 0) {
+        blkaddr_ = addr;
+    }
+    memcpy(&blk_[blkcnt_], buf, sz);
+    blkcnt_ += sz;
+    return true;
+}
+
+bool ImageLoader::flush() {
+    bool ret = true;
+    if (blkcnt_) {
+        ret = writeBlock(blkaddr_, blk_, blkcnt_);
+        loaded_ += blkcnt_;
+        blkcnt_ = 0;
+    }
+    if (!ret && error_[0] == '\0') {
+        RISCV_sprintf(error_, sizeof(error_),
+                      "can't write block at %08" RV_PRI64 "x", blkaddr_);
+    }
+    return ret;
+}
+
+/** Returns -1 if there's a non-hex symbol among 2*cnt symbols */
+int ImageLoader::decodeRecord(const uint8_t *s, int cnt, uint8_t *out) {
+    int hi, lo;
+    for (int i = 0; i < cnt; i++) {
+        hi = HEX2BIN[s[0]];
+        lo = HEX2BIN[s[1]];
+        if ((hi | lo) < 0) {
+            return -1;
+        }
+        out[i] = static_cast<uint8_t>((hi << 4) | lo);
+        s += 2;
+    }
+    return 0;
+}
+
+bool ImageLoader::loadHex64(const char *filename) {
+    if (!openImage(filename)) {
+        closeImage(false);
+        return false;
+    }
+    const uint8_t *s = img_;
+    const uint8_t *end = img_ + imgsz_;
+    uint8_t word[8];
+    uint64_t addr = 0;
+    int pos = 7;
+    int hi = -1;
+    int v;
+    bool ret = true;
+    // Non-hex symbols are ignored even between two halves of a byte
+    while (s < end && ret) {
+        v = HEX2BIN[*s++];
+        if (v < 0) {
+            continue;
+        }
+        if (hi < 0) {
+            hi = v;
+            continue;
+        }
+        word[pos] = static_cast<uint8_t>((hi << 4) | v);
+        hi = -1;
+        if (--pos < 0) {
+            ret = putData(addr, word, 8);
+            addr += 8;
+            pos = 7;
+        }
+    }
+    if (ret && pos != 7) {
+        ret = putData(addr + pos + 1, &word[pos + 1], 7 - pos);
+    }
+    closeImage(ret);
+    return ret && error_[0] == '\0';
+}
+
+bool ImageLoader::loadSrec(const char *filename) {
+    if (!openImage(filename)) {
+        closeImage(false);
+        return false;
+    }
+    const uint8_t *s = img_;
+    const uint8_t *end = img_ + imgsz_;
+    uint8_t rec[256];
+    int cnt;
+    int addrbytes;
+    uint8_t rectype;
+    uint8_t sum;
+    uint64_t addr;
+    bool ret = true;
+    while (s < end && ret) {
+        if (*s == '\r' || *s == '\n' || *s == ' ' || *s == '\t') {
+            line_ += *s == '\n';
+            s++;
+            continue;
+        }
+        if (s[0] != 'S' || decodeRecord(&s[2], 1, rec) < 0) {
+            setError("wrong record");
+            ret = false;
+            break;
+        }
+        rectype = s[1];
+        cnt = rec[0];
+        if (decodeRecord(&s[4], cnt, &rec[1]) < 0) {
+            setError("wrong record length");
+            ret = false;
+            break;
+        }
+        sum = 0;
+        for (int i = 0; i < cnt; i++) {
+            sum += rec[i];
+        }
+        if (static_cast<uint8_t>(~sum) != rec[cnt]) {
+            setError("wrong checksum");
+            ret = false;
+            break;
+        }
+        s += 4 + 2 * cnt;
+
+        switch (rectype) {
+        case '1':
+            addrbytes = 2;
+            break;
+        case '2':
+            addrbytes = 3;
+            break;
+        case '3':
+            addrbytes = 4;
+            break;
+        case '7':
+        case '8':
+        case '9':
+            // Start address record terminates block
+            closeImage(true);
+            return error_[0] == '\0';
+        default:
+            // Header and record counters
+            addrbytes = 0;
+        }
+        if (addrbytes == 0 || cnt < addrbytes + 1) {
+            continue;
+        }
+        addr = 0;
+        for (int i = 1; i <= addrbytes; i++) {
+            addr = (addr << 8) | rec[i];
+        }
+        ret = putData(addr, &rec[1 + addrbytes], cnt - addrbytes - 1);
+    }
+    closeImage(ret);
+    return ret && error_[0] == '\0';
+}
+
+bool ImageLoader::loadH86(const char *filename) {
+    if (!openImage(filename)) {
+        closeImage(false);
+        return false;
+    }
+    const uint8_t *s = img_;
+    const uint8_t *end = img_ + imgsz_;
+    uint8_t rec[256 + 5];
+    int cnt;
+    uint8_t sum;
+    uint64_t base = 0;
+    uint64_t addr;
+    bool ret = true;
+    while (s < end && ret) {
+        if (*s == '\r' || *s == '\n' || *s == ' ' || *s == '\t') {
+            line_ += *s == '\n';
+            s++;
+            continue;
+        }
+        // :[len][addr16][type][data][checksum]
+        if (s[0] != ':' || decodeRecord(&s[1], 1, rec) < 0) {
+            setError("Wrong file format");
+            ret = false;
+            break;
+        }
+        cnt = rec[0];
+        if (decodeRecord(&s[3], cnt + 4, &rec[1]) < 0) {
+            setError("Wrong file format");
+            ret = false;
+            break;
+        }
+        sum = 0;
+        for (int i = 0; i < cnt + 5; i++) {
+            sum += rec[i];
+        }
+        if (sum != 0) {
+            setError("wrong checksum");
+            ret = false;
+            break;
+        }
+        s += 1 + 2 * (cnt + 5);
+
+        addr = (static_cast<uint64_t>(rec[1]) << 8) | rec[2];
+        switch (rec[3]) {
+        case 0:
+            ret = putData(base + addr, &rec[4], cnt);
+            break;
+        case 1:
+            // End of file marker. Correct ending
+            closeImage(true);
+            return error_[0] == '\0';
+        case 2:
+            base = ((static_cast<uint64_t>(rec[4]) << 8) | rec[5]) << 4;
+            break;
+        case 4:
+            base = ((static_cast<uint64_t>(rec[4]) << 8) | rec[5]) << 16;
+            break;
+        case 3:
+        case 5:
+            // Start address isn't used
+            break;
+        default:
+            setError("Wrong file format");
+            ret = false;
+        }
+    }
+    closeImage(ret);
+    return ret && error_[0] == '\0';
+}
+
+}  // namespace debugger
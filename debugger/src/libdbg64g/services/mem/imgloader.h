@@ -0,0 +1,77 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef __DEBUGGER_SERVICES_MEM_IMGLOADER_H__
+#define __DEBUGGER_SERVICES_MEM_IMGLOADER_H__
+
+#include <inttypes.h>
+
+namespace debugger {
+
+/**
+ * Text image parser: the whole file is mapped into memory, decoded with
+ * lookup table and contiguous records are merged into large blocks before
+ * they are passed to writeBlock().
+ */
+class ImageLoader {
+ public:
+    ImageLoader();
+    virtual ~ImageLoader();
+
+    /** Plain hex text, 8 bytes per 64-bits word in MSB first order */
+    bool loadHex64(const char *filename);
+    /** Motorola S-records */
+    bool loadSrec(const char *filename);
+    /** Intel HEX */
+    bool loadH86(const char *filename);
+
+    const char *getError() { return error_; }
+    uint64_t getFileSize() { return imgsz_; }
+    uint64_t getLoadedBytes() { return loaded_; }
+    double getRateMBs();
+
+ protected:
+    /** Returns false to stop loading */
+    virtual bool writeBlock(uint64_t addr, const uint8_t *buf,
+                            uint32_t sz) = 0;
+
+ private:
+    bool openImage(const char *filename);
+    void closeImage(bool ret);
+    bool putData(uint64_t addr, const uint8_t *buf, uint32_t sz);
+    bool flush();
+    int decodeRecord(const uint8_t *s, int cnt, uint8_t *out);
+    void setError(const char *descr);
+
+ private:
+    static const uint32_t BLOCK_SIZE = 1 << 16;
+    static const int8_t HEX2BIN[256];
+
+    uint8_t *img_;
+    uint64_t imgsz_;
+    uint64_t line_;
+    uint8_t *blk_;
+    uint64_t blkaddr_;
+    uint32_t blkcnt_;
+    uint64_t loaded_;
+    uint64_t t_start_;
+    uint64_t t_end_;
+    char error_[256];
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_SERVICES_MEM_IMGLOADER_H__
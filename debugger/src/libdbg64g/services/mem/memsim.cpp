@@ -27,13 +27,12 @@ MemorySim::MemorySim(const char *name)  : MemoryGeneric(name) {
 
     initFile_.make_string("");
     binaryFile_.make_boolean(false);
-    mem_ = NULL;
 }
 
 void MemorySim::postinitService() {
     MemoryGeneric::postinitService();
 
-    if (initFile_.size() == 0) {
+    if (!mem_ || initFile_.size() == 0) {
         return;
     }
 
@@ -48,80 +47,44 @@ void MemorySim::postinitService() {
 
     FILE *fp = fopen(initFile_.to_string(), "r");
     if (fp == NULL) {
-        for (uint64_t i = 0; i < length_.to_uint64()/4; i++) {
-            // NOP isntruction
-            reinterpret_cast<uint32_t *>(mem_)[i] = 0x00000013;  // intialize by NOPs
+        if (!fillPattern_.is_integer()) {
+            setFillPattern(0x00000013);     // intialize by NOPs
         }
         RISCV_error("Can't open '%s' file", initFile_.to_string());
         return;
     }
 
-    if (binaryFile_.to_bool()) {
-        fseek(fp, 0, SEEK_END);
-        uint64_t fsz = ftell(fp);
-        if (fsz > length_.to_uint64()) {
-            fsz = length_.to_uint64();
-        }
-        fseek(fp, 0, SEEK_SET);
-        fread(mem_, 1, static_cast<size_t>(fsz), fp);
-    } else {
-        bool bhalf = false;
-        int rd_symb;
-        uint8_t symb;
-        int linecnt = 0;
-        int symbinline = SYMB_IN_LINE - 1;
-        while (!feof(fp)) {
-            rd_symb = fgetc(fp);
-            if (!chishex(rd_symb))
-                continue;
-
-            if (!bhalf) {
-                bhalf = true;
-                symb = chtohex(rd_symb) << 4;
-                continue;
-            } 
-
-            bhalf = false;
-            symb |= chtohex(rd_symb) & 0xf;
-
-            if ((SYMB_IN_LINE * linecnt + symbinline) >= 
-                        static_cast<int>(length_.to_uint64())) {
-                RISCV_error("HEX file tries to write out "
-                            "of allocated array\n", NULL);
-                break;
-            } 
+    fclose(fp);
 
-            mem_[SYMB_IN_LINE * linecnt + symbinline] = symb;
-            if (--symbinline < 0) {
-                linecnt++;
-                symbinline = SYMB_IN_LINE - 1;
-            }
-        }
+    if (binaryFile_.to_bool()) {
+        // Image pages are shared with the file until the first write
+        uint64_t fsz = RISCV_memory_map_file(mem_, length_.to_uint64(),
+                                             initFile_.to_string());
+        setPagesLoaded(0, fsz);
+        return;
     }
-    fclose(fp);
-}
 
-bool MemorySim::chishex(int s) {
-    bool ret = false;
-    if (s >= '0' && s <= '9') {
-        ret = true;
-    } else if (s >= 'A' && s <= 'F') {
-        ret = true;
-    } else if (s >= 'a' && s <= 'f') {
-        ret = true;
+    MemImageLoader loader(this);
+    if (!loader.loadHex64(initFile_.to_string())) {
+        RISCV_error("%s", loader.getError());
     }
-    return ret;
+    RISCV_info("Loaded %s: %" RV_PRI64 "d bytes, %.1f MB/s",
+               initFile_.to_string(), loader.getLoadedBytes(),
+               loader.getRateMBs());
 }
 
-uint8_t MemorySim::chtohex(int s) {
-    if (s >= '0' && s <= '9') {
-        s -= '0';
-    } else if (s >= 'A' && s <= 'F') {
-        s = s - 'A' + 10;
-    } else if (s >= 'a' && s <= 'f') {
-        s = s - 'a' + 10;
+bool MemorySim::MemImageLoader::writeBlock(uint64_t addr,
+                                           const uint8_t *buf,
+                                           uint32_t sz) {
+    uint64_t len = p_->length_.to_uint64();
+    bool ret = true;
+    if (addr + sz > len) {
+        sz = addr < len ? static_cast<uint32_t>(len - addr) : 0;
+        ret = false;
     }
-    return static_cast<uint8_t>(s);
+    memcpy(&p_->mem_[addr], buf, sz);
+    p_->setPagesLoaded(addr, sz);
+    return ret;
 }
 
 }  // namespace debugger
@@ -18,6 +18,7 @@
 #define __DEBUGGER_SERVICES_MEM_MEMSIM_H__
 
 #include "generic/mem_generic.h"
+#include "imgloader.h"
 
 namespace debugger {
 
@@ -29,9 +30,15 @@ class MemorySim : public MemoryGeneric {
     virtual void postinitService() override;
 
  private:
-    static const int SYMB_IN_LINE = 16/2;
-    bool chishex(int s);
-    uint8_t chtohex(int s);
+    class MemImageLoader : public ImageLoader {
+     public:
+        explicit MemImageLoader(MemorySim *p) : ImageLoader(), p_(p) {}
+     protected:
+        virtual bool writeBlock(uint64_t addr, const uint8_t *buf,
+                                uint32_t sz) override;
+     private:
+        MemorySim *p_;
+    };
 
  private:
     AttributeType initFile_;
@@ -15,8 +15,30 @@
  */
 
 #include "gdbcmd.h"
+#include "coreservices/icpuarm.h"
+#include <riscv-isa.h>
 
 namespace debugger {
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+/** Register names in the order of GDB 'g' packet */
+static const char *const GDB_RV64_REGS[] = {
+    "zero", "ra", "sp", "gp", "tp", "t0", "t1", "t2",
+    "fp", "s1", "a0", "a1", "a2", "a3", "a4", "a5",
+    "a6", "a7", "s2", "s3", "s4", "s5", "s6", "s7",
+    "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6",
+    "pc", 0
+};
+
+/** ARM registers have the same indexes in the CPU registers bank */
+static const char *const GDB_ARM_REGS[] = {
+    "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+    "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc",
+    "cpsr", 0
+};
+static const int GDB_ARM_PC = 15;
+
 /*
 RspPacket::RspPacket(const char* const c_str) : RspPacket() {
     append('$');
@@ -50,6 +72,285 @@ uint8_t RspPacket::checksum(const char *data, const size_t sz) {
 
 GdbCommands::GdbCommands(IService *parent) : TcpCommandsGen(parent) {
     estate_ = State_AckMode;
+    packet_size_ = 0;
+
+    // Receive buffer should fit the whole packet of PacketSize bytes
+    delete [] rxbuf_;
+    rxtotal_ = 2 * DATA_MAX;
+    rxbuf_ = new char[rxtotal_];
+
+    char tstr[128];
+    RISCV_sprintf(tstr, sizeof(tstr), "%s_nbresp", parent_->getObjName());
+    RISCV_event_create(&eventNbResp_, tstr);
+
+    detectTarget();
+}
+
+GdbCommands::~GdbCommands() {
+    RISCV_event_close(&eventNbResp_);
+}
+
+void GdbCommands::nb_response(Axi4TransactionType *trans) {
+    nbResp_ = *trans;
+    RISCV_event_set(&eventNbResp_);
+}
+
+/**
+ * Find CPU registers interface and system bus so that the GDB packets are
+ * served without the text commands parsing.
+ */
+void GdbCommands::detectTarget() {
+    const char *const *regnames = 0;
+    const char *archname = "";
+    const char *feature = "";
+    int bits = 0;
+
+    arch_ = Arch_Unknown;
+    ibus_ = 0;
+    busMasterId_ = 0;
+    tdescsz_ = 0;
+    icpuriscv_ = static_cast<ICpuRiscV *>(
+        RISCV_get_service_iface(cpu_.to_string(), IFACE_CPU_RISCV));
+
+    IService *iservcpu = static_cast<IService *>(
+                        RISCV_get_service(cpu_.to_string()));
+    if (!iservcpu) {
+        return;
+    }
+    // Functional models name the bus 'SysBus', SystemC models 'Bus'
+    AttributeType *sysbus = static_cast<AttributeType *>(
+                        iservcpu->getAttribute("SysBus"));
+    if (!sysbus) {
+        sysbus = static_cast<AttributeType *>(iservcpu->getAttribute("Bus"));
+    }
+    if (sysbus && sysbus->is_string()) {
+        ibus_ = static_cast<IMemoryOperation *>(RISCV_get_service_iface(
+                    sysbus->to_string(), IFACE_MEMORY_OPERATION));
+    }
+    AttributeType *mstid = static_cast<AttributeType *>(
+                        iservcpu->getAttribute("SysBusMasterID"));
+    if (mstid && mstid->is_integer()) {
+        busMasterId_ = mstid->to_int();
+    }
+
+    if (icpuriscv_) {
+        arch_ = Arch_RV64;
+        regnames = GDB_RV64_REGS;
+        archname = "riscv:rv64";
+        feature = "org.gnu.gdb.riscv.cpu";
+        bits = 64;
+    } else if (icpufunc_ && RISCV_get_service_iface(cpu_.to_string(),
+                                                    IFACE_CPU_ARM)) {
+        arch_ = Arch_ARM;
+        regnames = GDB_ARM_REGS;
+        archname = "arm";
+        feature = "org.gnu.gdb.arm.core";
+        bits = 32;
+    } else {
+        RISCV_info("Registers access isn't supported for %s",
+                   cpu_.to_string());
+        return;
+    }
+
+    // Target description returned on qXfer:features:read:target.xml
+    int sz = sizeof(tdesc_);
+    tdescsz_ = RISCV_sprintf(tdesc_, sz,
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+        "<target version=\"1.0\">\n"
+        "<architecture>%s</architecture>\n"
+        "<feature name=\"%s\">\n", archname, feature);
+    for (int i = 0; regnames[i]; i++) {
+        const char *type = "int";
+        if (strcmp(regnames[i], "pc") == 0) {
+            type = "code_ptr";
+        } else if (strcmp(regnames[i], "sp") == 0) {
+            type = "data_ptr";
+        }
+        tdescsz_ += RISCV_sprintf(&tdesc_[tdescsz_], sz - tdescsz_,
+            "<reg name=\"%s\" bitsize=\"%d\" type=\"%s\"/>\n",
+            regnames[i], bits, type);
+    }
+    tdescsz_ += RISCV_sprintf(&tdesc_[tdescsz_], sz - tdescsz_,
+                              "</feature>\n</target>\n");
+}
+
+int GdbCommands::regTotal() {
+    if (arch_ == Arch_RV64) {
+        return 33;
+    } else if (arch_ == Arch_ARM) {
+        return 17;
+    }
+    return 0;
+}
+
+int GdbCommands::regBytes() {
+    return arch_ == Arch_RV64 ? 8 : 4;
+}
+
+uint64_t GdbCommands::readRegister(int regnum) {
+    if (arch_ == Arch_RV64) {
+        if (regnum < 32) {
+            return icpuriscv_->readGPR(regnum);
+        }
+        return icpuriscv_->readCSR(CSR_dpc);
+    }
+    if (regnum == GDB_ARM_PC) {
+        return icpufunc_->getNPC();
+    }
+    return icpufunc_->getpRegs()[regnum];
+}
+
+void GdbCommands::writeRegister(int regnum, uint64_t val) {
+    if (arch_ == Arch_RV64) {
+        if (regnum < 32) {
+            icpuriscv_->writeGPR(regnum, val);
+        } else {
+            icpuriscv_->writeCSR(CSR_dpc, val);
+        }
+        return;
+    }
+    if (regnum == GDB_ARM_PC) {
+        icpufunc_->setNPC(val);
+    } else {
+        icpufunc_->getpRegs()[regnum] = val;
+    }
+}
+
+ETransStatus GdbCommands::transport(Axi4TransactionType *tr) {
+    // Non-blocking access doesn't lock SystemC models
+    RISCV_event_clear(&eventNbResp_);
+    ETransStatus ret = ibus_->nb_transport(tr,
+                              static_cast<IAxi4NbResponse *>(this));
+    RISCV_event_wait(&eventNbResp_);
+    tr->rpayload = nbResp_.rpayload;
+    return ret;
+}
+
+/**
+ * Targets without system bus (FPGA board) are accessed through the
+ * 'read' command of the executor.
+ */
+int GdbCommands::readMemoryExec(uint64_t addr, int sz, uint8_t *obuf) {
+    AttributeType res;
+    char tstr[64];
+    if (!iexec_) {
+        return -1;
+    }
+    RISCV_sprintf(tstr, sizeof(tstr), "read 0x%" RV_PRI64 "x %d", addr, sz);
+    iexec_->exec(tstr, &res, false);
+    if (!res.is_data() || res.size() != static_cast<unsigned>(sz)) {
+        return -1;
+    }
+    memcpy(obuf, res.data(), sz);
+    return 0;
+}
+
+/** Data is sent as the list of 64-bits words by blocks of EXEC_WRITE_MAX */
+int GdbCommands::writeMemoryExec(uint64_t addr, int sz, const uint8_t *ibuf) {
+    AttributeType res;
+    char tstr[64 + 20 * (EXEC_WRITE_MAX / 8)];
+    if (!iexec_) {
+        return -1;
+    }
+    while (sz > 0) {
+        int chunk = sz < EXEC_WRITE_MAX ? sz : EXEC_WRITE_MAX;
+        int pos = RISCV_sprintf(tstr, sizeof(tstr),
+                                "write 0x%" RV_PRI64 "x %d [", addr, chunk);
+        for (int off = 0; off < chunk; off += 8) {
+            uint64_t val = 0;
+            for (int i = 0; i < 8 && off + i < chunk; i++) {
+                val |= static_cast<uint64_t>(ibuf[off + i]) << (8 * i);
+            }
+            pos += RISCV_sprintf(&tstr[pos], sizeof(tstr) - pos,
+                                 "%s0x%" RV_PRI64 "x", off ? "," : "", val);
+        }
+        RISCV_sprintf(&tstr[pos], sizeof(tstr) - pos, "%s", "]");
+        iexec_->exec(tstr, &res, false);
+        if (res.is_list() && res.size() && res[0u].is_equal("ERROR")) {
+            return -1;
+        }
+        addr += chunk;
+        ibuf += chunk;
+        sz -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * Memory pages mapped onto the host memory are copied with memcpy, other
+ * regions are accessed with the bus transactions.
+ */
+int GdbCommands::readMemory(uint64_t addr, int sz, uint8_t *obuf) {
+    Axi4TransactionType tr;
+    if (!ibus_) {
+        return readMemoryExec(addr, sz, obuf);
+    }
+    while (sz > 0) {
+        int chunk = 4096 - static_cast<int>(addr & 0xFFF);
+        if (chunk > sz) {
+            chunk = sz;
+        }
+        uint8_t *ptr = ibus_->getDirectPointer(addr, chunk, MemAction_Read);
+        if (ptr) {
+            memcpy(obuf, ptr, chunk);
+        } else {
+            tr.action = MemAction_Read;
+            tr.wstrb = 0;
+            tr.source_idx = busMasterId_;
+            for (int off = 0; off < chunk; off += tr.xsize) {
+                tr.addr = addr + off;
+                tr.xsize = 8 - static_cast<uint32_t>(tr.addr & 0x7);
+                if (tr.xsize > static_cast<uint32_t>(chunk - off)) {
+                    tr.xsize = chunk - off;
+                }
+                if (transport(&tr) != TRANS_OK) {
+                    return -1;
+                }
+                memcpy(&obuf[off], tr.rpayload.b8, tr.xsize);
+            }
+        }
+        addr += chunk;
+        obuf += chunk;
+        sz -= chunk;
+    }
+    return 0;
+}
+
+int GdbCommands::writeMemory(uint64_t addr, int sz, const uint8_t *ibuf) {
+    Axi4TransactionType tr;
+    if (!ibus_) {
+        return writeMemoryExec(addr, sz, ibuf);
+    }
+    while (sz > 0) {
+        int chunk = 4096 - static_cast<int>(addr & 0xFFF);
+        if (chunk > sz) {
+            chunk = sz;
+        }
+        uint8_t *ptr = ibus_->getDirectPointer(addr, chunk, MemAction_Write);
+        if (ptr) {
+            memcpy(ptr, ibuf, chunk);
+        } else {
+            tr.action = MemAction_Write;
+            tr.source_idx = busMasterId_;
+            for (int off = 0; off < chunk; off += tr.xsize) {
+                tr.addr = addr + off;
+                tr.xsize = 8 - static_cast<uint32_t>(tr.addr & 0x7);
+                if (tr.xsize > static_cast<uint32_t>(chunk - off)) {
+                    tr.xsize = chunk - off;
+                }
+                tr.wstrb = (1u << tr.xsize) - 1;
+                memcpy(tr.wpayload.b8, &ibuf[off], tr.xsize);
+                if (transport(&tr) != TRANS_OK) {
+                    return -1;
+                }
+            }
+        }
+        addr += chunk;
+        ibuf += chunk;
+        sz -= chunk;
+    }
+    return 0;
 }
 
 int GdbCommands::processCommand(const char *cmdbuf, int bufsz) {
@@ -73,8 +374,9 @@ int GdbCommands::processCommand(const char *cmdbuf, int bufsz) {
     }
 
     // Remove '$' start symbol and CRC at the end
-    memcpy(&packet_data_, &cmdbuf[1], bufsz - 4);
-    packet_data_[bufsz - 4] = '\0';
+    packet_size_ = bufsz - 4;
+    memcpy(&packet_data_, &cmdbuf[1], packet_size_);
+    packet_data_[packet_size_] = '\0';
 
     handlePacket(packet_data_);
     return bufsz;
@@ -212,10 +514,13 @@ void GdbCommands::handleQuery() {
         sendPacket("");
     } else if (strncmp("qSupported", 
                         packet_data_, strlen("qSupported")) == 0) {
-        /* Report a list of the features we support.
-         * 1000h == 4096
-         * 500h  == 1280 */
-        sendPacket("PacketSize=500;QStartNoAckMode+;vContSupported+");
+        /* Report a list of the features we support. */
+        char tstr[128];
+        RISCV_sprintf(tstr, sizeof(tstr),
+                      "PacketSize=%x;QStartNoAckMode+;vContSupported+%s",
+                      DATA_MAX,
+                      tdescsz_ ? ";qXfer:features:read+" : "");
+        sendPacket(tstr);
         //QNonStop+
     } else if (strncmp("qSymbol:", packet_data_, strlen("qSymbol:")) == 0) {
         /* Offer to look up symbols. Ignore for now */
@@ -230,8 +535,11 @@ void GdbCommands::handleQuery() {
     } else if (strncmp("qTStatus", packet_data_, strlen("qTStatus")) == 0) {
         /* Don't support tracing, return empty packet. */
         sendPacket("");
+    } else if (strncmp("qXfer:features:read:", packet_data_,
+                       strlen("qXfer:features:read:")) == 0) {
+        handleReadFeatures();
     } else if (strncmp("qXfer:", packet_data_, strlen("qXfer:")) == 0) {
-        /* No 'qXfer' requests supported, return empty packet. */
+        /* Other 'qXfer' objects aren't supported, return empty packet. */
         sendPacket("");
     } else {
         RISCV_error("Unrecognized RSP query: %s \n", packet_data_);
@@ -260,57 +568,32 @@ void GdbCommands::handleDetach() {
     sendPacket("OK");
 }
 
-void GdbCommands::appendRegValue(char *s, uint32_t value) {
-    char byte_hex[3];
-
-    RISCV_sprintf(byte_hex, 3, "%02X", value & 0xFF);
-    strncat(s, byte_hex, 2);
-    RISCV_sprintf(byte_hex, 3, "%02X", (value >> 8) & 0xFF);
-    strncat(s, byte_hex, 2);
-    RISCV_sprintf(byte_hex, 3, "%02X", (value >> 16) & 0xFF);
-    strncat(s, byte_hex, 2);
-    RISCV_sprintf(byte_hex, 3, "%02X", (value >> 24) & 0xFF);
-    strncat(s, byte_hex, 2);
-}
-
 void GdbCommands::handleGetRegisters() {
-    char resp[512] = "\0";
-    AttributeType res;
-
-    if (iexec_) {
-        iexec_->exec("regs", &res, false);
-    }
-    appendRegValue(resp, res["r0"].to_uint32());
-    appendRegValue(resp, res["r1"].to_uint32());
-    appendRegValue(resp, res["r2"].to_uint32());
-    appendRegValue(resp, res["r3"].to_uint32());
-    appendRegValue(resp, res["r4"].to_uint32());
-    appendRegValue(resp, res["r5"].to_uint32());
-    appendRegValue(resp, res["r6"].to_uint32());
-    appendRegValue(resp, res["r7"].to_uint32());
-    appendRegValue(resp, res["r8"].to_uint32());
-    appendRegValue(resp, res["r9"].to_uint32());
-    appendRegValue(resp, res["r10"].to_uint32());
-    appendRegValue(resp, res["r11"].to_uint32());
-    appendRegValue(resp, res["fp"].to_uint32());
-    appendRegValue(resp, res["sp"].to_uint32());
-    appendRegValue(resp, res["lr"].to_uint32());
-    appendRegValue(resp, res["pc"].to_uint32());
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);  // f0
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 96 / 8 * 2);  // f7
-    strncat(resp, "xxxxxxxxxxxxxxxxxxxxxxxxx", 32 / 8 * 2);  // fps
-    appendRegValue(resp, res["cpsr"].to_uint32());
-    sendPacket(resp);
+    if (regTotal() == 0) {
+        sendPacket("E01");
+        return;
+    }
+    char *resp = payload_;
+    for (int i = 0; i < regTotal(); i++) {
+        resp = appendRegValue(resp, readRegister(i));
+    }
+    sendPacket(payload_, static_cast<int>(resp - payload_));
 }
 
 void GdbCommands::handleSetRegisters() {
-    sendPacket("");
+    /* Syntax is: G<reg0><reg1>.. with the registers in 'g' packet order */
+    int bytes = regBytes();
+    if (regTotal() == 0 || packet_size_ - 1 < 2 * bytes * regTotal()) {
+        sendPacket("E01");
+        return;
+    }
+    Reg64Type u;
+    for (int i = 0; i < regTotal(); i++) {
+        u.val = 0;
+        hexToBin(&packet_data_[1 + 2 * bytes * i], 2 * bytes, u.buf);
+        writeRegister(i, u.val);
+    }
+    sendPacket("OK");
 }
 
 void GdbCommands::handleSetThread() {
@@ -330,103 +613,82 @@ void GdbCommands::handleGetMemory() {
      * Lowest address first, encoded as pairs of hex digits.
      * The length given is the number of bytes to be read.
      */
-    unsigned long address;
-    int len;
-    if (RISCV_sscanf(packet_data_, "m%lx,%x:", &address, &len) != 2) {
+    const char *p = &packet_data_[1];
+    uint64_t address = parseHex(&p);
+    if (*p++ != ',') {
         RISCV_info("Failed to recognize RSP read memory command: %s",
                     packet_data_);
         sendPacket("E01");
         return;
     }
-
-    AttributeType res;
-    char tstr[256];
-    RISCV_sprintf(tstr, sizeof(tstr), "read 0x%lx %d", address, len);
-
-    if (iexec_) {
-        iexec_->exec(tstr, &res, false);
+    uint64_t len = parseHex(&p);
+    if (len > sizeof(membuf_)) {
+        len = sizeof(membuf_);
     }
 
-    uint8_t *bts = res.data();
-    tstr[0] = 0;
-    for (size_t offset = 0; offset < res.size(); offset++) {
-        char byte_hex[3];
-        RISCV_sprintf(byte_hex, sizeof(byte_hex), "%02x", bts[offset]);
-        strncat(tstr, byte_hex, 2);
+    if (readMemory(address, static_cast<int>(len), membuf_) != 0) {
+        sendPacket("E01");
+        return;
     }
-
-    sendPacket(tstr);
+    char *resp = appendHex(payload_, membuf_, static_cast<int>(len));
+    sendPacket(payload_, static_cast<int>(resp - payload_));
 }
 
 void GdbCommands::handleWriteMemoryHex() {
-    sendPacket("");
+    /* Syntax is: M<addr>,<length>:<hex bytes> */
+    const char *p = &packet_data_[1];
+    uint64_t address = parseHex(&p);
+    uint64_t len = 0;
+    if (*p == ',') {
+        p++;
+        len = parseHex(&p);
+    }
+    int hexsz = packet_size_ - static_cast<int>(p - packet_data_) - 1;
+    if (*p != ':' || len > sizeof(membuf_)
+        || hexsz != 2 * static_cast<int>(len)) {
+        RISCV_info("Failed to recognize RSP write memory %s", packet_data_);
+        sendPacket("E01");
+        return;
+    }
+
+    hexToBin(p + 1, hexsz, membuf_);
+    if (writeMemory(address, static_cast<int>(len), membuf_) != 0) {
+        sendPacket("E01");
+        return;
+    }
+    sendPacket("OK");
 }
 
 void GdbCommands::handleReadRegister() {
-    unsigned int regnum;
-
-    if (RISCV_sscanf(packet_data_, "p%x", &regnum) != 1) {
+    const char *p = &packet_data_[1];
+    int regnum = static_cast<int>(parseHex(&p));
+    if (regnum >= regTotal()) {
         RISCV_info("Failed to recognize RSP read register "
                    "command: %s", packet_data_);
         sendPacket("E01");
         return;
     }
 
-    AttributeType res;
-    if (iexec_) {
-        iexec_->exec("regs", &res, false);
-    }
-
-    char resp[256] = "\0";
-    appendRegValue(resp, res.dict_value(regnum)->to_uint32());
-    sendPacket(resp);
+    char *resp = appendRegValue(payload_, readRegister(regnum));
+    sendPacket(payload_, static_cast<int>(resp - payload_));
 }
 
 void GdbCommands::handleWriteRegister() {
-    unsigned       regnum;            /* Register index */
-    char           byte0[3];  /* Data to set */
-    char           byte1[3];
-    char           byte2[3];
-    char           byte3[3];
-
-    if (RISCV_sscanf(packet_data_, "P%x=%2s%2s%2s%2s",
-               &regnum, byte0, byte1, byte2, byte3) != 5) {
+    /* Syntax is: P<regnum>=<value in target byte order> */
+    const char *p = &packet_data_[1];
+    int regnum = static_cast<int>(parseHex(&p));
+    int hexsz = packet_size_ - static_cast<int>(p - packet_data_) - 1;
+    if (*p != '=' || regnum >= regTotal() || hexsz > 2 * regBytes()) {
         RISCV_info("Failed to recognize RSP write register "
                    "command: %s", packet_data_);
         sendPacket("E01");
         return;
     }
 
-    AttributeType res;
-    char tstr[256];
-
-    /** Hardcode for ARM only */
-    char regname[10] = "\0";
-    if (regnum < 12) {
-        RISCV_sprintf(regname, sizeof(regname), "r%d", regnum);
-    } else if (regnum == 12) {
-        RISCV_sprintf(regname, sizeof(regname), "fp");
-    } else if (regnum == 13) {
-        RISCV_sprintf(regname, sizeof(regname), "sp");
-    } else if (regnum == 14) {
-        RISCV_sprintf(regname, sizeof(regname), "lr");
-    } else if (regnum == 15) {
-        RISCV_sprintf(regname, sizeof(regname), "pc");
-    } else if (regnum == 26) {
-        RISCV_sprintf(regname, sizeof(regname), "cpsr");
-    } else {
-        RISCV_info("Failed to recognize register: %d", regnum);
-        sendPacket("E01");
-        return;
-    }
-
-    RISCV_sprintf(tstr, sizeof(tstr), "reg %s 0x%s%s%s%s",
-                  regname, byte3, byte2, byte1, byte0);
-    RISCV_info("command: %s", tstr);
-
-    if (iexec_) {
-        iexec_->exec(tstr, &res, false);
-    }
+    Reg64Type u;
+    u.val = 0;
+    hexToBin(p + 1, hexsz, u.buf);
+    writeRegister(regnum, u.val);
     sendPacket("OK");
 }
 
@@ -469,42 +731,98 @@ void GdbCommands::handleVCommand() {
             iexec_->exec("c 1", &res, false);
             sendPacket("S05");
         }
+    } else if (strncmp(packet_data_, "vFlashErase:", 12) == 0) {
+        /* Memory is re-written without erasing */
+        sendPacket("OK");
+    } else if (strncmp(packet_data_, "vFlashWrite:", 12) == 0) {
+        handleFlashWrite();
+    } else if (strcmp(packet_data_, "vFlashDone") == 0) {
+        sendPacket("OK");
+    } else {
+        sendPacket("");
     }
 }
 
-void GdbCommands::handleWriteMemory() {
-    size_t         len;             /* Number of bytes to write */
-    unsigned long  address;         /* Where to write the memory */
-    const char     *data_ptr;       /* Pointer to the binary data */
+void GdbCommands::handleFlashWrite() {
+    /* Syntax is: vFlashWrite:<addr>:<binary data> */
+    const char *p = &packet_data_[12];
+    uint64_t address = parseHex(&p);
+    if (*p != ':') {
+        RISCV_info("Failed to recognize RSP flash write %s", packet_data_);
+        sendPacket("E01");
+        return;
+    }
+    p++;
+    int binsz = packet_size_ - static_cast<int>(p - packet_data_);
+    int len = unescapeBinary(p, binsz, membuf_);
+    if (writeMemory(address, len, membuf_) != 0) {
+        sendPacket("E01");
+        return;
+    }
+    sendPacket("OK");
+}
+
+void GdbCommands::handleReadFeatures() {
+    /* Syntax is: qXfer:features:read:<annex>:<offset>,<length>
+     * Reply 'm<data>' if there's more data or 'l<data>' for the last part */
+    const char *p = &packet_data_[strlen("qXfer:features:read:")];
+    if (tdescsz_ == 0 || strncmp(p, "target.xml:", 11) != 0) {
+        sendPacket("E00");
+        return;
+    }
+    p += 11;
+    uint64_t off = parseHex(&p);
+    uint64_t len = 0;
+    if (*p == ',') {
+        p++;
+        len = parseHex(&p);
+    }
+    if (off >= static_cast<uint64_t>(tdescsz_)) {
+        sendPacket("l");
+        return;
+    }
+    if (len > sizeof(payload_) - 1) {
+        len = sizeof(payload_) - 1;
+    }
+    payload_[0] = 'm';
+    if (off + len >= static_cast<uint64_t>(tdescsz_)) {
+        len = tdescsz_ - off;
+        payload_[0] = 'l';
+    }
+    memcpy(&payload_[1], &tdesc_[off], static_cast<size_t>(len));
+    sendPacket(payload_, static_cast<int>(len) + 1);
+}
 
-    if (RISCV_sscanf(packet_data_, "X%lx,%lx:", &address, &len) != 2) {
+void GdbCommands::handleWriteMemory() {
+    /* Syntax is: X<addr>,<length>:<binary data>
+     * Bytes '#', '$', '}' and '*' are escaped with '}' and XORed with 0x20 */
+    const char *p = &packet_data_[1];
+    uint64_t address = parseHex(&p);
+    uint64_t len = 0;
+    if (*p == ',') {
+        p++;
+        len = parseHex(&p);
+    }
+    if (*p != ':' || len > sizeof(membuf_)) {
         RISCV_info("Failed to recognize RSP write memory %s",
                    packet_data_);
         sendPacket("E01");
         return;
     }
+    p++;
 
-    data_ptr = static_cast<char*>(memchr(packet_data_, ':', DATA_MAX));
-    data_ptr++;
-    char data_hex[2 * DATA_MAX + 1];
-    data_hex[0] = '\0';
-
-    for (size_t offset = 0; offset < len; offset++) {
-        char byte_hex[3];
-        RISCV_sprintf(byte_hex, sizeof(byte_hex), "%02x", data_ptr[offset]);
-        strncat(data_hex, byte_hex, 2);
+    int binsz = packet_size_ - static_cast<int>(p - packet_data_);
+    binsz = unescapeBinary(p, binsz, membuf_);
+    if (binsz != static_cast<int>(len)) {
+        RISCV_info("Wrong RSP write memory length %d, expected %d",
+                   binsz, static_cast<int>(len));
+        sendPacket("E01");
+        return;
     }
-
-    AttributeType res;
-    // 32 should be enough for 'write 0x000000 9999 '
-    char tstr[DATA_MAX * 2 + 32];
-    RISCV_sprintf(tstr, sizeof(tstr), "write 0x%lx %lu 0x%s",
-                  address, len, data_hex);
-
-    if (iexec_) {
-        iexec_->exec(tstr, &res, false);
+    if (writeMemory(address, binsz, membuf_) != 0) {
+        sendPacket("E01");
+        return;
     }
-
     sendPacket("OK");
 }
 
@@ -545,8 +863,18 @@ void GdbCommands::handleBreakpoint() {
 }
 
 void GdbCommands::sendPacket(const char *data) {
-    int tsz = static_cast<int>(strlen(data));
-    respcnt_ = 0;
+    sendPacket(data, static_cast<int>(strlen(data)));
+}
+
+/**
+ * Responses on several packets received at once are accumulated in the
+ * response buffer until it is sent.
+ */
+void GdbCommands::sendPacket(const char *data, int tsz) {
+    if (respcnt_ + tsz + 8 > resptotal_) {
+        RISCV_error("Response buffer overflow %d", respcnt_ + tsz);
+        return;
+    }
     if (estate_ != State_NoAckMode) {
         respbuf_[respcnt_++] = '+';
     }
@@ -562,6 +890,64 @@ void GdbCommands::sendPacket(const char *data) {
     respbuf_[respcnt_] = '\0';
 }
 
+uint64_t GdbCommands::parseHex(const char **s) {
+    uint64_t ret = 0;
+    const char *p = *s;
+    while (1) {
+        if (*p >= '0' && *p <= '9') {
+            ret = (ret << 4) | static_cast<uint64_t>(*p - '0');
+        } else if (*p >= 'a' && *p <= 'f') {
+            ret = (ret << 4) | static_cast<uint64_t>(*p - 'a' + 10);
+        } else if (*p >= 'A' && *p <= 'F') {
+            ret = (ret << 4) | static_cast<uint64_t>(*p - 'A' + 10);
+        } else {
+            break;
+        }
+        p++;
+    }
+    *s = p;
+    return ret;
+}
+
+char *GdbCommands::appendHex(char *s, const uint8_t *buf, int sz) {
+    for (int i = 0; i < sz; i++) {
+        *s++ = HEX_DIGITS[buf[i] >> 4];
+        *s++ = HEX_DIGITS[buf[i] & 0xF];
+    }
+    *s = '\0';
+    return s;
+}
+
+char *GdbCommands::appendRegValue(char *s, uint64_t value) {
+    Reg64Type u;
+    u.val = value;
+    return appendHex(s, u.buf, regBytes());
+}
+
+int GdbCommands::hexToBin(const char *s, int sz, uint8_t *obuf) {
+    char tbyte[3] = {0};
+    int bytes = sz / 2;
+    for (int i = 0; i < bytes; i++) {
+        const char *p = tbyte;
+        tbyte[0] = s[2 * i];
+        tbyte[1] = s[2 * i + 1];
+        obuf[i] = static_cast<uint8_t>(parseHex(&p));
+    }
+    return bytes;
+}
+
+int GdbCommands::unescapeBinary(const char *s, int sz, uint8_t *obuf) {
+    int cnt = 0;
+    for (int i = 0; i < sz && cnt < DATA_MAX; i++) {
+        if (s[i] == '}' && i + 1 < sz) {
+            obuf[cnt++] = static_cast<uint8_t>(s[++i] ^ 0x20);
+        } else {
+            obuf[cnt++] = static_cast<uint8_t>(s[i]);
+        }
+    }
+    return cnt;
+}
+
 uint8_t GdbCommands::checksum(const char *data, const int sz) {
     uint8_t sum = 0;
     for (int i = 0; i < sz; i++) {
@@ -18,10 +18,15 @@
 #define __DEBUGGER_SERVICES_REMOTE_GDBCMD_H__
 
 #include "tcpcmd_gen.h"
+#include "coreservices/imemop.h"
+#include "coreservices/icpuriscv.h"
 
 namespace debugger {
 
-static const int DATA_MAX = 4096;
+/** Maximum packet size reported to GDB in qSupported response */
+static const int DATA_MAX = 1 << 16;
+/** Bytes per 'write' command when memory is accessed through executor */
+static const int EXEC_WRITE_MAX = 512;
 
 /*struct RspPacket {
     RspPacket() : size(0), is_good(false) {}
@@ -40,9 +45,14 @@ static const int DATA_MAX = 4096;
 };*/
 
 
-class GdbCommands : public TcpCommandsGen {
+class GdbCommands : public TcpCommandsGen,
+                    public IAxi4NbResponse {
  public:
     explicit GdbCommands(IService *parent);
+    virtual ~GdbCommands();
+
+    /** IAxi4NbResponse */
+    virtual void nb_response(Axi4TransactionType *trans);
 
  protected:
     virtual int processCommand(const char *cmdbuf, int bufsz);
@@ -53,7 +63,7 @@ class GdbCommands : public TcpCommandsGen {
         return s == '$';
     }
     virtual bool isEndMarker(const char *s, int sz) {
-        return s[sz - 3] == '#';
+        return sz >= 4 && s[sz - 3] == '#';
     }
 
  private:
@@ -61,6 +71,7 @@ class GdbCommands : public TcpCommandsGen {
     void handlePacket(char *data);
     uint8_t checksum(const char *data, const int sz);
     void sendPacket(const char *data);
+    void sendPacket(const char *data, int sz);
 
     // RSP packet handlers
     void handleStopReasonQuery();
@@ -81,14 +92,51 @@ class GdbCommands : public TcpCommandsGen {
     void handleVCommand();
     void handleWriteMemory();
     void handleBreakpoint();
-
-    void appendRegValue(char *s, uint32_t value);
+    void handleReadFeatures();
+    void handleFlashWrite();
+
+    // Direct target access bypassing command executor
+    void detectTarget();
+    int readMemory(uint64_t addr, int sz, uint8_t *obuf);
+    int writeMemory(uint64_t addr, int sz, const uint8_t *ibuf);
+    int readMemoryExec(uint64_t addr, int sz, uint8_t *obuf);
+    int writeMemoryExec(uint64_t addr, int sz, const uint8_t *ibuf);
+    ETransStatus transport(Axi4TransactionType *tr);
+    int regTotal();
+    int regBytes();
+    uint64_t readRegister(int regnum);
+    void writeRegister(int regnum, uint64_t val);
+
+    // Packet encoding helpers
+    uint64_t parseHex(const char **s);
+    char *appendHex(char *s, const uint8_t *buf, int sz);
+    char *appendRegValue(char *s, uint64_t value);
+    int hexToBin(const char *s, int sz, uint8_t *obuf);
+    int unescapeBinary(const char *s, int sz, uint8_t *obuf);
 
  private:
     //RspPacket previous_packet;
     //bool is_ack_mode;
     //bool last_success_;
-    char packet_data_[1 << 16];
+    char packet_data_[2 * DATA_MAX];
+    int packet_size_;
+    char payload_[2 * DATA_MAX + 16];
+    uint8_t membuf_[DATA_MAX];
+
+    enum ETargetArch {
+        Arch_Unknown,
+        Arch_RV64,
+        Arch_ARM
+    } arch_;
+    ICpuRiscV *icpuriscv_;
+    IMemoryOperation *ibus_;
+    int busMasterId_;
+    char tdesc_[4096];
+    int tdescsz_;
+
+    event_def eventNbResp_;
+    Axi4TransactionType nbResp_;
+
     enum EState {
         State_AckMode,
         State_WaitAckToSwitch,
@@ -19,14 +19,75 @@
 namespace debugger {
 
 JsonCommands::JsonCommands(IService *parent) : TcpCommandsGen(parent) {
+    binaryMode_ = false;
+}
+
+void JsonCommands::writeBinaryFrame(const AttributeType *msg,
+                                    AutoBuffer *buf) {
+    char hdr[BIN_HEADER_SIZE] = {static_cast<char>(BIN_FRAME_MARKER)};
+    int hdroff = buf->size();
+    buf->write_bin(hdr, BIN_HEADER_SIZE);
+    msg->to_binary(buf);
+
+    uint32_t len = static_cast<uint32_t>(buf->size() - hdroff
+                                         - BIN_HEADER_SIZE);
+    char *p = &buf->getBuffer()[hdroff + 1];
+    for (int i = 0; i < 4; i++) {
+        p[i] = static_cast<char>(len >> (8*i));
+    }
+}
+
+void JsonCommands::setResponse(const char *buf, int sz) {
+    if (sz > resptotal_) {
+        delete [] respbuf_;
+        resptotal_ = sz;
+        respbuf_ = new char[resptotal_];
+    }
+    memcpy(respbuf_, buf, sz);
+    respcnt_ = sz;
+}
+
+/** Error is sent in the framing of the request so the client keeps sync */
+void JsonCommands::setError(bool binary, const AttributeType *cmd,
+                            const char *descr) {
+    if (!binary) {
+        respcnt_ = RISCV_sprintf(respbuf_, resptotal_, "%s", descr);
+        return;
+    }
+    AttributeType msg;
+    AutoBuffer frame;
+    if (cmd && cmd->is_list() && cmd->size() && (*cmd)[0u].is_integer()) {
+        // Request id is known, the client waits for it
+        msg.make_list(2);
+        msg[0u] = (*cmd)[0u];
+        msg[1].make_list(2);
+        msg[1][0u].make_string("ERROR");
+        msg[1][1].make_string(descr);
+    } else {
+        msg.make_list(2);
+        msg[0u].make_string("ERROR");
+        msg[1].make_string(descr);
+    }
+    writeBinaryFrame(&msg, &frame);
+    setResponse(frame.getBuffer(), frame.size());
+}
+
+void JsonCommands::rejectFrame(const char *s, int sz) {
+    setError(static_cast<uint8_t>(s[0]) == BIN_FRAME_MARKER, 0,
+             "frame is too long");
 }
 
 int JsonCommands::processCommand(const char *cmdbuf, int bufsz) {
     AttributeType cmd;
-    cmd.from_config(rxbuf_);
+    bool binary = static_cast<uint8_t>(cmdbuf[0]) == BIN_FRAME_MARKER;
+    if (binary) {
+        cmd.from_binary(reinterpret_cast<const uint8_t *>(
+                        &cmdbuf[BIN_HEADER_SIZE]), bufsz - BIN_HEADER_SIZE);
+    } else {
+        cmd.from_config(rxbuf_);
+    }
     if (!cmd.is_list() || cmd.size() < 3) {
-        respcnt_ = RISCV_sprintf(respbuf_, resptotal_, "%s",
-                                 "wrong request format");
+        setError(binary, &cmd, "wrong request format");
         return 0;
     }
 
@@ -78,6 +139,15 @@ int JsonCommands::processCommand(const char *cmdbuf, int bufsz) {
         } else {
             resp.make_string("Wrong status command");
         }
+    } else if (requestType.is_equal("Protocol")) {
+        /** Select format of the responses and console output */
+        if (requestAction.is_equal("Binary")) {
+            binaryMode_ = true;
+        } else if (requestAction.is_equal("Text")) {
+            binaryMode_ = false;
+        } else {
+            resp.make_string("Wrong protocol");
+        }
     } else if (requestType.is_equal("Symbol")) {
         /** Symbols table conversion */
         if (requestAction[0u].is_equal("ToAddr")) {
@@ -92,6 +162,18 @@ int JsonCommands::processCommand(const char *cmdbuf, int bufsz) {
         resp[0u].make_string("ERROR");
         resp[1].make_string("Wrong command format");
     }
+
+    if (binary) {
+        AttributeType msg;
+        AutoBuffer frame;
+        msg.make_list(2);
+        msg[0u].make_uint64(idx);
+        msg[1] = resp;
+        writeBinaryFrame(&msg, &frame);
+        setResponse(frame.getBuffer(), frame.size());
+        return rxcnt_;
+    }
+
     resp.to_config();
 
     if (static_cast<int>(resp.size()) > (resptotal_ - 64)) {
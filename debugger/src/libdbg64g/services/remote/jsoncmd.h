@@ -18,19 +18,65 @@
 #define __DEBUGGER_SERVICES_REMOTE_JSONCMD_H__
 
 #include "tcpcmd_gen.h"
+#include <autobuffer.h>
 
 namespace debugger {
 
+/**
+ * Requests and responses are zero-terminated Python-literal strings by
+ * default. After the request ['Protocol','Binary'] the client may send
+ * binary frames and receives all responses and console output as frames:
+ *      marker byte 0xB1, uint32 payload length, AttributeType::to_binary()
+ * Text and binary requests are distinguished by the first byte.
+ */
 class JsonCommands : public TcpCommandsGen {
  public:
     explicit JsonCommands(IService *parent);
 
+    static const uint8_t BIN_FRAME_MARKER = 0xB1;
+    static const int BIN_HEADER_SIZE = 5;
+
+    virtual bool isBinaryMode() { return binaryMode_; }
+
+    static void writeBinaryFrame(const AttributeType *msg, AutoBuffer *buf);
+
  protected:
     virtual int processCommand(const char *cmdbuf, int bufsz);
     virtual bool isStartMarker(char s) { return true; }
     virtual bool isEndMarker(const char *s, int sz) {
+        if (static_cast<uint8_t>(s[0]) == BIN_FRAME_MARKER) {
+            return sz >= BIN_HEADER_SIZE
+                && sz == BIN_HEADER_SIZE + binaryFrameLength(s);
+        }
         return s[sz - 1] == '\0';
     }
+    virtual int frameSize(const char *s, int sz) {
+        if (static_cast<uint8_t>(s[0]) != BIN_FRAME_MARKER) {
+            return -1;
+        }
+        if (sz < BIN_HEADER_SIZE) {
+            return 0;
+        }
+        // Declared length is checked before the payload is received
+        uint32_t len = static_cast<uint32_t>(binaryFrameLength(s));
+        if (len > 0x7FFFFFFFu - BIN_HEADER_SIZE) {
+            return 0x7FFFFFFF;
+        }
+        return BIN_HEADER_SIZE + static_cast<int>(len);
+    }
+    virtual void rejectFrame(const char *s, int sz);
+
+ private:
+    static int binaryFrameLength(const char *s) {
+        const uint8_t *p = reinterpret_cast<const uint8_t *>(&s[1]);
+        return static_cast<int>(p[0] | (p[1] << 8) | (p[2] << 16)
+                                | (static_cast<uint32_t>(p[3]) << 24));
+    }
+    void setResponse(const char *buf, int sz);
+    void setError(bool binary, const AttributeType *cmd, const char *descr);
+
+ private:
+    bool binaryMode_;
 };
 
 }  // namespace debugger
@@ -57,6 +57,20 @@ void TcpClient::postinitService() {
 }
 
 int TcpClient::updateData(const char *buf, int buflen) {
+    if (tcpcmd_->isBinaryMode()) {
+        AttributeType msg;
+        AutoBuffer frame;
+        memcpy(asyncbuf_, buf, buflen);
+        asyncbuf_[buflen].ubyte = '\0';
+        msg.make_list(2);
+        msg[0u].make_string("Console");
+        msg[1].make_string(&asyncbuf_[0].ibyte);
+        JsonCommands::writeBinaryFrame(&msg, &frame);
+        sendData(reinterpret_cast<uint8_t *>(frame.getBuffer()),
+                 frame.size());
+        return buflen;
+    }
+
     int tsz = RISCV_sprintf(&asyncbuf_[0].ibyte, sizeof(asyncbuf_),
                     "['%s',", "Console");
 
@@ -75,9 +89,8 @@ void TcpClient::busyLoop() {
         RISCV_add_default_output(static_cast<IRawListener *>(this));
     }
 
-    txcnt_ = 0;
     while (isEnabled()) {
-        rxbytes = recv(hsock_, rcvbuf, sizeof(rcvbuf), 0);
+        rxbytes = recv(hsock_, rcvbuf, sizeof(rcvbuf) - 1, 0);
         if (rxbytes <= 0) {
             // Timeout:
             continue;
@@ -99,31 +112,27 @@ void TcpClient::busyLoop() {
     closeSocket();
 }
 
+/**
+ * Console output is sent from other threads, so the whole message is sent
+ * under lock to avoid interleaving with the response.
+ */
 int TcpClient::sendData(uint8_t *buf, int sz) {
-    RISCV_mutex_lock(&mutexTx_);
-    memcpy(txbuf_, buf, sz);
-    txbuf_[sz] = '\0';
-    txcnt_ = sz;
-    RISCV_mutex_unlock(&mutexTx_);
-
-    //RISCV_debug("o<=[%d]: %s", txcnt_, txbuf_);
-
-    int total = txcnt_;
-    char *ptx = txbuf_;
+    int total = sz;
+    char *ptx = reinterpret_cast<char *>(buf);
     int txbytes;
 
+    RISCV_mutex_lock(&mutexTx_);
     while (total > 0) {
         txbytes = send(hsock_, ptx, total, 0);
         if (txbytes <= 0) {
-            RISCV_error("Send error: txcnt=%d", txcnt_);
+            RISCV_mutex_unlock(&mutexTx_);
+            RISCV_error("Send error: txcnt=%d", sz);
             loopEnable_.state = false;
             return -1;
         }
         total -= txbytes;
         ptx += txbytes;
     }
-    RISCV_mutex_lock(&mutexTx_);
-    txcnt_ = 0;
     RISCV_mutex_unlock(&mutexTx_);
     return 0;
 }
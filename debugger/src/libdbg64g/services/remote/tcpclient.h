@@ -59,8 +59,6 @@ class TcpClient : public IService,
     socket_def hsock_;
     mutex_def mutexTx_;
     char rcvbuf[4096];
-    char txbuf_[1<<20];
-    int txcnt_;
     union reg8_type {
         char ibyte;
         uint8_t ubyte;
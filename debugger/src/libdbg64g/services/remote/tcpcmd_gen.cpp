@@ -20,7 +20,10 @@ namespace debugger {
 
 TcpCommandsGen::TcpCommandsGen(IService *parent) : IHap(HAP_All) {
     parent_ = parent;
+    rxtotal_ = 4096;        // should re-allocated if need in childs
     rxcnt_ = 0;
+    discard_ = 0;
+    rxbuf_ = new char[rxtotal_];
     estate_ = State_Idle;
 
     resptotal_ = 1 << 18;   // should re-allocated if need in childs
@@ -69,6 +72,8 @@ TcpCommandsGen::~TcpCommandsGen() {
     respcnt_ = 0;
     resptotal_ = 0;
     delete [] respbuf_;
+    rxtotal_ = 0;
+    delete [] rxbuf_;
 }
 
 void TcpCommandsGen::setPlatformConfig(AttributeType *cfg) {
@@ -91,6 +96,7 @@ void TcpCommandsGen::stepCallback(uint64_t t) {
 
 int TcpCommandsGen::updateData(const char *buf, int buflen) {
     int ret = 0;
+    int fsz;
     for (int i = 0; i < buflen; i++) {
         switch (estate_) {
         case State_Idle:
@@ -100,15 +106,43 @@ int TcpCommandsGen::updateData(const char *buf, int buflen) {
             }
             break;
         case State_Started:
-            if (rxcnt_ < static_cast<int>(sizeof(rxbuf_))) {
-                rxbuf_[rxcnt_++] = buf[i];
-                rxbuf_[rxcnt_] = '\0';
-            } else {
-                RISCV_error("rxbuf_ overflow %d", rxcnt_);
+            if (rxcnt_ >= rxtotal_ - 1) {
+                // Binary frames may carry large data blobs
+                char *t1 = new char[2 * rxtotal_];
+                memcpy(t1, rxbuf_, rxcnt_);
+                delete [] rxbuf_;
+                rxbuf_ = t1;
+                rxtotal_ *= 2;
             }
+            rxbuf_[rxcnt_++] = buf[i];
+            rxbuf_[rxcnt_] = '\0';
             if (isEndMarker(rxbuf_, rxcnt_)) {
                 estate_ = State_Ready;
+                break;
+            }
+            fsz = frameSize(rxbuf_, rxcnt_);
+            if (rxcnt_ < RX_FRAME_MAX - 1 && fsz <= RX_FRAME_MAX) {
+                break;
+            }
+            // Skip the rest of the frame to keep the stream in sync
+            RISCV_error("Frame of %d bytes is rejected",
+                        fsz > 0 ? fsz : rxcnt_);
+            rejectFrame(rxbuf_, rxcnt_);
+            discard_ = fsz > 0 ? fsz - rxcnt_ : fsz;
+            rxcnt_ = 0;
+            estate_ = discard_ != 0 ? State_Discard : State_Idle;
+            ret = i + 1;
+            break;
+        case State_Discard:
+            if (discard_ > 0) {
+                discard_--;
+            } else if (buf[i] == '\0') {
+                discard_ = 0;
+            }
+            if (discard_ == 0) {
+                estate_ = State_Idle;
             }
+            ret = i + 1;
             break;
         default:;
         }
@@ -60,11 +60,21 @@ class TcpCommandsGen : public IRawListener,
     uint8_t *response_buf() { return reinterpret_cast<uint8_t *>(respbuf_); }
     int response_size() { return respcnt_; }
     void done() { respcnt_ = 0; }
+    /** Asynchronous messages have to be sent using binary frames */
+    virtual bool isBinaryMode() { return false; }
 
  protected:
     virtual int processCommand(const char *cmdbuf, int bufsz) = 0;
     virtual bool isStartMarker(char s) = 0;
     virtual bool isEndMarker(const char *s, int sz) = 0;
+    /**
+     * Size of the received frame including header when it's known, 0 when
+     * the protocol re-synchronizes on the start marker and -1 when frames
+     * are zero-terminated.
+     */
+    virtual int frameSize(const char *s, int sz) { return 0; }
+    /** Frame longer than RX_FRAME_MAX is dropped, child may respond */
+    virtual void rejectFrame(const char *s, int sz) {}
 
     IFace *getInterface(const char *name) {
         return parent_->getInterface(name);
@@ -80,8 +90,12 @@ class TcpCommandsGen : public IRawListener,
     void power_off(const char *btn_name, AttributeType *res);
 
  protected:
-    char rxbuf_[4096];
+    static const int RX_FRAME_MAX = 16 << 20;
+
+    char *rxbuf_;
+    int rxtotal_;
     int rxcnt_;
+    int discard_;           // bytes left of the rejected frame
     AttributeType platformConfig_;
     AttributeType cpu_;
     AttributeType executor_;
@@ -107,7 +121,8 @@ class TcpCommandsGen : public IRawListener,
     enum EState {
         State_Idle,
         State_Started,
-        State_Ready
+        State_Ready,
+        State_Discard
     } estate_;
 };
 
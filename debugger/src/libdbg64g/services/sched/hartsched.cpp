@@ -0,0 +1,183 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <api_core.h>
+#include "hartsched.h"
+#include <string.h>
+
+namespace debugger {
+
+HartScheduler::HartScheduler(const char *name)
+    : IService(name), IHap(HAP_ConfigDone) {
+    registerInterface(static_cast<IThread *>(this));
+    registerInterface(static_cast<IHap *>(this));
+    registerInterface(static_cast<IHartScheduler *>(this));
+    registerAttribute("Mode", &mode_);
+    registerAttribute("QuantumSteps", &quantumSteps_);
+
+    mode_.make_string("Parallel");
+    quantumSteps_.make_uint64(100000);
+
+    RISCV_event_create(&eventConfigDone_, "hartsched_config_done");
+    RISCV_mutex_init(&mutexBarrier_);
+    RISCV_mutex_init(&mutexAtomic_);
+    RISCV_register_hap(static_cast<IHap *>(this));
+
+    quantumCnt_ = 0;
+    slotTotal_ = 0;
+    activeTotal_ = 0;
+    arrived_ = 0;
+    memset(slot_, 0, sizeof(slot_));
+}
+
+HartScheduler::~HartScheduler() {
+    for (int i = 0; i < slotTotal_; i++) {
+        RISCV_event_close(&slot_[i].ev);
+    }
+    RISCV_event_close(&eventConfigDone_);
+    RISCV_mutex_destroy(&mutexBarrier_);
+    RISCV_mutex_destroy(&mutexAtomic_);
+}
+
+void HartScheduler::postinitService() {
+    if (quantumSteps_.to_uint64() == 0) {
+        quantumSteps_.make_uint64(1);
+    }
+
+    const AttributeType *glb = RISCV_get_global_settings();
+    if (isRoundRobin() && (*glb)["SimEnable"].to_bool()) {
+        if (!run()) {
+            RISCV_error("Can't create thread.", NULL);
+            return;
+        }
+    }
+}
+
+void HartScheduler::hapTriggered(EHapType type,
+                                 uint64_t param,
+                                 const char *descr) {
+    RISCV_unregister_hap(static_cast<IHap *>(this));
+    RISCV_event_set(&eventConfigDone_);
+    RISCV_info("%d harts in %s mode, quantum %" RV_PRI64 "d steps",
+               activeTotal_, isRoundRobin() ? "round-robin" : "parallel",
+               getQuantum());
+}
+
+int HartScheduler::registerHart(IScheduledHart *ihart) {
+    char tstr[64];
+    int ret;
+    RISCV_mutex_lock(&mutexBarrier_);
+    ret = slotTotal_;
+    if (ret >= HARTS_MAX) {
+        RISCV_error("Maximum %d harts supported", HARTS_MAX);
+        RISCV_mutex_unlock(&mutexBarrier_);
+        return -1;
+    }
+    RISCV_sprintf(tstr, sizeof(tstr), "hartsched_slot%d", ret);
+    RISCV_event_create(&slot_[ret].ev, tstr);
+    slot_[ret].ihart = ihart;
+    slot_[ret].active = true;
+    slot_[ret].reserved = false;
+    slotTotal_++;
+    activeTotal_++;
+    RISCV_mutex_unlock(&mutexBarrier_);
+    return ret;
+}
+
+/** Exiting hart mustn't block others on the barrier */
+void HartScheduler::unregisterHart(int slot) {
+    RISCV_mutex_lock(&mutexBarrier_);
+    if (slot_[slot].active) {
+        slot_[slot].active = false;
+        activeTotal_--;
+        if (activeTotal_ && arrived_ >= activeTotal_) {
+            arrived_ = 0;
+            quantumCnt_++;
+            for (int i = 0; i < slotTotal_; i++) {
+                RISCV_event_set(&slot_[i].ev);
+            }
+        }
+    }
+    RISCV_mutex_unlock(&mutexBarrier_);
+}
+
+void HartScheduler::quantumBarrier(int slot) {
+    RISCV_mutex_lock(&mutexBarrier_);
+    if (++arrived_ < activeTotal_) {
+        RISCV_event_clear(&slot_[slot].ev);
+        RISCV_mutex_unlock(&mutexBarrier_);
+        RISCV_event_wait(&slot_[slot].ev);
+        return;
+    }
+    // The last hart opens barrier for others
+    arrived_ = 0;
+    quantumCnt_++;
+    for (int i = 0; i < slotTotal_; i++) {
+        if (i != slot) {
+            RISCV_event_set(&slot_[i].ev);
+        }
+    }
+    RISCV_mutex_unlock(&mutexBarrier_);
+}
+
+/** Single thread executes harts in the order of registration */
+void HartScheduler::busyLoop() {
+    uint64_t quantum = getQuantum();
+    RISCV_event_wait(&eventConfigDone_);
+
+    while (isEnabled()) {
+        for (int i = 0; i < slotTotal_; i++) {
+            if (slot_[i].active) {
+                slot_[i].ihart->runQuantum(quantum);
+            }
+        }
+        quantumCnt_++;
+    }
+}
+
+/** Reservation methods are called with locked mutexAtomic_ */
+void HartScheduler::reserveAddr(int slot, uint64_t addr) {
+    slot_[slot].reserved = true;
+    slot_[slot].resaddr = addr;
+}
+
+bool HartScheduler::releaseAddr(int slot, uint64_t addr) {
+    HartSlotType *p = &slot_[slot];
+    bool ret = p->reserved && p->resaddr == addr;
+    p->reserved = false;
+    if (ret) {
+        cancelReservations(slot, addr);
+    }
+    return ret;
+}
+
+void HartScheduler::storeAddr(int slot, uint64_t addr) {
+    cancelReservations(slot, addr);
+}
+
+void HartScheduler::cancelReservations(int slot, uint64_t addr) {
+    uint64_t line = addr & ~(RESERVATION_GRANULE - 1);
+    for (int i = 0; i < slotTotal_; i++) {
+        if (i == slot || !slot_[i].reserved) {
+            continue;
+        }
+        if ((slot_[i].resaddr & ~(RESERVATION_GRANULE - 1)) == line) {
+            slot_[i].reserved = false;
+        }
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,101 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#ifndef __DEBUGGER_SERVICES_SCHED_HARTSCHED_H__
+#define __DEBUGGER_SERVICES_SCHED_HARTSCHED_H__
+
+#include "iclass.h"
+#include "iservice.h"
+#include "ihap.h"
+#include "coreservices/ithread.h"
+#include "coreservices/ihartsched.h"
+
+namespace debugger {
+
+class HartScheduler : public IService,
+                      public IThread,
+                      public IHap,
+                      public IHartScheduler {
+ public:
+    explicit HartScheduler(const char *name);
+    virtual ~HartScheduler();
+
+    /** IService interface */
+    virtual void postinitService() override;
+
+    /** IHap */
+    virtual void hapTriggered(EHapType type, uint64_t param,
+                              const char *descr) override;
+
+    /** IHartScheduler */
+    virtual int registerHart(IScheduledHart *ihart) override;
+    virtual void unregisterHart(int slot) override;
+    /** Harts read mode in their postinit, so it's not cached */
+    virtual bool isRoundRobin() override {
+        return mode_.is_equal("RoundRobin");
+    }
+    virtual uint64_t getQuantum() override {
+        return quantumSteps_.to_uint64();
+    }
+    virtual uint64_t getGlobalStep() override {
+        return quantumCnt_ * getQuantum();
+    }
+    virtual void quantumBarrier(int slot) override;
+    virtual void lockAtomic() override { RISCV_mutex_lock(&mutexAtomic_); }
+    virtual void unlockAtomic() override {
+        RISCV_mutex_unlock(&mutexAtomic_);
+    }
+    virtual void reserveAddr(int slot, uint64_t addr) override;
+    virtual bool releaseAddr(int slot, uint64_t addr) override;
+    virtual void storeAddr(int slot, uint64_t addr) override;
+
+ protected:
+    /** IThread interface */
+    virtual void busyLoop() override;
+
+ private:
+    void cancelReservations(int slot, uint64_t addr);
+
+ private:
+    static const int HARTS_MAX = 64;
+    static const uint64_t RESERVATION_GRANULE = 64;     // cache line
+
+    AttributeType mode_;
+    AttributeType quantumSteps_;
+
+    volatile uint64_t quantumCnt_;
+
+    struct HartSlotType {
+        IScheduledHart *ihart;
+        bool active;
+        bool reserved;
+        uint64_t resaddr;
+        event_def ev;           // barrier passed
+    } slot_[HARTS_MAX];
+    int slotTotal_;
+    int activeTotal_;
+    int arrived_;
+
+    mutex_def mutexBarrier_;
+    mutex_def mutexAtomic_;
+    event_def eventConfigDone_;
+};
+
+DECLARE_CLASS(HartScheduler)
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_SERVICES_SCHED_HARTSCHED_H__
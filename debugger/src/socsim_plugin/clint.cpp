@@ -27,7 +27,11 @@ CLINT::CLINT(const char *name) : RegMemBankGeneric(name),
     mtime(static_cast<IService *>(this), "mtime", 0x00bff8) {
     registerInterface(static_cast<IIrqController *>(this));
     registerAttribute("Clock", &clock_);
+    irqListeners_.make_list(0);
+    iclk_ = 0;
     update_time_ = 0;
+    cb_armed_ = false;
+    cb_time_ = 0;
 }
 
 void CLINT::postinitService() {
@@ -39,12 +43,18 @@ void CLINT::postinitService() {
     if (!iclk_) {
         RISCV_error("Can't get IClock interface %s",
                     clock_.to_string());
+        return;
     }
+    for (unsigned i = 0; i < irqListeners_.size(); i++) {
+        notifyContext(irqListeners_[i][0u].to_int());
+    }
+    updateTimerIrq();
 }
 
 void CLINT::setTimer(uint64_t v) {
     update_time_ = iclk_->getStepCounter();
     mtime.setValue(v);
+    updateTimerIrq();
 }
 
 void CLINT::updateTimer() {
@@ -80,6 +90,95 @@ int CLINT::getPendingRequest(int ctxid) {
     return ret;
 }
 
+bool CLINT::registerIrqListener(int ctxid, IIrqListener *ilstn, int line) {
+    AttributeType &item = irqListeners_.new_list_item();
+    item.make_list(3);
+    item[0u].make_int64(ctxid);
+    item[1].make_iface(ilstn);
+    item[2].make_int64(line);
+    if (iclk_) {
+        notifyContext(ctxid);
+        updateTimerIrq();
+    }
+    return true;
+}
+
+void CLINT::notifyContext(int ctxid) {
+    if (!iclk_) {
+        return;
+    }
+    for (unsigned i = 0; i < irqListeners_.size(); i++) {
+        AttributeType &item = irqListeners_[i];
+        if (item[0u].to_int() != ctxid) {
+            continue;
+        }
+        IIrqListener *ilstn = static_cast<IIrqListener *>(item[1].to_iface());
+        ilstn->setIrqLine(item[2].to_int(), getPendingRequest(ctxid) != 0);
+    }
+}
+
+/**
+ * Update timer requests and schedule the nearest mtimecmp expiration so
+ * that listeners don't need to poll mtime on each step. Only one callback
+ * is kept pending: RTL clock cannot move already registered callback and
+ * registers a new one instead.
+ */
+void CLINT::updateTimerIrq() {
+    uint64_t cur_time;
+    uint64_t t;
+    uint64_t cmp;
+    uint64_t dt;
+    uint64_t expire = ~0ull;
+    int ctxid;
+    if (!iclk_) {
+        return;
+    }
+    updateTimer();
+    cur_time = iclk_->getStepCounter();
+    t = mtime.getValue().val;
+    for (unsigned i = 0; i < irqListeners_.size(); i++) {
+        ctxid = irqListeners_[i][0u].to_int();
+        if ((ctxid & 0x1) == 0) {
+            continue;
+        }
+        notifyContext(ctxid);
+
+        cmp = mtimecmp.getp()[ctxid / 2].val;
+        if (t >= cmp) {
+            continue;
+        }
+        dt = cmp - t;
+        if (dt < ~0ull - cur_time && (cur_time + dt) < expire) {
+            expire = cur_time + dt;
+        }
+    }
+    if (expire != ~0ull && (!cb_armed_ || expire < cb_time_)) {
+        cb_armed_ = true;
+        cb_time_ = expire;
+        iclk_->moveStepCallback(static_cast<IClockListener *>(this), expire);
+    }
+}
+
+void CLINT::stepCallback(uint64_t t) {
+    if (t >= cb_time_) {
+        // Stale RTL callback of the previous arming keeps the flag
+        cb_armed_ = false;
+    }
+    updateTimerIrq();
+}
+
+void CLINT::CLINT_MSIP_TYPE::write(int idx, uint32_t val) {
+    CLINT *p = static_cast<CLINT *>(parent_);
+    GenericReg32Bank::write(idx, val);
+    p->notifyContext(2*idx);
+}
+
+void CLINT::CLINT_MTIMECMP_TYPE::write(int idx, uint64_t val) {
+    CLINT *p = static_cast<CLINT *>(parent_);
+    GenericReg64Bank::write(idx, val);
+    p->updateTimerIrq();
+}
+
 uint64_t CLINT::CLINT_MTIME_TYPE::aboutToRead(uint64_t cur_val) {
     CLINT *p = static_cast<CLINT *>(parent_);
     p->updateTimer();
@@ -29,7 +29,8 @@ namespace debugger {
 static const int CLINT_HART_MAX = 4096;
 
 class CLINT : public RegMemBankGeneric,
-              public IIrqController {
+              public IIrqController,
+              public IClockListener {
  public:
     explicit CLINT(const char *name);
 
@@ -39,10 +40,17 @@ class CLINT : public RegMemBankGeneric,
     /** IIrqController */
     virtual int requestInterrupt(IFace *isrc, int idx) { return 0; }
     virtual int getPendingRequest(int ctxid);
+    virtual bool registerIrqListener(int ctxid, IIrqListener *ilstn,
+                                     int line);
+
+    /** IClockListener: nearest mtimecmp expired */
+    virtual void stepCallback(uint64_t t);
 
  private:
     void setTimer(uint64_t v);
     void updateTimer();
+    void notifyContext(int ctxid);
+    void updateTimerIrq();
 
  private:
 
@@ -50,6 +58,8 @@ class CLINT : public RegMemBankGeneric,
      public:
         CLINT_MSIP_TYPE(IService *parent, const char *name, uint64_t addr)
             : GenericReg32Bank(parent, name, addr, CLINT_HART_MAX) {}
+
+        virtual void write(int idx, uint32_t val) override;
     };
 
     class CLINT_MTIMECMP_TYPE : public GenericReg64Bank {
@@ -58,6 +68,8 @@ class CLINT : public RegMemBankGeneric,
             : GenericReg64Bank(parent, name, addr, CLINT_HART_MAX - 1) {
             // shouldn't be reset on reset signal
         }
+
+        virtual void write(int idx, uint64_t val) override;
     };
 
     class CLINT_MTIME_TYPE : public MappedReg64Type {
@@ -71,6 +83,7 @@ class CLINT : public RegMemBankGeneric,
     };
 
     AttributeType clock_;
+    AttributeType irqListeners_;    // [[ctxid, IIrqListener, line], *]
 
     IClock *iclk_;
 
@@ -79,6 +92,8 @@ class CLINT : public RegMemBankGeneric,
     CLINT_MTIME_TYPE mtime;          // [00bff8] 1 register for all hart
 
     uint64_t update_time_;          // Last time when mtime was updated
+    bool cb_armed_;                 // step callback is pending
+    uint64_t cb_time_;              // time of the pending step callback
 };
 
 DECLARE_CLASS(CLINT)
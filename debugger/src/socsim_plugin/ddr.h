@@ -33,19 +33,15 @@ class DDR : public IService,
 
     /** IMemoryOperation */
     virtual ETransStatus b_transport(Axi4TransactionType *trans);
+    virtual bool isBurstSupported() { return true; }
+    virtual uint8_t *getDirectPointer(uint64_t addr, uint64_t sz,
+                                      EAxi4Action action);
 
  private:
-    virtual uint8_t *getpMem(uint64_t addr);
+    ETransStatus burstTransport(Axi4TransactionType *trans, uint64_t off);
 
  protected:
-    static const int BLOCK_SIZE = 1024*1024;
-
-    struct MemBlockType {
-        MemBlockType *nxt;
-        MemBlockType *prv;
-        uint64_t bid;
-        uint8_t m[BLOCK_SIZE];
-    } mem_;
+    uint8_t *mem_;      // reserved at once, committed by host on touch
 };
 
 DECLARE_CLASS(DDR)
@@ -29,6 +29,7 @@ PLIC::PLIC(const char *name) : RegMemBankGeneric(name),
 
     contextList_.make_list(0);
     pendingList_.make_list(0);
+    irqListeners_.make_list(0);
     ctx_enable = 0;
     ctx_priority_th = 0;
     ctx_claim = 0;
@@ -83,6 +84,7 @@ void PLIC::postinitService() {
     }
 
     RegMemBankGeneric::postinitService();
+    notifyListeners();
 }
 
 int PLIC::requestInterrupt(IFace *isrc, int idx) {
@@ -137,6 +139,35 @@ int PLIC::getPendingRequest(int ctxid) {
     return irqidx;
 }
 
+bool PLIC::registerIrqListener(int ctxid, IIrqListener *ilstn, int line) {
+    AttributeType &item = irqListeners_.new_list_item();
+    item.make_list(3);
+    item[0u].make_int64(ctxid);
+    item[1].make_iface(ilstn);
+    item[2].make_int64(line);
+    if (ctx_enable) {
+        notifyListeners();
+    }
+    return true;
+}
+
+/** Called on any change of pending, enable or priority registers */
+void PLIC::notifyListeners() {
+    if (!ctx_enable) {
+        return;
+    }
+    for (unsigned i = 0; i < irqListeners_.size(); i++) {
+        AttributeType &item = irqListeners_[i];
+        int ctxid = item[0u].to_int();
+        if (ctxid >= static_cast<int>(contextList_.size())) {
+            continue;
+        }
+        IIrqListener *ilstn = static_cast<IIrqListener *>(item[1].to_iface());
+        ilstn->setIrqLine(item[2].to_int(),
+                          getPendingRequest(ctxid) != IRQ_REQUEST_NONE);
+    }
+}
+
 bool PLIC::isEnabled(uint32_t irqidx) {
     // Check bits [2:0]
     // A priority value of 0 is
@@ -182,6 +213,7 @@ void PLIC::setPendingBit(int idx) {
     if (add) {
         pendingList_.new_list_item().make_int64(idx);
     }
+    notifyListeners();
     RISCV_info("request Interrupt %d", idx);
 }
 
@@ -196,6 +228,7 @@ void PLIC::clearPendingBit(int idx) {
             break;
         }
     }
+    notifyListeners();
 }
 
 void PLIC::enableInterrupt(uint32_t ctxid, int idx) {
@@ -230,6 +263,14 @@ void PLIC::PLIC_ENABLE_TYPE::write(int idx, uint32_t val) {
             p->enableInterrupt(contextid_, 32*idx + i);
         }
     }
+    p->notifyListeners();
+}
+
+uint32_t PLIC::PLIC_CONTEXT_PRIOIRTY_TYPE::aboutToWrite(uint32_t nxt_val) {
+    PLIC *p = static_cast<PLIC *>(parent_);
+    value_.val = nxt_val;
+    p->notifyListeners();
+    return nxt_val;
 }
 
 uint32_t PLIC::PLIC_CLAIM_COMPLETE_TYPE::aboutToRead(uint32_t prv_val) {
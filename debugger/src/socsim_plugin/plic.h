@@ -39,6 +39,8 @@ class PLIC : public RegMemBankGeneric,
     /** IIrqController */
     virtual int requestInterrupt(IFace *isrc, int idx);
     virtual int getPendingRequest(int ctxid);
+    virtual bool registerIrqListener(int ctxid, IIrqListener *ilstn,
+                                     int line);
 
     /** Controller specific methods visible for ports */
     void enableInterrupt(uint32_t ctxid, int idx);
@@ -51,6 +53,7 @@ class PLIC : public RegMemBankGeneric,
  private:
     bool isEnabled(uint32_t irqidx);
     bool isUnmasked(uint32_t ctxid, uint32_t irqidx);
+    void notifyListeners();
 
  private:
 
@@ -72,6 +75,7 @@ class PLIC : public RegMemBankGeneric,
 
         virtual void write(int idx, uint32_t val) override {
             GenericReg32Bank::write(idx, val & 0x7);
+            static_cast<PLIC *>(parent_)->notifyListeners();
         }
     };
 
@@ -83,6 +87,8 @@ class PLIC : public RegMemBankGeneric,
         }
 
         uint32_t getContextPrioiry() { return getValue().val & 0x7; }
+     protected:
+        virtual uint32_t aboutToWrite(uint32_t nxt_val) override;
      protected:
         unsigned contextid_;
     };
@@ -103,6 +109,7 @@ class PLIC : public RegMemBankGeneric,
 
     AttributeType contextList_;     // List of context names: [MCore0, MCore1, SCore1, MCore2, ...]
     AttributeType pendingList_;     // requested interrupt packed into attribute for better performance
+    AttributeType irqListeners_;    // [[ctxid, IIrqListener, line], *]
 
     PLIC_SRC_PRIORITY_TYPE src_priority;            // [000000..000FFC] 0 doens't exists, 1..1023
     GenericReg32Bank pending;                       // [001000..00107C] 0..1023 1 bit per interrupt
@@ -17,10 +17,10 @@
 #include "api_core.h"
 #include "uart.h"
 
-#define FAST_UART_SIM
-
 namespace debugger {
 
+static const unsigned HOST_TX_RING_SIZE = 1 << 16;
+
 UART::UART(const char *name) : RegMemBankGeneric(name),
     txdata_(static_cast<IService *>(this), "txdata", 0x00),
     rxdata_(static_cast<IService *>(this), "rxdata", 0x04),
@@ -38,24 +38,60 @@ UART::UART(const char *name) : RegMemBankGeneric(name),
     registerAttribute("IrqIdTx", &irqidtx_);
     registerAttribute("Clock", &clock_);
     registerAttribute("CmdExecutor", &cmdexec_);
+    registerAttribute("BaudTiming", &baudTiming_);
+    registerAttribute("TxBatchSize", &txBatchSize_);
+    registerAttribute("TxFlushSteps", &txFlushSteps_);
+    registerAttribute("RxBufferSize", &rxBufferSize_);
+    registerAttribute("HostBackend", &hostBackend_);
+    registerAttribute("HostTcpPort", &hostTcpPort_);
+
+    baudTiming_.make_string("Fast");
+    txBatchSize_.make_int64(4096);
+    txFlushSteps_.make_uint64(100000);
+    rxBufferSize_.make_int64(65536);
+    hostBackend_.make_string("");
+    hostTcpPort_.make_int64(0);
 
     listeners_.make_list(0);
     RISCV_mutex_init(&mutexListeners_);
+    RISCV_mutex_init(&mutexRx_);
 
+    iclk_ = 0;
+    iirq_ = 0;
+    icmdexec_ = 0;
     rxfifo_ = 0;
     rx_total_ = 0;
+    rxstage_ = 0;
     pcmd_ = 0;
 
     tx_total_ = 0;
     tx_wcnt_ = 0;
     t_cb_cnt_ = 0;
+    baudAccurate_ = false;
+    txbuf_ = 0;
+    txcnt_ = 0;
+    txsize_ = 0;
+    tx_flush_t_ = 0;
+    cb_armed_ = false;
+    cb_time_ = 0;
+    host_ = 0;
 }
 
 UART::~UART() {
+    if (host_) {
+        delete host_;
+    }
     RISCV_mutex_destroy(&mutexListeners_);
+    RISCV_mutex_destroy(&mutexRx_);
     if (rxfifo_) {
         delete [] rxfifo_;
     }
+    if (rxstage_) {
+        delete rxstage_;
+    }
+    if (txbuf_) {
+        delete [] txbuf_;
+    }
     if (pcmd_) {
         delete pcmd_;
     }
@@ -67,6 +103,11 @@ void UART::postinitService() {
     rxfifo_ = new char[fifoSize_.to_int()];
     p_rx_wr_ = rxfifo_;
     p_rx_rd_ = rxfifo_;
+    rxstage_ = new ByteRingType(rxBufferSize_.to_uint32());
+
+    baudAccurate_ = baudTiming_.is_equal("Accurate");
+    txsize_ = txBatchSize_.to_int() > 0 ? txBatchSize_.to_int() : 1;
+    txbuf_ = new char[txsize_ + 1];
 
     iirq_ = static_cast<IIrqController *>(
         RISCV_get_service_iface(irqctrl_.to_string(),
@@ -96,44 +137,80 @@ void UART::postinitService() {
                                 getObjName());
         icmdexec_->registerCommand(pcmd_);
     }
+
+    if (hostBackend_.size()) {
+        host_ = new UartHostPort(static_cast<IService *>(this),
+                                 HOST_TX_RING_SIZE);
+        bool opened = false;
+        if (hostBackend_.is_equal("pty")) {
+            opened = host_->openPty();
+        } else if (hostBackend_.is_equal("tcp")) {
+            opened = host_->openTcp(hostTcpPort_.to_int());
+        } else {
+            RISCV_error("Unknown host backend '%s'",
+                        hostBackend_.to_string());
+        }
+        if (!opened) {
+            delete host_;
+            host_ = 0;
+        }
+    }
 }
 
 void UART::predeleteService() {
+    if (iclk_) {
+        flushTx();
+    }
+    if (host_) {
+        host_->close();
+    }
     if (icmdexec_) {
         icmdexec_->unregisterCommand(pcmd_);
     }
 }
 
 uint32_t UART::getScaler() {
-#ifdef FAST_UART_SIM
-    return 100;
-#else
-    return 2*scaler_.getValue().val;
-#endif
+    if (!baudAccurate_) {
+        return 100;
+    }
+    uint32_t ret = 2*scaler_.getValue().val;
+    return ret ? ret : 1;
 }
 
+/** Input of any thread is staged and moved into FIFO when there's space */
 int UART::writeData(const char *buf, int sz) {
     if (rxfifo_ == 0) {
         return 0;
     }
-    if (static_cast<uint32_t>(sz) > 
-        (fifoSize_.to_uint32() - rx_total_)) {
-        sz = (fifoSize_.to_uint32() - rx_total_);
+    RISCV_mutex_lock(&mutexRx_);
+    int ret = static_cast<int>(rxstage_->put(buf, static_cast<unsigned>(sz)));
+    if (!baudAccurate_) {
+        fillRxFifo(fifoSize_.to_int());
+    } else if (ret) {
+        armCallback(iclk_->getStepCounter() + getScaler());
     }
-    for (int i = 0; i < sz; i++) {
+    RISCV_mutex_unlock(&mutexRx_);
+    return ret;
+}
+
+void UART::fillRxFifo(int maxcnt) {
+    int cnt = 0;
+    char v;
+    while (cnt < maxcnt && rx_total_ < fifoSize_.to_uint32()
+        && rxstage_->get(&v, 1)) {
         rx_total_++;
-        *p_rx_wr_ = buf[i];
+        *p_rx_wr_ = v;
         if ((++p_rx_wr_) >= (rxfifo_ + fifoSize_.to_int())) {
             p_rx_wr_ = rxfifo_;
         }
+        cnt++;
     }
 
-    if (ie_.getTyped().b.rxwm
+    if (cnt && ie_.getTyped().b.rxwm
         && rx_total_ > rxctrl_.getTyped().b.rxcnt) {
         iirq_->requestInterrupt(static_cast<IService *>(this),
                               irqidrx_.to_int());
     }
-    return sz;
 }
 
 void UART::registerRawListener(IFace *listener) {
@@ -166,61 +243,118 @@ int UART::openPort(const char *port, AttributeType settings) {
 void UART::closePort() {
 }
 
+/** The only callback serves TX shifting, RX pacing and the batch timeout */
 void UART::stepCallback(uint64_t t) {
     bool sent = false;
+    RISCV_mutex_lock(&mutexRx_);
+    cb_armed_ = false;
+    if (baudAccurate_) {
+        fillRxFifo(1);
+        if (rxstage_->count() && rx_total_ < fifoSize_.to_uint32()) {
+            armCallback(t + getScaler());
+        }
+    }
+    RISCV_mutex_unlock(&mutexRx_);
+
     if (tx_total_) {
-        sent = true;
+        pushTx(tx_fifo_[(tx_wcnt_ + FIFOSZ - tx_total_) % FIFOSZ]);
         tx_total_--;
+        sent = true;
+        if (tx_total_) {
+            armCallback(t + getScaler());
+        }
+    }
+
+    if (txcnt_) {
+        if (t >= tx_flush_t_) {
+            flushTx();
+        } else {
+            armCallback(tx_flush_t_);
+        }
     }
 
     if (sent && ie_.getTyped().b.txwm
         && tx_total_ < txctrl_.getTyped().b.txcnt) {
         iirq_->requestInterrupt(static_cast<IService*>(this),
                                 irqidtx_.to_int());
-    } else {
-        iclk_->moveStepCallback(static_cast<IClockListener *>(this),
-                                t + getScaler());
     }
 }
 
+/** Host and CPU threads both arm the callback, mutex is recursive */
+void UART::armCallback(uint64_t t) {
+    RISCV_mutex_lock(&mutexRx_);
+    if (!cb_armed_ || t < cb_time_) {
+        cb_armed_ = true;
+        cb_time_ = t;
+        iclk_->moveStepCallback(static_cast<IClockListener *>(this), t);
+    }
+    RISCV_mutex_unlock(&mutexRx_);
+}
+
+/** Fast timing skips FIFO, accurate one shifts a byte per baud period */
 void UART::putByte(char v) {
-    char tbuf[2] = {v};
-    uint64_t t = iclk_->getStepCounter();
-    RISCV_info("[%" RV_PRI64 "d]Set data = %s", t, tbuf);
+    if (!baudAccurate_) {
+        pushTx(v);
+        return;
+    }
+    if (tx_total_ < FIFOSZ) {
+        tx_fifo_[tx_wcnt_] = v;
+        tx_wcnt_ = (tx_wcnt_ + 1) % FIFOSZ;
+        tx_total_++;
+    }
+    armCallback(iclk_->getStepCounter() + getScaler());
+}
+
+void UART::pushTx(char v) {
+    if (txcnt_ == 0) {
+        tx_flush_t_ = iclk_->getStepCounter() + txFlushSteps_.to_uint64();
+        armCallback(tx_flush_t_);
+    }
+    txbuf_[txcnt_++] = v;
+    if (v == '\n' || txcnt_ >= txsize_) {
+        flushTx();
+    }
+}
+
+void UART::flushTx() {
+    if (txcnt_ == 0) {
+        return;
+    }
+    txbuf_[txcnt_] = '\0';
+    RISCV_info("[%" RV_PRI64 "d]Set data = %s",
+               iclk_->getStepCounter(), txbuf_);
 
     RISCV_mutex_lock(&mutexListeners_);
     for (unsigned n = 0; n < listeners_.size(); n++) {
         IRawListener *lstn = static_cast<IRawListener *>(
                             listeners_[n].to_iface());
 
-        lstn->updateData(&v, 1);
+        lstn->updateData(txbuf_, txcnt_);
     }
     RISCV_mutex_unlock(&mutexListeners_);
 
-#if 0
-    // temporary disabled it but physically correct. Implement big enough UART buffer to compare with simulation
-    if (tx_total_ < FIFOSZ) {
-        tx_fifo_[tx_wcnt_] = v;
-        tx_wcnt_ = (tx_wcnt_ + 1) % FIFOSZ;
-        tx_total_++;
+    if (host_) {
+        host_->write(txbuf_, txcnt_);
     }
-
-    iclk_->moveStepCallback(static_cast<IClockListener *>(this),
-                            t + getScaler());
-#endif
+    txcnt_ = 0;
 }
 
 char UART::getByte() {
     char ret = 0;
-    if (rx_total_ == 0) {
-        return ret;
-    } else {
+    RISCV_mutex_lock(&mutexRx_);
+    if (rx_total_ != 0) {
         ret = *p_rx_rd_;
         rx_total_--;
         if ((++p_rx_rd_) >= (rxfifo_ + fifoSize_.to_int())) {
             p_rx_rd_ = rxfifo_;
         }
+        if (!baudAccurate_) {
+            fillRxFifo(fifoSize_.to_int());
+        } else if (rxstage_->count()) {
+            armCallback(iclk_->getStepCounter() + getScaler());
+        }
     }
+    RISCV_mutex_unlock(&mutexRx_);
     return ret;
 }
 
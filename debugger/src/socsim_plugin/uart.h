@@ -28,6 +28,7 @@
 #include "coreservices/icmdexec.h"
 #include "generic/mapreg.h"
 #include "generic/rmembank_gen1.h"
+#include "uart_host.h"
 
 namespace debugger {
 
@@ -101,6 +102,12 @@ class UART : public RegMemBankGeneric,
     void putByte(char v);
     char getByte();
 
+ protected:
+    void armCallback(uint64_t t);
+    void pushTx(char v);
+    void flushTx();
+    void fillRxFifo(int maxcnt);
+
  protected:
     class TXCTRL_TYPE : public MappedReg32Type {
      public:
@@ -230,6 +237,12 @@ class UART : public RegMemBankGeneric,
     AttributeType irqidtx_;
     AttributeType clock_;
     AttributeType cmdexec_;
+    AttributeType baudTiming_;
+    AttributeType txBatchSize_;
+    AttributeType txFlushSteps_;
+    AttributeType rxBufferSize_;
+    AttributeType hostBackend_;
+    AttributeType hostTcpPort_;
     AttributeType listeners_;  // non-registering attribute
 
     ICmdExecutor *icmdexec_;
@@ -240,12 +253,23 @@ class UART : public RegMemBankGeneric,
     char *p_rx_wr_;
     char *p_rx_rd_;
     uint32_t rx_total_;
+    ByteRingType *rxstage_;     // bulk input waiting for free FIFO space
+    mutex_def mutexRx_;
 
     static const int FIFOSZ = 15;
     char tx_fifo_[FIFOSZ];
     uint32_t tx_wcnt_;
     uint32_t tx_total_;
 
+    bool baudAccurate_;
+    char *txbuf_;               // batch delivered to listeners and host
+    int txcnt_;
+    int txsize_;
+    uint64_t tx_flush_t_;
+    bool cb_armed_;             // guarded by mutexRx_
+    uint64_t cb_time_;
+    UartHostPort *host_;
+
     mutex_def mutexListeners_;
     UartCmdType *pcmd_;
 
@@ -0,0 +1,295 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "uart_host.h"
+
+namespace debugger {
+
+// Disconnected client shouldn't terminate simulator with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+ByteRingType::ByteRingType(unsigned sz) {
+    unsigned t = 16;
+    while (t < sz) {
+        t <<= 1;
+    }
+    buf_ = new char[t];
+    mask_ = t - 1;
+    wr_ = 0;
+    rd_ = 0;
+}
+
+ByteRingType::~ByteRingType() {
+    delete [] buf_;
+}
+
+unsigned ByteRingType::put(const char *buf, unsigned sz) {
+    unsigned wr = wr_;
+    if (sz > space()) {
+        sz = space();
+    }
+    for (unsigned i = 0; i < sz; i++) {
+        buf_[(wr + i) & mask_] = buf[i];
+    }
+    RISCV_memory_barrier();
+    wr_ = wr + sz;
+    return sz;
+}
+
+unsigned ByteRingType::peek(const char **pbuf) {
+    unsigned rd = rd_;
+    unsigned total = wr_ - rd;
+    unsigned tail = mask_ + 1 - (rd & mask_);
+    RISCV_memory_barrier();
+    *pbuf = &buf_[rd & mask_];
+    return total < tail ? total : tail;
+}
+
+void ByteRingType::consume(unsigned sz) {
+    RISCV_memory_barrier();
+    rd_ = rd_ + sz;
+}
+
+unsigned ByteRingType::get(char *buf, unsigned sz) {
+    unsigned rd = rd_;
+    if (sz > count()) {
+        sz = count();
+    }
+    RISCV_memory_barrier();
+    for (unsigned i = 0; i < sz; i++) {
+        buf[i] = buf_[(rd + i) & mask_];
+    }
+    consume(sz);
+    return sz;
+}
+
+
+UartHostPort::UartHostPort(IService *parent, unsigned bufsz)
+    : tx_(bufsz) {
+    parent_ = parent;
+    iserial_ = static_cast<ISerial *>(parent->getInterface(IFACE_SERIAL));
+    ptyfd_ = -1;
+    hsock_ = -1;
+    client_ = -1;
+    isTcp_ = false;
+}
+
+UartHostPort::~UartHostPort() {
+    close();
+}
+
+bool UartHostPort::openPty() {
+#if defined(_WIN32) || defined(__CYGWIN__)
+    RISCV_printf(parent_, LOG_ERROR, "%s",
+                 "Pseudo-terminal isn't supported, use tcp backend");
+    return false;
+#else
+    ptyfd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if (ptyfd_ < 0 || grantpt(ptyfd_) != 0 || unlockpt(ptyfd_) != 0) {
+        RISCV_printf(parent_, LOG_ERROR, "%s", "Can't create pseudo-terminal");
+        close();
+        return false;
+    }
+    struct termios tio;
+    if (tcgetattr(ptyfd_, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(ptyfd_, TCSANOW, &tio);
+    }
+    fcntl(ptyfd_, F_SETFL, fcntl(ptyfd_, F_GETFL, 0) | O_NONBLOCK);
+    RISCV_printf(parent_, LOG_IMPORTANT, "Connected to %s", ptsname(ptyfd_));
+    isTcp_ = false;
+    return run();
+#endif
+}
+
+bool UartHostPort::openTcp(int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+
+    hsock_ = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (hsock_ < 0) {
+        RISCV_printf(parent_, LOG_ERROR, "%s", "Can't create socket");
+        return false;
+    }
+    int enable = 1;
+    setsockopt(hsock_, SOL_SOCKET, SO_REUSEADDR,
+               reinterpret_cast<const char *>(&enable), sizeof(int));
+    if (bind(hsock_, reinterpret_cast<struct sockaddr *>(&addr),
+             sizeof(addr)) != 0 || listen(hsock_, 1) != 0) {
+        RISCV_printf(parent_, LOG_ERROR, "Can't listen port %d", port);
+        close();
+        return false;
+    }
+    RISCV_printf(parent_, LOG_IMPORTANT, "Listening 127.0.0.1:%d", port);
+    isTcp_ = true;
+    return run();
+}
+
+void UartHostPort::close() {
+    stop();
+    closeClient();
+    if (hsock_ >= 0) {
+#if defined(_WIN32) || defined(__CYGWIN__)
+        closesocket(hsock_);
+#else
+        ::close(hsock_);
+#endif
+        hsock_ = -1;
+    }
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+    if (ptyfd_ >= 0) {
+        ::close(ptyfd_);
+        ptyfd_ = -1;
+    }
+#endif
+}
+
+void UartHostPort::write(const char *buf, int sz) {
+    // Output is lost while the host side doesn't read it
+    tx_.put(buf, static_cast<unsigned>(sz));
+}
+
+bool UartHostPort::acceptClient() {
+    fd_set readSet;
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 20000;
+    FD_ZERO(&readSet);
+    FD_SET(hsock_, &readSet);
+    if (select(static_cast<int>(hsock_) + 1, &readSet, 0, 0, &tv) <= 0) {
+        return false;
+    }
+    client_ = accept(hsock_, 0, 0);
+    if (client_ < 0) {
+        return false;
+    }
+    RISCV_printf(parent_, LOG_INFO, "%s", "Client connected");
+    return true;
+}
+
+void UartHostPort::closeClient() {
+    if (client_ < 0) {
+        return;
+    }
+#if defined(_WIN32) || defined(__CYGWIN__)
+    closesocket(client_);
+#else
+    ::close(client_);
+#endif
+    client_ = -1;
+}
+
+/** Returns 0 when no data, negative value when the peer is lost */
+int UartHostPort::readHost(char *buf, int sz) {
+    fd_set readSet;
+    timeval tv;
+    int fd = isTcp_ ? static_cast<int>(client_) : ptyfd_;
+    tv.tv_sec = 0;
+    tv.tv_usec = tx_.count() ? 0 : 20000;
+    FD_ZERO(&readSet);
+    FD_SET(fd, &readSet);
+    if (select(fd + 1, &readSet, 0, 0, &tv) <= 0) {
+        return 0;
+    }
+    int ret;
+    if (isTcp_) {
+        ret = recv(client_, buf, sz, 0);
+        return ret > 0 ? ret : -1;
+    }
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+    ret = static_cast<int>(::read(ptyfd_, buf, sz));
+    if (ret < 0 && errno == EIO) {
+        // slave side isn't opened yet
+        RISCV_sleep_ms(20);
+        return 0;
+    }
+    return ret > 0 ? ret : 0;
+#else
+    return 0;
+#endif
+}
+
+int UartHostPort::writeHost(const char *buf, int sz) {
+    int ret;
+    if (isTcp_) {
+        ret = send(client_, buf, sz, SEND_FLAGS);
+        return ret >= 0 ? ret : -1;
+    }
+#if !defined(_WIN32) && !defined(__CYGWIN__)
+    ret = static_cast<int>(::write(ptyfd_, buf, sz));
+    return ret >= 0 ? ret : 0;
+#else
+    return 0;
+#endif
+}
+
+void UartHostPort::busyLoop() {
+    char rxbuf[4096];
+    int rxcnt = 0;
+    int rxpos = 0;
+    const char *pout;
+
+    while (isEnabled()) {
+        if (isTcp_ && client_ < 0) {
+            // Output is kept in the ring until the client is connected
+            acceptClient();
+            continue;
+        }
+
+        unsigned sz = tx_.peek(&pout);
+        if (sz) {
+            int ret = writeHost(pout, static_cast<int>(sz));
+            if (ret < 0) {
+                closeClient();
+                continue;
+            }
+            tx_.consume(static_cast<unsigned>(ret));
+            if (ret == 0) {
+                RISCV_sleep_ms(1);
+            }
+        }
+
+        // Keep not accepted input until UART has free space
+        if (rxpos == rxcnt) {
+            rxpos = 0;
+            rxcnt = readHost(rxbuf, sizeof(rxbuf));
+            if (rxcnt < 0) {
+                RISCV_printf(parent_, LOG_INFO, "%s", "Client disconnected");
+                rxcnt = 0;
+                closeClient();
+                continue;
+            }
+        }
+        if (rxpos < rxcnt) {
+            int ret = iserial_->writeData(&rxbuf[rxpos], rxcnt - rxpos);
+            rxpos += ret;
+            if (ret == 0) {
+                RISCV_sleep_ms(1);
+            }
+        }
+    }
+}
+
+}  // namespace debugger
@@ -0,0 +1,89 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Host side of the simulated UART: pseudo-terminal or TCP
+ *             socket served by the own thread. Simulation thread never
+ *             blocks on the host I/O, it only puts data into the ring.
+ */
+
+#ifndef __DEBUGGER_SOCSIM_PLUGIN_UART_HOST_H__
+#define __DEBUGGER_SOCSIM_PLUGIN_UART_HOST_H__
+
+#include "api_core.h"
+#include "iservice.h"
+#include "coreservices/ithread.h"
+#include "coreservices/iserial.h"
+
+namespace debugger {
+
+/** Single producer single consumer byte ring */
+class ByteRingType {
+ public:
+    explicit ByteRingType(unsigned sz);
+    ~ByteRingType();
+
+    /** Producer side. Returns number of stored bytes */
+    unsigned put(const char *buf, unsigned sz);
+    /** Consumer side: contiguous part of the stored data */
+    unsigned peek(const char **pbuf);
+    void consume(unsigned sz);
+    unsigned get(char *buf, unsigned sz);
+    unsigned count() { return wr_ - rd_; }
+    unsigned space() { return mask_ + 1 - count(); }
+
+ private:
+    char *buf_;
+    unsigned mask_;
+    volatile unsigned wr_;
+    volatile unsigned rd_;
+};
+
+class UartHostPort : public IThread {
+ public:
+    UartHostPort(IService *parent, unsigned bufsz);
+    virtual ~UartHostPort();
+
+    /** Creates /dev/pts/N device, its name is printed into the log */
+    bool openPty();
+    /** Listen 127.0.0.1:port, one client at a time */
+    bool openTcp(int port);
+    void close();
+
+    /** Called from the simulation thread, never blocks */
+    void write(const char *buf, int sz);
+
+ protected:
+    /** IThread interface */
+    virtual void busyLoop() override;
+
+ private:
+    bool acceptClient();
+    int readHost(char *buf, int sz);
+    int writeHost(const char *buf, int sz);
+    void closeClient();
+
+ private:
+    IService *parent_;
+    ISerial *iserial_;              // received bytes are passed to writeData()
+    ByteRingType tx_;
+    int ptyfd_;
+    socket_def hsock_;
+    socket_def client_;
+    bool isTcp_;
+};
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_SOCSIM_PLUGIN_UART_HOST_H__
@@ -0,0 +1,108 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Converts binary trace generated with 'TraceFormat' = "Binary"
+ *             into the text format:
+ *                 trdecoder [-pc start:end] [-o file] trace.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generic/trace_bin.h"
+#include "trace_render.h"
+
+using namespace debugger;
+
+static void usage() {
+    printf("Usage: trdecoder [-pc start:end] [-o file] trace.bin\n");
+    printf("    -pc start:end    output only instructions with "
+           "start <= pc <= end\n");
+    printf("    -o file          output file name, stdout by default\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char *inname = 0;
+    const char *outname = 0;
+    uint64_t pcmin = 0;
+    uint64_t pcmax = ~0ull;
+    char *end;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-pc") == 0 && i + 1 < argc) {
+            pcmin = strtoull(argv[++i], &end, 0);
+            if (*end != ':') {
+                usage();
+                return 1;
+            }
+            pcmax = strtoull(end + 1, &end, 0);
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            outname = argv[++i];
+        } else if (argv[i][0] != '-' && !inname) {
+            inname = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (!inname) {
+        usage();
+        return 1;
+    }
+
+    BinTraceReader reader;
+    if (!reader.open(inname)) {
+        fprintf(stderr, "Can't open binary trace %s\n", inname);
+        return 1;
+    }
+
+    void (*render)(FILE *, const BinTraceRecordType *);
+    switch (reader.getIsa()) {
+    case BinTraceIsa_RiscV:
+        render = render_riscv;
+        break;
+    case BinTraceIsa_Thumb:
+        render = render_thumb;
+        break;
+    default:
+        render = render_generic;
+    }
+
+    FILE *fout = stdout;
+    if (outname) {
+        fout = fopen(outname, "wb");
+        if (!fout) {
+            fprintf(stderr, "Can't create %s\n", outname);
+            return 1;
+        }
+    }
+
+    BinTraceRecordType *r = new BinTraceRecordType;
+    while (reader.read(r)) {
+        if (r->pc >= pcmin && r->pc <= pcmax) {
+            render(fout, r);
+        }
+    }
+    delete r;
+
+    if (fout != stdout) {
+        fclose(fout);
+    }
+    if (reader.isTruncated()) {
+        fprintf(stderr, "Trace is truncated\n");
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <api_types.h>
+#include <riscv-isa.h>
+#include "generic/riscv_disasm.h"
+#include "trace_render.h"
+
+namespace debugger {
+
+static const unsigned IREGS_TOTAL = sizeof(IREGS_NAMES) / sizeof(char *);
+
+static void render_actions(FILE *f, const BinTraceRecordType *r) {
+    for (int i = 0; i < r->actioncnt; i++) {
+        const BinTraceActionType *p = &r->action[i];
+        if (p->type == BinTraceAction_Reg) {
+            if (p->regidx < IREGS_TOTAL) {
+                fprintf(f, "%20s %10s <= %016" RV_PRI64 "x\r\n",
+                        "", IREGS_NAMES[p->regidx], p->data);
+            } else {
+                fprintf(f, "%20s %10d <= %016" RV_PRI64 "x\r\n",
+                        "", p->regidx, p->data);
+            }
+        } else if (p->type == BinTraceAction_MemWrite) {
+            fprintf(f, "%20s [%08" RV_PRI64 "x] <= %016" RV_PRI64 "x\r\n",
+                    "", p->addr, p->data);
+        } else {
+            fprintf(f, "%20s [%08" RV_PRI64 "x] => %016" RV_PRI64 "x\r\n",
+                    "", p->addr, p->data);
+        }
+    }
+}
+
+void render_riscv(FILE *f, const BinTraceRecordType *r) {
+    char disasm[256];
+    riscv_disassembler(r->instr, disasm, sizeof(disasm));
+    fprintf(f, "%9" RV_PRI64 "d: %08" RV_PRI64 "x: %s \r\n",
+            r->step, r->pc, disasm);
+    render_actions(f, r);
+}
+
+void render_generic(FILE *f, const BinTraceRecordType *r) {
+    fprintf(f, "%9" RV_PRI64 "d: %08" RV_PRI64 "x: %08x \r\n",
+            r->step, r->pc, r->instr);
+    render_actions(f, r);
+}
+
+}  // namespace debugger
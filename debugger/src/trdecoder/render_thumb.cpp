@@ -0,0 +1,53 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+#include <api_types.h>
+#include "cpu_arm_plugin/srcproc/thumb_disasm.h"
+#include "trace_render.h"
+
+namespace debugger {
+
+static const unsigned IREGS_TOTAL = sizeof(IREGS_NAMES) / sizeof(char *);
+
+/** Cortex model prints step counter of the previous step and 32-bits data */
+void render_thumb(FILE *f, const BinTraceRecordType *r) {
+    char disasm[256];
+    disasm_thumb(r->pc, r->instr, disasm, sizeof(disasm));
+    fprintf(f, "%9" RV_PRI64 "d: %08" RV_PRI64 "x: %s \n",
+            r->step - 1, r->pc, disasm);
+
+    for (int i = 0; i < r->actioncnt; i++) {
+        const BinTraceActionType *p = &r->action[i];
+        if (p->type == BinTraceAction_Reg) {
+            if (p->regidx < IREGS_TOTAL) {
+                fprintf(f, "%21s %10s <= %08x\n",
+                        "", IREGS_NAMES[p->regidx],
+                        static_cast<uint32_t>(p->data));
+            } else {
+                fprintf(f, "%21s %10d <= %08x\n",
+                        "", p->regidx, static_cast<uint32_t>(p->data));
+            }
+        } else if (p->type == BinTraceAction_MemWrite) {
+            fprintf(f, "%21s [%08" RV_PRI64 "x] <= %08x\n",
+                    "", p->addr, static_cast<uint32_t>(p->data));
+        } else {
+            fprintf(f, "%21s [%08" RV_PRI64 "x] => %08x\n",
+                    "", p->addr, static_cast<uint32_t>(p->data));
+        }
+    }
+}
+
+}  // namespace debugger
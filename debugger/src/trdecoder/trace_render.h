@@ -0,0 +1,34 @@
+/*
+ *  Copyright 2018 Sergey Khabarov, sergeykhbr@gmail.com
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ * @details    Renders binary trace records into the same text format as
+ *             the functional models write when 'TraceFormat' = "Text".
+ */
+
+#ifndef __DEBUGGER_TRDECODER_TRACE_RENDER_H__
+#define __DEBUGGER_TRDECODER_TRACE_RENDER_H__
+
+#include <stdio.h>
+#include "generic/trace_bin.h"
+
+namespace debugger {
+
+void render_riscv(FILE *f, const BinTraceRecordType *r);
+void render_thumb(FILE *f, const BinTraceRecordType *r);
+void render_generic(FILE *f, const BinTraceRecordType *r);
+
+}  // namespace debugger
+
+#endif  // __DEBUGGER_TRDECODER_TRACE_RENDER_H__